@@ -0,0 +1,82 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-22
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/include/approximate_iou.h
+ */
+#pragma once
+#include <vector>
+
+#include "polygon2d.h"
+#include "vec2d.h"
+
+namespace innovusion {
+namespace geometry {
+
+struct ApproximateIouResult {
+  // estimated iou in [0, 1]
+  double iou = 0.0;
+  // guaranteed bound of |iou - exact iou|
+  double error = 0.0;
+  // true if threshold lies within [iou - error, iou + error]
+  bool ambiguous = false;
+};
+
+/***
+ * @description: Approximate iou by scanline integration of the intersection
+ * width on a fixed lattice of rows. Rows are laid in the frame of the first
+ * polygon when it is a Box, so the box edges never contribute to the error.
+ * The error bound follows from the midpoint rule: the integration error of a
+ * row is at most its height times the lateral extent of the edges crossing it.
+ * @remark Keeps scratch buffers, use one instance per thread
+ */
+class ApproximateIou {
+ public:
+  /***
+   * @param error    requested bound on |iou - exact iou|
+   * @param max_rows lattice rows cap, the reported error grows if reached
+   */
+  explicit ApproximateIou(double error = 0.02, size_t max_rows = 256);
+  virtual ~ApproximateIou() = default;
+
+  /***
+   * @description: Estimate iou of two polygons
+   * @param threshold decision threshold used to flag ambiguous results
+   */
+  NODISCARD ApproximateIouResult estimate(const Polygon2d& first,
+                                          const Polygon2d& second,
+                                          double threshold = 0.0);
+
+  /***
+   * @description: Decide iou >= threshold, falls back to the exact overlay
+   * only when the estimate is ambiguous
+   */
+  NODISCARD bool iouAtLeast(const PolygonPtr& first, const PolygonPtr& second,
+                            double threshold);
+
+  NODISCARD inline double error() const { return error_; }
+
+ private:
+  struct Edge {
+    Vec2d from;
+    Vec2d to;
+  };
+  void loadEdges(const Polygon2d& polygon, const Vec2d& axis,
+                 std::vector<Edge>* edges, GBox* envelope) const;
+  void crossings(const std::vector<Edge>& edges, double z,
+                 std::vector<double>* values) const;
+  NODISCARD double lateralExtent(const std::vector<Edge>& edges, double low,
+                                 double high) const;
+  NODISCARD double overlapLength(const std::vector<double>& first,
+                                 const std::vector<double>& second) const;
+
+  double error_;
+  size_t max_rows_;
+  std::vector<Edge> first_edges_;
+  std::vector<Edge> second_edges_;
+  std::vector<double> first_crossings_;
+  std::vector<double> second_crossings_;
+};
+
+}  // namespace geometry
+}  // namespace innovusion
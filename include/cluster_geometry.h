@@ -0,0 +1,54 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-27
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/include/cluster_geometry.h
+ */
+#pragma once
+#include <cstdint>
+#include <span>
+
+#include "vec2d.h"
+
+namespace innovusion {
+namespace geometry {
+
+/***
+ * @description: Box parameters in Box2d convention
+ */
+struct BoxParameters {
+  Vec2d center;
+  // along the heading
+  double length = 0.0;
+  double width = 0.0;
+  // in 0.01 degree, 0 for z axis, clockwise
+  uint32_t spindle = 0;
+};
+
+/***
+ * @description: Monotone chain convex hull, no allocation
+ * @param points cluster points, sorted in place
+ * @param hull   caller buffer of at least points.size() + 1 points
+ * @return number of hull points written, open ring in clockwise order (as
+ * GPolygon), collinear points are dropped. 0 if hull buffer is too small.
+ */
+NODISCARD size_t convexHull(std::span<Vec2d> points, std::span<Vec2d> hull);
+
+/***
+ * @description: Rotating calipers minimum area rectangle of a convex hull
+ * @param hull open clockwise convex ring, as returned by convexHull
+ * @param box  length is the longer side, spindle in [0, 18000)
+ * @return false if hull is empty
+ */
+NODISCARD bool minimumAreaBox(std::span<const Vec2d> hull, BoxParameters* box);
+
+/***
+ * @description: convexHull followed by minimumAreaBox
+ * @param points cluster points, sorted in place
+ * @param buffer caller buffer of at least points.size() + 1 points
+ */
+NODISCARD bool fitBox(std::span<Vec2d> points, std::span<Vec2d> buffer,
+                      BoxParameters* box);
+
+}  // namespace geometry
+}  // namespace innovusion
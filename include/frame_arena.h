@@ -0,0 +1,122 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-25
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/include/frame_arena.h
+ */
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+#include "polygon2d.h"
+#include "vec2d.h"
+
+namespace innovusion {
+namespace geometry {
+
+class FrameArena;
+
+/***
+ * @description: Non-owning box whose closed clockwise ring lives in a
+ * FrameArena. Trivially copyable, valid until the arena is reset.
+ */
+class FrameBox {
+ public:
+  FrameBox() = default;
+  explicit FrameBox(const Vec2d* corners) : corners_(corners) {}
+
+  /***
+   * @description: Closed clockwise ring, 5 points
+   */
+  NODISCARD inline std::span<const Vec2d> ring() const {
+    return {corners_, kRingSize};
+  }
+  NODISCARD inline Gsegment f_segment() const {
+    return {corners_[3], corners_[0]};
+  }
+  NODISCARD inline Gsegment b_segment() const {
+    return {corners_[1], corners_[2]};
+  }
+
+  NODISCARD double area() const;
+  NODISCARD GBox envelope() const;
+
+  /***
+   * @description: Checks if the point is completely inside the box
+   */
+  NODISCARD bool within(const Vec2d& point) const;
+
+  /***
+   * @description: Intersection area with a polygon, computed by clipping the
+   * polygon rings against the (convex) box with scratch from arena
+   */
+  NODISCARD double calculateIntersectionArea(const Polygon2d& polygon,
+                                             FrameArena* arena) const;
+
+  /***
+   * @description: Same semantic as Polygon2d::iou / iouTarget / iouSelf
+   */
+  NODISCARD double iou(const Polygon2d& polygon, FrameArena* arena) const;
+  NODISCARD int iouTarget(const Polygon2d& others, FrameArena* arena) const;
+  NODISCARD int iouSelf(const Polygon2d& others, FrameArena* arena) const;
+
+  static constexpr size_t kRingSize = kBoxRingSize;
+
+ private:
+  const Vec2d* corners_ = nullptr;
+};
+
+/***
+ * @description: Frame scoped bump allocator. Every allocation of a frame is a
+ * pointer bump in a monotonic buffer, reset() releases all of them at once and
+ * rewinds to the initial block, which is reused by the next frame.
+ * @remark Not thread safe, use one arena per thread
+ */
+class FrameArena {
+ public:
+  /***
+   * @param initial_bytes size of the block reused by every frame
+   * @param upstream      resource serving frames overflowing the block
+   */
+  explicit FrameArena(
+      size_t initial_bytes = 64 * 1024,
+      std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+  virtual ~FrameArena() = default;
+  FrameArena(const FrameArena&) = delete;
+  FrameArena(FrameArena&&) = delete;
+  FrameArena& operator=(const FrameArena&) = delete;
+  FrameArena& operator=(FrameArena&&) = delete;
+
+  NODISCARD inline std::pmr::memory_resource* resource() { return &resource_; }
+
+  /***
+   * @description: Scratch vector allocating from the arena
+   */
+  template <typename T>
+  NODISCARD std::pmr::vector<T> makeVector(size_t capacity = 0) {
+    std::pmr::vector<T> result(&resource_);
+    result.reserve(capacity);
+    return result;
+  }
+
+  /***
+   * @description: Build a box with the same corners as Box2d
+   * @param spindle in 0.01 degree, 0 for z axis, clockwise
+   */
+  NODISCARD FrameBox makeBox(const Vec2d& center, double length, double width,
+                             uint32_t spindle);
+
+  /***
+   * @description: Release every allocation of the current frame
+   */
+  void reset();
+
+ private:
+  std::vector<std::byte> initial_;
+  std::pmr::monotonic_buffer_resource resource_;
+};
+
+}  // namespace geometry
+}  // namespace innovusion
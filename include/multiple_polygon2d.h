@@ -1,6 +1,6 @@
 /***
  * @Copyright [2023] <Innovusion Inc.>
- * @LastEditTime: 2023-09-12
+ * @LastEditTime: 2023-09-20
  * @LastEditors: Tianyun Xuan
  * @FilePath: geometry/include/multiple_polygon2d.h
  */
@@ -8,43 +8,249 @@
 #include <boost/geometry/geometries/polygon.hpp>
 #include <boost/geometry/geometries/ring.hpp>
 #include <boost/geometry/geometry.hpp>
+#include <span>
 #include <unordered_map>
+#include <vector>
 
 #include "polygon2d.h"
+#include "signed_distance_field.h"
+#include "slot_map.h"
+#include "spatial_hash.h"
 #include "vec2d.h"
 namespace innovusion {
 namespace geometry {
 
 namespace bg = boost::geometry;
 
+struct NearestPolygon {
+  // external index
+  size_t index;
+  size_t dense;
+  // 0 when inside / overlapping
+  double distance;
+};
+
+/***
+ * @description: Set of non-overlapping polygons addressed by an external index.
+ * Polygons live in a generational slot map: the external index is only hashed
+ * on add / remove, queries scan the dense arrays (envelope, area, polygon)
+ * sequentially. Point queries test the outer rings straight from the packed
+ * vertex pool. Only outer rings are packed: polygons_ still holds each
+ * Polygon2d with its own ring vectors, and a point inside the outer ring of
+ * a polygon with holes goes through Polygon2d::within / covered.
+ * @remark Derived caches are rebuilt by the mutations, const queries never
+ * build anything and may run concurrently, mutations may not
+ */
 class MultiplePolygon2d {
  public:
   MultiplePolygon2d();
   virtual ~MultiplePolygon2d() = default;
+
+  // copy / move carry the polygons and their caches
+  MultiplePolygon2d(const MultiplePolygon2d& other);
+  MultiplePolygon2d& operator=(const MultiplePolygon2d& other);
+  MultiplePolygon2d(MultiplePolygon2d&& other) noexcept;
+  MultiplePolygon2d& operator=(MultiplePolygon2d&& other) noexcept;
   NODISCARD bool add(size_t index, const std::vector<Vec2d>& outer,
                      const std::vector<std::vector<Vec2d>>& inners);
+  NODISCARD bool add(size_t index, std::vector<Vec2d>&& outer,
+                     std::vector<std::vector<Vec2d>>&& inners);
   NODISCARD bool remove(size_t index);
   NODISCARD int iouTarget(const PolygonPtr& others) const;
+  /***
+   * @description: Check iouTarget(others) >= percent. Polygons are visited by
+   * decreasing envelope upper bound and the scan stops as soon as the
+   * accumulated sum reaches percent or can no longer reach it.
+   */
+  NODISCARD bool iouTargetAtLeast(const PolygonPtr& others, int percent) const;
   NODISCARD bool within(const Vec2d& point) const;
   NODISCARD bool covered(const Vec2d& point) const;
   NODISCARD bool overlaped(const PolygonPtr& polygon) const;
-  NODISCARD inline bool empty() const { return polygons_.empty(); }
+
+  /***
+   * @description: k nearest polygons within max_distance, by ascending
+   * distance. Candidates come from a spatial hash of the envelopes, rebuilt
+   * by add / remove, with a search radius doubled until the k-th exact
+   * distance falls inside it. Every candidate enters one heap keyed by its
+   * envelope distance (a lower bound of the exact one) once, and is popped
+   * best first when the bound is inside the radius; the exact distance is
+   * computed at most once per polygon and the search stops once k exact
+   * distances are below the next bound.
+   */
+  void nearest(const Vec2d& point, size_t k, double max_distance,
+               std::vector<NearestPolygon>* result) const;
+  void nearest(const PolygonPtr& polygon, size_t k, double max_distance,
+               std::vector<NearestPolygon>* result) const;
+  /***
+   * @description: Nearest polygon within max_distance
+   * @return false if there is none
+   */
+  NODISCARD bool nearest(const Vec2d& point, double max_distance,
+                         NearestPolygon* result) const;
+  NODISCARD bool nearest(const PolygonPtr& polygon, double max_distance,
+                         NearestPolygon* result) const;
+
+  /***
+   * @description: Build a signed distance field of the set now and rebuild it
+   * at the end of every add / remove, so queries never build it. Enable it
+   * after loading the polygons, not before. signedDistance answers from the
+   * field and switches to the exact distance below refine_distance.
+   * @param resolution      grid step, 0 drops the field
+   * @param refine_distance about twice the resolution keeps the answers exact
+   *                        near boundaries
+   */
+  void enableDistanceField(double resolution, double refine_distance);
+  /***
+   * @description: Signed distance to the polygons boundary, negative inside,
+   * O(1) inside the field grid and away from the boundary when the distance
+   * field is enabled
+   * @remark a shared edge of two touching polygons is a boundary for the
+   * exact distance but not for the field
+   */
+  NODISCARD double signedDistance(const Vec2d& point) const;
+  /***
+   * @description: Distance to the nearest polygon outside, minus the distance
+   * to the boundary of the containing polygon inside, max() if empty
+   */
+  NODISCARD double exactSignedDistance(const Vec2d& point) const;
+
+  NODISCARD inline bool empty() const { return slots_.empty(); }
+  NODISCARD inline size_t size() const { return slots_.size(); }
+  /***
+   * @description: Process wide unique version of the polygons, changed by
+   * every successful add / remove and by copy, see ContentVersion
+   */
+  NODISCARD inline uint64_t version() const { return version_.value(); }
+
+  /***
+   * @description: Stable handle of an external index
+   * @return false if index is not stored
+   */
+  NODISCARD bool find(size_t index, SlotHandle* handle) const;
+
+  /***
+   * @description: Dense accessors, dense order changes on remove
+   */
+  NODISCARD inline size_t indexAt(size_t dense) const {
+    return indices_[dense];
+  }
+  NODISCARD inline const Polygon2d& polygonAt(size_t dense) const {
+    return polygons_[dense];
+  }
+  NODISCARD inline const GBox& envelopeAt(size_t dense) const {
+    return envelopes_[dense];
+  }
+  NODISCARD inline double areaAt(size_t dense) const { return areas_[dense]; }
+  /***
+   * @description: Closed outer ring of dense polygon in the packed vertex pool
+   */
+  NODISCARD std::span<const Vec2d> outerAt(size_t dense) const;
 
  protected:
-  std::unordered_map<size_t, PolygonPtr> polygons_;
+  NODISCARD bool overlaped(const Polygon2d& polygon, const GBox& envelope,
+                           size_t skip) const;
+  /***
+   * @description: Best first search shared by the nearest overloads
+   * @param distance exact distance to dense polygon
+   */
+  template <typename Distance>
+  void nearest(const GBox& envelope, size_t k, double max_distance,
+               Distance&& distance, std::vector<NearestPolygon>* result) const;
+  /***
+   * @description: Distance field, nullptr if disabled or too large
+   */
+  NODISCARD inline const SignedDistanceField* distanceField() const {
+    return field_.empty() ? nullptr : &field_;
+  }
+  /***
+   * @description: Rebuild the caches derived from the polygons, called at the
+   * end of every successful add / remove
+   */
+  virtual void updateCaches();
+  void buildDistanceField();
+  /***
+   * @description: Spatial hash of the dense envelopes
+   */
+  NODISCARD inline const SpatialHash& envelopeIndex() const { return index_; }
+  void refresh(size_t dense);
+  void erase(size_t dense);
+  void assign(const MultiplePolygon2d& other);
+  void assign(MultiplePolygon2d&& other);
+  void compactVertices();
+
+  SlotMap slots_;
+  std::unordered_map<size_t, SlotHandle> handles_;
+  // dense arrays, all indexed by SlotMap::dense
+  std::vector<size_t> indices_;
+  std::vector<Polygon2d> polygons_;
+  std::vector<GBox> envelopes_;
+  std::vector<double> areas_;
+  std::vector<uint32_t> vertex_offsets_;
+  std::vector<uint32_t> vertex_counts_;
+  // packed outer rings, dead ranges are reclaimed by compactVertices
+  std::vector<Vec2d> vertices_;
+  size_t dead_vertices_;
+  ContentVersion version_;
+  // optional signed distance field, see enableDistanceField
+  double field_resolution_;
+  double field_refine_;
+  SignedDistanceField field_;
+  // envelope index of the nearest queries
+  SpatialHash index_;
 };
 
 class Roi2d final : public MultiplePolygon2d {
  public:
-  explicit Roi2d(bool intreseted = true, int rate = 50)
-      : MultiplePolygon2d(), intreseted_(intreseted), rate_(rate) {}
+  /***
+   * @description: Constructor of ROI
+   * @param intreseted keep polygons inside ROI if true, outside otherwise
+   * @param rate       iouTarget threshold in percent
+   * @param compiled   answer polygon queries against the dissolved union of
+   * all ROI polygons (one intersection, no per polygon rounding) instead of
+   * summing per polygon iouTarget
+   */
+  explicit Roi2d(bool intreseted = true, int rate = 50, bool compiled = false)
+      : MultiplePolygon2d(),
+        intreseted_(intreseted),
+        rate_(rate),
+        compiled_(compiled) {}
   ~Roi2d() = default;
+
+  // copy / move carry the polygons, settings and compiled union
+  Roi2d(const Roi2d& other);
+  Roi2d& operator=(const Roi2d& other);
+  Roi2d(Roi2d&& other) noexcept;
+  Roi2d& operator=(Roi2d&& other) noexcept;
   NODISCARD bool isUseful(const PolygonPtr& others) const;
   NODISCARD bool isUseful(const Vec2d& point) const;
 
+  /***
+   * @description: Percentage of others' area covered by the ROI union, 0 if
+   * the ROI is not compiled
+   */
+  NODISCARD double coverage(const PolygonPtr& others) const;
+
+  /***
+   * @description: Dissolved union of all ROI polygons, rebuilt at the end of
+   * every add / remove of a compiled ROI, empty otherwise
+   */
+  NODISCARD inline const GMultiPolygon& compiledUnion() const {
+    return union_;
+  }
+
+  NODISCARD inline bool compiled() const { return compiled_; }
+  NODISCARD inline bool interested() const { return intreseted_; }
+  NODISCARD inline int rate() const { return rate_; }
+
+ protected:
+  void updateCaches() override;
+
  private:
   bool intreseted_;
   int rate_;
+  bool compiled_;
+  GMultiPolygon union_;
+  GBox union_envelope_;
 };
 
 }  // namespace geometry
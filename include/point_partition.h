@@ -0,0 +1,106 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-01
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/include/point_partition.h
+ */
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "multiple_polygon2d.h"
+#include "point_view.h"
+#include "polygon2d.h"
+#include "region_store.h"
+#include "spatial_hash.h"
+#include "vec2d.h"
+
+namespace innovusion {
+namespace geometry {
+
+/***
+ * @description: Splits point clouds into per region buckets stored CSR style:
+ * the points within region r are indices()[offsets()[r], offsets()[r + 1]),
+ * ascending. Regions are looked up through a SpatialHash of their envelopes.
+ * The cloud is cut into contiguous chunks, the first pass classifies every
+ * chunk (in parallel with OpenMP) and counts hits per chunk and region, the
+ * second one scatters the hits to offsets given by the prefix sum of the
+ * counts, so the output does not depend on the thread count.
+ * @remark Regions are referenced, bind again after the set changes. A point
+ * within overlapping regions is listed in each of them.
+ */
+class PointPartition {
+ public:
+  /***
+   * @param parallel run the first pass with OpenMP
+   */
+  explicit PointPartition(bool parallel = true);
+  virtual ~PointPartition() = default;
+
+  /***
+   * @description: Use the dense polygons of polygons as regions, region r is
+   * dense polygon r
+   */
+  void bind(const MultiplePolygon2d& polygons);
+  void bind(const RegionStore& regions);
+  void bind(const std::vector<PolygonPtr>& regions);
+
+  NODISCARD inline size_t regionCount() const { return regions_.size(); }
+
+  /***
+   * @description: Partition points, the previous result is replaced
+   */
+  void partition(std::span<const Vec2d> points);
+  void partition(const PointView& points);
+  /***
+   * @description: Number of points within every region, without storing the
+   * partition
+   * @param counts resized to regionCount()
+   */
+  void count(std::span<const Vec2d> points, std::vector<uint32_t>* counts);
+  void count(const PointView& points, std::vector<uint32_t>* counts);
+
+  /***
+   * @description: Result of the last partition
+   */
+  NODISCARD inline const std::vector<uint32_t>& offsets() const {
+    return offsets_;
+  }
+  NODISCARD inline const std::vector<uint32_t>& indices() const {
+    return indices_;
+  }
+  NODISCARD std::span<const uint32_t> pointsOf(size_t region) const;
+
+ protected:
+  struct Hit {
+    uint32_t point;
+    uint32_t region;
+  };
+
+  void index();
+  /***
+   * @description: First pass, fills chunk_counts_ and, if keep_hits, hits_
+   */
+  template <typename Points>
+  void classify(const Points& points, bool keep_hits);
+  /***
+   * @description: Second pass of partition
+   */
+  void scatter();
+  void sum(std::vector<uint32_t>* counts) const;
+
+  bool parallel_;
+  std::vector<const Polygon2d*> regions_;
+  std::vector<GBox> envelopes_;
+  SpatialHash index_;
+  size_t chunks_;
+  // chunk c counts region r at chunk_counts_[c * regionCount() + r]
+  std::vector<uint32_t> chunk_counts_;
+  std::vector<std::vector<Hit>> hits_;
+  std::vector<uint32_t> offsets_;
+  std::vector<uint32_t> indices_;
+};
+
+}  // namespace geometry
+}  // namespace innovusion
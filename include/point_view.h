@@ -0,0 +1,104 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-03
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/include/point_view.h
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "vec2d.h"
+
+namespace innovusion {
+namespace geometry {
+
+enum class PointFieldType : uint8_t {
+  Float32 = 0,
+  Float64 = 1,
+};
+
+/***
+ * @description: Non owning view of points stored in a foreign array of
+ * structs (driver / PCL layouts such as {float x, y, z, intensity; uint16
+ * ring; double timestamp}). Point i is read straight from
+ * base + i * stride + field offset, no intermediate buffer is built. The
+ * coordinate fields share one type.
+ * @remark The buffer must outlive the view, fields need not be aligned
+ */
+class PointView {
+ public:
+  static constexpr size_t kNoField = std::numeric_limits<size_t>::max();
+
+  PointView()
+      : base_(nullptr),
+        count_(0),
+        stride_(0),
+        x_offset_(kNoField),
+        y_offset_(0),
+        z_offset_(0),
+        type_(PointFieldType::Float32) {}
+  /***
+   * @param base     address of the first point
+   * @param count    number of points
+   * @param stride   bytes between two consecutive points
+   * @param y_offset byte offset of y in a point
+   * @param z_offset byte offset of z in a point
+   * @param type     type of the coordinate fields
+   * @param x_offset byte offset of x (height) in a point, kNoField if none
+   */
+  PointView(const void* base, size_t count, size_t stride, size_t y_offset,
+            size_t z_offset, PointFieldType type = PointFieldType::Float32,
+            size_t x_offset = kNoField)
+      : base_(static_cast<const uint8_t*>(base)),
+        count_(count),
+        stride_(stride),
+        x_offset_(x_offset),
+        y_offset_(y_offset),
+        z_offset_(z_offset),
+        type_(type) {}
+
+  NODISCARD inline size_t size() const { return count_; }
+  NODISCARD inline bool empty() const { return count_ == 0; }
+  NODISCARD inline bool hasX() const { return x_offset_ != kNoField; }
+
+  /***
+   * @description: (y, z) of point i
+   */
+  NODISCARD inline Vec2d operator[](size_t i) const {
+    const uint8_t* point = base_ + i * stride_;
+    return Vec2d(field(point + y_offset_), field(point + z_offset_));
+  }
+  /***
+   * @description: x of point i, hasX() must be true
+   */
+  NODISCARD inline double x(size_t i) const {
+    return field(base_ + i * stride_ + x_offset_);
+  }
+
+ private:
+  NODISCARD inline double field(const uint8_t* address) const {
+    // memcpy keeps unaligned fields legal and compiles to a plain load
+    if (type_ == PointFieldType::Float32) {
+      float value;
+      std::memcpy(&value, address, sizeof(value));
+      return value;
+    }
+    double value;
+    std::memcpy(&value, address, sizeof(value));
+    return value;
+  }
+
+  const uint8_t* base_;
+  size_t count_;
+  size_t stride_;
+  size_t x_offset_;
+  size_t y_offset_;
+  size_t z_offset_;
+  PointFieldType type_;
+};
+
+}  // namespace geometry
+}  // namespace innovusion
@@ -0,0 +1,99 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-30
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/include/polar_roi.h
+ */
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "multiple_polygon2d.h"
+#include "rigid_transform2d.h"
+#include "vec2d.h"
+
+namespace innovusion {
+namespace geometry {
+
+/***
+ * @description: Sensor frame lookup table of a Roi2d for points given as
+ * (azimuth, range) around the sensor origin. For every azimuth bin the ray
+ * through the bin center is moved back to the region frame and intersected with
+ * the ROI rings, the sorted ranges where it enters / leaves the ROI are
+ * packed per bin (0 first when the sensor is inside). A point is inside the
+ * ROI iff an odd number of those lie below its range, so isUseful is a single
+ * binary search over a handful of floats.
+ * @remark Azimuth is atan2(y, z) in sensor frame, 0 along z. A point closer
+ * than about range * 2 pi / bins to a boundary takes the answer of its bin
+ * center ray.
+ */
+class PolarRoiTable {
+ public:
+  PolarRoiTable();
+  virtual ~PolarRoiTable() = default;
+
+  /***
+   * @param roi       ROI polygons in region frame
+   * @param transform region frame to sensor frame, as RegionMonitor moves
+   *                  the ROI vertices
+   * @param origin    sensor origin in sensor frame
+   * @param bins      azimuth bins over 2 pi
+   * @return false if bins is 0
+   */
+  NODISCARD bool build(const Roi2d& roi, const RigidTransform2d& transform,
+                       const Vec2d& origin, uint32_t bins);
+
+  /***
+   * @description: Same answer as a Roi2d of the transform.apply moved ROI
+   * vertices, i.e. roi.isUseful(transform.inverse(point)), for the point at
+   * azimuth / range from the sensor origin
+   */
+  NODISCARD inline bool isUseful(double azimuth, double range) const {
+    if (bins_ == 0) {
+      return false;
+    }
+    const uint32_t bin = binOf(azimuth);
+    const float* begin = bounds_.data() + offsets_[bin];
+    const float* end = bounds_.data() + offsets_[bin + 1];
+    const auto below = std::upper_bound(begin, end, static_cast<float>(range));
+    return (((below - begin) & 1) != 0) == interested_;
+  }
+  /***
+   * @description: Same as above for a sensor frame point
+   */
+  NODISCARD bool isUseful(const Vec2d& point) const;
+
+  NODISCARD inline uint32_t bins() const { return bins_; }
+  /***
+   * @description: Sorted enter / leave ranges of bin
+   */
+  NODISCARD std::span<const float> boundsAt(uint32_t bin) const;
+
+  NODISCARD static inline double azimuthOf(const Vec2d& offset) {
+    return std::atan2(offset.y, offset.z);
+  }
+
+ protected:
+  NODISCARD inline uint32_t binOf(double azimuth) const {
+    // [-pi, pi) -> [0, bins), out of range azimuths wrap around
+    const int64_t bin =
+        static_cast<int64_t>(std::floor((azimuth + M_PI) * bin_scale_));
+    const int64_t count = static_cast<int64_t>(bins_);
+    return static_cast<uint32_t>(((bin % count) + count) % count);
+  }
+
+  Vec2d origin_;
+  uint32_t bins_;
+  // bins per radian
+  double bin_scale_;
+  bool interested_;
+  // bin b owns bounds_[offsets_[b], offsets_[b + 1])
+  std::vector<uint32_t> offsets_;
+  std::vector<float> bounds_;
+};
+
+}  // namespace geometry
+}  // namespace innovusion
@@ -9,7 +9,10 @@
 #include <boost/geometry/geometries/polygon.hpp>
 #include <boost/geometry/geometries/ring.hpp>
 #include <boost/geometry/geometry.hpp>
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -19,6 +22,7 @@ namespace geometry {
 
 namespace bg = boost::geometry;
 typedef bg::model::polygon<Vec2d> GPolygon;
+typedef bg::model::multi_polygon<GPolygon> GMultiPolygon;
 typedef bg::model::ring<Vec2d> GRing;
 typedef bg::model::box<Vec2d> GBox;
 typedef bg::model::segment<Vec2d> Gsegment;
@@ -32,6 +36,50 @@ enum class PolygonType {
 class Polygon2d;
 typedef std::shared_ptr<Polygon2d> PolygonPtr;
 
+/***
+ * @description: Area of the intersection of two envelopes, an upper bound of
+ * the intersection area of the geometries they wrap
+ */
+NODISCARD double envelopeOverlapArea(const GBox& first, const GBox& second);
+
+/***
+ * @description: Fill the 4 clockwise corners of a box, corners[3] -> corners[0]
+ * is the front edge and corners[1] -> corners[2] the back edge
+ * @param spindle in 0.01 degree, 0 for z axis, clockwise
+ */
+void boxCorners(const Vec2d& center, double length, double width,
+                uint32_t spindle, Vec2d* corners);
+
+// points of a closed box ring
+constexpr size_t kBoxRingSize = 5;
+
+/***
+ * @description: O(n) validity check for the common simple case: a closed,
+ * clockwise, strictly convex ring with finite coordinates (boxes, rotated
+ * boxes, convex regions). A true result implies bg::is_valid, false means
+ * the general check is needed.
+ */
+NODISCARD bool isValidConvexRing(const GRing& ring);
+
+/***
+ * @description: Distance from point to the nearest ring (outer or inner) of
+ * polygon, unlike bg::distance it is not 0 inside
+ */
+NODISCARD double boundaryDistance(const Vec2d& point, const GPolygon& polygon);
+
+/***
+ * @description: Build the closed clockwise rings of a batch of boxes from
+ * structure of arrays detections, spindle sin / cos come from a table of the
+ * 36000 possible values. Ring i is rings[5 * i, 5 * i + 5), same corners as
+ * Box2d, ready for FrameBox.
+ * @return false if array sizes do not match or rings is too small
+ */
+NODISCARD bool batchBoxCorners(std::span<const Vec2d> centers,
+                               std::span<const double> lengths,
+                               std::span<const double> widths,
+                               std::span<const uint32_t> spindles,
+                               std::span<Vec2d> rings);
+
 class Polygon2d {
  public:
   /***
@@ -54,22 +102,60 @@ class Polygon2d {
   Polygon2d(PolygonType type, const std::vector<Vec2d>& outer,
             const std::vector<std::vector<Vec2d>>& inners);
 
+  /***
+   * @description:  Constructor for Region type polygon, rings storage is moved
+   * into the polygon without copy
+   * @param type    Polygon type
+   * @param outer   Outside boundary of polygon
+   * @param inners  Gather of holes inside polygon
+   */
+  Polygon2d(PolygonType type, std::vector<Vec2d>&& outer,
+            std::vector<std::vector<Vec2d>>&& inners);
+
+  /***
+   * @description:  Constructor for Region type polygon from borrowed rings,
+   * points are copied once straight into the polygon
+   * @param type    Polygon type
+   * @param outer   Outside boundary of polygon
+   * @param inners  Gather of holes inside polygon
+   */
+  Polygon2d(PolygonType type, std::span<const Vec2d> outer,
+            std::span<const std::vector<Vec2d>> inners);
+
+  /***
+   * @description:  Constructor taking over a ready polygon
+   * @param type    Polygon type
+   * @param polygon polygon to move from
+   */
+  Polygon2d(PolygonType type, GPolygon&& polygon);
+
   /***
    * @description: Defaut deconstructor
    */
   virtual ~Polygon2d() = default;
 
+  // copy constructor
+  Polygon2d(const Polygon2d& other);
+  // copy assignment
+  Polygon2d& operator=(const Polygon2d& other);
+  // move constructor
+  Polygon2d(Polygon2d&& other) noexcept;
+  // move assignment
+  Polygon2d& operator=(Polygon2d&& other) noexcept;
+
   /***
    * @description: Set polyon outer ring
    * @param outer  Outer ring
    */
   void setOuter(const std::vector<Vec2d>& outer);
+  void setOuter(std::vector<Vec2d>&& outer);
 
   /***
    * @description: Set polygon inner rings
    * @param inners Inner rings
    */
   void setInners(const std::vector<std::vector<Vec2d>>& inners);
+  void setInners(std::vector<std::vector<Vec2d>>&& inners);
 
   /***
    * @description: Corrects a polygon: all rings which are wrongly oriented with
@@ -80,7 +166,9 @@ class Polygon2d {
   void correct();
 
   /***
-   * @description: Checks if a geometry is valid (in the OGC sense)
+   * @description: Checks if a geometry is valid (in the OGC sense). The result
+   * is cached until the next mutation, convex rings without holes are
+   * confirmed by isValidConvexRing before falling back to bg::is_valid.
    */
   NODISCARD virtual bool isValid() const;
 
@@ -90,9 +178,22 @@ class Polygon2d {
   NODISCARD double area() const;
 
   /***
-   * @description: Return a copy of polygon
+   * @description: Return the underlying polygon
+   */
+  NODISCARD const GPolygon& getPolygon() const;
+
+  /***
+   * @description: Return the outer ring and the inner rings
    */
-  NODISCARD GPolygon getPolygon() const;
+  NODISCARD inline const GRing& outer() const { return polygon_.outer(); }
+  NODISCARD inline const std::vector<GRing>& inners() const {
+    return polygon_.inners();
+  }
+
+  /***
+   * @description: Calculates the axis aligned envelope of the polygon
+   */
+  NODISCARD GBox envelope() const;
 
   /***
    * @description: Calculate the intersection area between two polygons
@@ -126,6 +227,22 @@ class Polygon2d {
    */
   NODISCARD int iouSelf(const PolygonPtr& others) const;
 
+  /***
+   * @description: Check iou(polygon) >= threshold, the overlay is skipped when
+   * the envelope overlap already bounds the iou below threshold
+   * @param polygon   another polygon
+   * @param threshold iou threshold in [0, 1]
+   */
+  NODISCARD bool iouAtLeast(const PolygonPtr& polygon, double threshold) const;
+
+  /***
+   * @description: Check iouTarget(others) >= percent, the overlay is skipped
+   * when the envelope overlap already bounds the percentage below percent
+   * @param others  another polygon
+   * @param percent percentage * 100
+   */
+  NODISCARD bool iouTargetAtLeast(const PolygonPtr& others, int percent) const;
+
   /***
    * @description: Checks if the point is completely inside self polygon.
    * @param others a point
@@ -174,11 +291,22 @@ class Polygon2d {
   }
 
  protected:
+  enum class Validity : uint8_t {
+    Unknown = 0,
+    Valid = 1,
+    Invalid = 2,
+  };
+  inline void invalidate() {
+    validity_.store(Validity::Unknown, std::memory_order_relaxed);
+  }
+
   PolygonType type_;
   GPolygon polygon_;
   // (TODO: Tianyun Xuan) remove these variables as temporary solution
   Gsegment f_segment_;
   Gsegment b_segment_;
+  // cached isValid result, reset by every mutation
+  mutable std::atomic<Validity> validity_{Validity::Unknown};
 };
 
 }  // namespace geometry
@@ -0,0 +1,135 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-02
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/include/prism_set.h
+ */
+#pragma once
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "point_view.h"
+#include "polygon2d.h"
+#include "slot_map.h"
+#include "spatial_hash.h"
+#include "vec2d.h"
+
+namespace innovusion {
+namespace geometry {
+
+/***
+ * @description: Closed interval along x, the axis orthogonal to the (y, z)
+ * plane of Vec2d
+ */
+struct HeightRange {
+  double low;
+  double high;
+
+  NODISCARD inline bool contains(double x) const {
+    return low <= x && x <= high;
+  }
+  NODISCARD inline bool overlaps(const HeightRange& other) const {
+    return low <= other.high && other.low <= high;
+  }
+};
+
+/***
+ * @description: Regions extruded along x, a footprint polygon plus a height
+ * range. Footprints may overlap when the heights differ. Queries reject on
+ * the scalar height tests first (the union of all ranges, then the range of
+ * each candidate) and only then touch the footprint, candidates come from a
+ * SpatialHash of the footprint envelopes rebuilt by add / remove.
+ * @remark Queries are const and may run concurrently, add / remove may not
+ */
+class PrismSet {
+ public:
+  PrismSet();
+  virtual ~PrismSet() = default;
+
+  /***
+   * @description: Add or replace prism
+   * @return false if the footprint is not valid or height is empty
+   */
+  NODISCARD bool add(size_t index, const std::vector<Vec2d>& outer,
+                     const std::vector<std::vector<Vec2d>>& inners,
+                     const HeightRange& height);
+  NODISCARD bool remove(size_t index);
+
+  NODISCARD inline size_t size() const { return indices_.size(); }
+  NODISCARD inline bool empty() const { return indices_.empty(); }
+  NODISCARD inline size_t indexAt(size_t dense) const {
+    return indices_[dense];
+  }
+  NODISCARD inline const Polygon2d& polygonAt(size_t dense) const {
+    return polygons_[dense];
+  }
+  NODISCARD inline const HeightRange& heightAt(size_t dense) const {
+    return heights_[dense];
+  }
+  /***
+   * @description: Union of all height ranges, empty (low > high) if no prism
+   */
+  NODISCARD inline const HeightRange& height() const { return height_; }
+
+  /***
+   * @description: Checks if (x, point) is inside a prism, footprint interior
+   * and closed height range
+   */
+  NODISCARD bool within(double x, const Vec2d& point) const;
+  /***
+   * @description: Fused batch of within over an interleaved x, y, z buffer
+   * @param xyz    3 * n floats
+   * @param result resized to n, 1 if within
+   */
+  void within(std::span<const float> xyz, std::vector<uint8_t>* result) const;
+  /***
+   * @description: Same over a foreign point layout
+   * @return false if points has no x field
+   */
+  NODISCARD bool within(const PointView& points,
+                        std::vector<uint8_t>* result) const;
+
+  /***
+   * @description: External indices of the prisms whose height range overlaps
+   * height and whose footprint intersects box, ascending by dense index
+   */
+  void overlaped(const PolygonPtr& box, const HeightRange& height,
+                 std::vector<size_t>* indices) const;
+  /***
+   * @param result resized to boxes, 1 if box overlaps a prism
+   */
+  void overlaped(std::span<const PolygonPtr> boxes,
+                 std::span<const HeightRange> heights,
+                 std::vector<uint8_t>* result) const;
+
+ protected:
+  NODISCARD int64_t find(double x, const Vec2d& point,
+                         std::vector<uint32_t>* candidates) const;
+  /***
+   * @description: Calls visit(dense) for the prisms overlapping box and
+   * height in ascending dense order until visit returns true
+   * @return true if a visit returned true
+   */
+  template <typename Visitor>
+  bool visitOverlaps(const PolygonPtr& box, const HeightRange& height,
+                     std::vector<uint32_t>* candidates, Visitor&& visit) const;
+  /***
+   * @description: Height union and index, after every add / remove
+   */
+  void updateCaches();
+
+  SlotMap slots_;
+  std::unordered_map<size_t, SlotHandle> handles_;
+  // dense arrays, all indexed by SlotMap::dense
+  std::vector<size_t> indices_;
+  std::vector<Polygon2d> polygons_;
+  std::vector<GBox> envelopes_;
+  std::vector<HeightRange> heights_;
+  HeightRange height_;
+  SpatialHash index_;
+};
+
+}  // namespace geometry
+}  // namespace innovusion
@@ -23,6 +23,14 @@ class Region2d final : public Polygon2d {
            const std::vector<std::vector<Vec2d>>& inners,
            const std::vector<uint32_t>& attributes,
            const std::vector<int32_t>& values);
+  /***
+   * @description: Constructor od Region 2D, rings storage is moved into the
+   * region without copy
+   */
+  Region2d(const size_t index, std::vector<Vec2d>&& outer,
+           std::vector<std::vector<Vec2d>>&& inners,
+           const std::vector<uint32_t>& attributes,
+           const std::vector<int32_t>& values);
   ~Region2d() = default;
 
   /***
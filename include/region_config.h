@@ -0,0 +1,85 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-05
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/include/region_config.h
+ */
+#pragma once
+#include <Eigen/Core>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "vec2d.h"
+
+namespace innovusion {
+namespace geometry {
+
+/***
+ * @description: One configured polygon, attributes / values are empty for
+ * ROI polygons
+ */
+struct RegionConfigPolygon {
+  std::vector<Vec2d> outer;
+  std::vector<std::vector<Vec2d>> inners;
+  std::vector<uint32_t> attributes;
+  std::vector<int32_t> values;
+
+  NODISCARD bool operator==(const RegionConfigPolygon& other) const;
+};
+
+/***
+ * @description: Region configuration as written in YAML, coordinates in the
+ * region (config) frame, RegionState moves them to the sensor frame by
+ * rt_matrix:
+ *
+ *   rt_matrix:                  # optional, same as initRtMatrix
+ *     precision: 0.001
+ *     data: [16 floats, row major]
+ *   roi:                        # optional
+ *     interested: true
+ *     rate: 50
+ *     compiled: false
+ *     polygons:
+ *       - index: 0
+ *         outer: [[y, z], ...]
+ *         inners: [[[y, z], ...], ...]  # optional
+ *   regions:
+ *     - index: 1
+ *       outer: [[y, z], ...]
+ *       inners: [[[y, z], ...], ...]    # optional
+ *       attributes: [1, 2]
+ *       values: [10, 20]
+ *
+ * Only the structure is checked here, polygon validity is checked when the
+ * polygons are added to their containers.
+ */
+struct RegionConfig {
+  // keyed by index
+  std::map<size_t, RegionConfigPolygon> regions;
+  std::map<size_t, RegionConfigPolygon> roi;
+  bool roi_interested = true;
+  int roi_rate = 50;
+  bool roi_compiled = false;
+  bool has_rt_matrix = false;
+  Eigen::Matrix4f rt_matrix = Eigen::Matrix4f::Identity();
+  float rt_precision = 1e-3f;
+
+  NODISCARD bool operator==(const RegionConfig& other) const;
+
+  /***
+   * @description: Parse YAML text
+   * @param error may be nullptr, set to the reason on failure
+   * @return false if text is not YAML or does not match the layout above
+   */
+  NODISCARD static bool fromYaml(const std::string& text,
+                                 RegionConfig* config,
+                                 std::string* error = nullptr);
+  NODISCARD static bool fromFile(const std::string& path,
+                                 RegionConfig* config,
+                                 std::string* error = nullptr);
+};
+
+}  // namespace geometry
+}  // namespace innovusion
@@ -0,0 +1,124 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-29
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/include/region_events.h
+ */
+#pragma once
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "polygon2d.h"
+#include "vec2d.h"
+
+namespace innovusion {
+namespace geometry {
+
+enum class RegionEventType : uint8_t {
+  Enter = 0,
+  Exit = 1,
+  // once per stay, when the stay reaches the dwell threshold
+  Dwell = 2,
+};
+
+struct RegionEvent {
+  RegionEventType type;
+  uint32_t track;
+  uint32_t region;
+  // frames spent inside the region so far (0 for Enter)
+  uint32_t frames;
+};
+
+struct TrackPosition {
+  uint32_t track;
+  Vec2d position;
+};
+
+/***
+ * @description: Incremental region membership of tracked points. Each track
+ * remembers where it was last evaluated and its distance to the nearest region
+ * boundary, as long as it stays closer than that to the anchor no boundary can
+ * have been crossed and the track is not re-evaluated. Per frame cost is a
+ * distance check for every track plus region tests for the tracks near a
+ * boundary only.
+ * @remark Not thread safe
+ */
+class RegionEventEngine {
+ public:
+  /***
+   * @param dwell_frames frames inside a region before a Dwell event, 0 to
+   *                     disable Dwell events
+   */
+  explicit RegionEventEngine(uint32_t dwell_frames = 0);
+  virtual ~RegionEventEngine() = default;
+
+  /***
+   * @description: Add or replace region, membership is re-evaluated for every
+   * track at the next update
+   * @return false if region is not valid
+   */
+  NODISCARD bool addRegion(uint32_t region, const PolygonPtr& polygon);
+  NODISCARD bool removeRegion(uint32_t region);
+
+  /***
+   * @description: Advance one frame
+   * @param tracks every live track of the frame, tracks missing from the frame
+   *               exit all their regions and are forgotten
+   * @param events cleared, then filled with the events of the frame, grouped
+   *               by track in input order, exits before enters, forgotten
+   *               tracks last
+   */
+  void update(std::span<const TrackPosition> tracks,
+              std::vector<RegionEvent>* events);
+
+  /***
+   * @description: Regions containing track, ascending, empty if unknown
+   */
+  void regionsOf(uint32_t track, std::vector<uint32_t>* regions) const;
+
+  NODISCARD inline size_t trackCount() const { return tracks_.size(); }
+  NODISCARD inline size_t regionCount() const { return regions_.size(); }
+  /***
+   * @description: Tracks re-evaluated by the last update
+   */
+  NODISCARD inline size_t evaluated() const { return evaluated_; }
+
+ protected:
+  struct Membership {
+    uint32_t region;
+    uint64_t enter_frame;
+    bool dwell_reported;
+  };
+  struct TrackState {
+    Vec2d anchor;
+    // no boundary closer than slack to anchor, negative forces evaluation
+    double slack = -1.0;
+    uint64_t seen_frame = 0;
+    // sorted by region
+    std::vector<Membership> memberships;
+  };
+
+  /***
+   * @description: Recompute memberships and slack at position, emit changes
+   */
+  void evaluate(uint32_t track, const Vec2d& position, TrackState* state,
+                std::vector<RegionEvent>* events);
+  void reportDwell(uint32_t track, TrackState* state,
+                   std::vector<RegionEvent>* events) const;
+  void invalidate();
+
+  uint32_t dwell_frames_;
+  uint64_t frame_;
+  size_t evaluated_;
+  std::vector<uint32_t> regions_;
+  std::vector<PolygonPtr> polygons_;
+  std::vector<GBox> envelopes_;
+  std::unordered_map<uint32_t, TrackState> tracks_;
+  // evaluation scratch
+  std::vector<Membership> scratch_;
+};
+
+}  // namespace geometry
+}  // namespace innovusion
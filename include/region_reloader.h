@@ -0,0 +1,167 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-05
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/include/region_reloader.h
+ */
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "multiple_polygon2d.h"
+#include "region_config.h"
+#include "region_store.h"
+#include "rigid_transform2d.h"
+
+namespace innovusion {
+namespace geometry {
+
+/***
+ * @description: Immutable regions and ROI built from a RegionConfig, polygons
+ * moved by the RT matrix like RegionMonitor::rotat_trans. Containers a
+ * config change does not touch are shared with the previous state.
+ * @remark Every derived cache (envelope index, distance field, compiled ROI
+ * union) is built by the add / remove calls of build, so the first query
+ * after the swap builds nothing
+ * @remark A region change copies the previous RegionStore, every polygon
+ * included, before applying the diff: O(total vertices) per reload, paid on
+ * the reloading thread
+ */
+class RegionState {
+ public:
+  // empty, generation 0
+  RegionState();
+  virtual ~RegionState() = default;
+
+  /***
+   * @description: Build the state of config on top of previous, only the
+   * regions added, changed or removed since previous are validated and
+   * indexed; an RT matrix change rebuilds everything, an ROI change the ROI
+   * @param error may be nullptr, set to the reason on failure
+   * @return false if the RT matrix or a changed polygon is not valid
+   */
+  NODISCARD static bool build(const RegionConfig& config,
+                              const RegionState& previous,
+                              std::shared_ptr<const RegionState>* state,
+                              std::string* error = nullptr);
+
+  NODISCARD inline uint64_t generation() const { return generation_; }
+  NODISCARD inline const RegionConfig& config() const { return config_; }
+  NODISCARD inline const RigidTransform2d& transform() const {
+    return transform_;
+  }
+  NODISCARD inline const std::shared_ptr<const RegionStore>& regions() const {
+    return regions_;
+  }
+  NODISCARD inline const std::shared_ptr<const Roi2d>& roi() const {
+    return roi_;
+  }
+
+  void findRelatedMessage(const PolygonPtr& box,
+                          std::vector<uint32_t>* attributes,
+                          std::vector<int32_t>* values,
+                          std::vector<int32_t>* ious,
+                          std::unordered_map<uint32_t, uint32_t>* flow) const;
+  NODISCARD bool isUseful(const PolygonPtr& others) const;
+  NODISCARD bool isUseful(const Vec2d& point) const;
+
+ protected:
+  uint64_t generation_;
+  RegionConfig config_;
+  RigidTransform2d transform_;
+  std::shared_ptr<const RegionStore> regions_;
+  std::shared_ptr<const Roi2d> roi_;
+};
+
+/***
+ * @description: Region configuration hot reloaded from a YAML file. Reloads
+ * diff the file against the current config, build the next RegionState
+ * (on the watcher thread when watching) and swap it in atomically. Queries
+ * only load the current state, they never wait for a reload to parse or
+ * build nor see a half built one, and a state stays alive while a query
+ * still uses it.
+ * @remark a config which fails to parse or validate keeps the current state,
+ * see error
+ * @remark std::atomic<std::shared_ptr> is not lock-free in libstdc++: load
+ * and store take a spin lock around the pointer copy and the reference
+ * count update, so a query may spin for that long against a swap or
+ * another query, never for a whole reload
+ */
+class RegionReloader {
+ public:
+  explicit RegionReloader(const std::string& path);
+  virtual ~RegionReloader();
+  RegionReloader(const RegionReloader&) = delete;
+  RegionReloader& operator=(const RegionReloader&) = delete;
+
+  /***
+   * @description: Read and apply the file now, on the calling thread
+   * @return false if the file could not be read, parsed or validated
+   */
+  NODISCARD bool reload();
+  /***
+   * @description: Apply config, a config equal to the current one keeps
+   * the current state
+   */
+  NODISCARD bool apply(const RegionConfig& config);
+
+  /***
+   * @description: Poll the file every period on a background thread and
+   * reload it when its content changed and stayed the same for one more
+   * period, writers should still prefer replacing the file by rename
+   */
+  void watch(std::chrono::milliseconds period);
+  void stop();
+
+  /***
+   * @description: Current state, never nullptr
+   */
+  NODISCARD std::shared_ptr<const RegionState> state() const;
+  /***
+   * @return reason of the last failed reload, empty if it succeeded
+   */
+  NODISCARD std::string error() const;
+
+  /***
+   * @description: Same as RegionStore::findRelatedMessage and
+   * Roi2d::isUseful on the current state
+   */
+  void findRelatedMessage(const PolygonPtr& box,
+                          std::vector<uint32_t>* attributes,
+                          std::vector<int32_t>* values,
+                          std::vector<int32_t>* ious,
+                          std::unordered_map<uint32_t, uint32_t>* flow) const;
+  NODISCARD bool isUseful(const PolygonPtr& others) const;
+  NODISCARD bool isUseful(const Vec2d& point) const;
+
+ protected:
+  // callers hold reload_mutex_
+  NODISCARD bool load(const std::string& text);
+  NODISCARD bool publish(const RegionConfig& config);
+  void poll();
+
+  std::string path_;
+  // not lock-free, see the class remark
+  std::atomic<std::shared_ptr<const RegionState>> state_;
+  // serializes reloads, never taken by queries
+  mutable std::mutex reload_mutex_;
+  // last applied file content and the one waiting to be stable
+  std::string text_;
+  std::string pending_;
+  std::string error_;
+  // watcher
+  std::thread watcher_;
+  std::mutex watch_mutex_;
+  std::condition_variable wake_;
+  bool stopping_;
+};
+
+}  // namespace geometry
+}  // namespace innovusion
@@ -0,0 +1,174 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-03
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/include/region_snapshot.h
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "multiple_polygon2d.h"
+#include "region_store.h"
+#include "vec2d.h"
+
+namespace innovusion {
+namespace geometry {
+
+/***
+ * @description: Versioned, checksummed binary image of a RegionStore and a
+ * Roi2d with prebuilt uniform grid indexes, queried in place (e.g. straight
+ * from an mmap'd file) without deserialization.
+ *
+ * Layout, host byte order, every section 8 byte aligned:
+ *   Header            magic, version, total size, FNV-1a 64 checksum of the
+ *                     bytes after the header, counts, ROI settings, section
+ *                     offsets
+ *   Polygons          PolygonRecord per region (dense order) then per ROI
+ *                     polygon
+ *   Rings             RingRecord per ring, outer ring first
+ *   Points            (y, z) double pairs, rings closed, outer clockwise
+ *                     and inner counter clockwise
+ *   Attributes        uint32 per region attribute
+ *   Values            int32 per region attribute
+ *   RegionGrid        GridRecord, uint32 cell offsets, uint32 entries
+ *   RoiGrid           same for the ROI polygons
+ *
+ * Point tests run on the mapped rings. Area queries clip the mapped rings of
+ * the candidates left by the grid and envelope tests against the query
+ * polygon when it is convex (boxes), two scratch rings per query; only a
+ * concave query polygon copies the candidates into Polygon2d.
+ * @remark Const queries may run concurrently. The bytes must outlive the
+ * snapshot.
+ */
+class RegionSnapshot {
+ public:
+  static constexpr uint32_t kMagic = 0x4e535247;  // "GRSN" little endian
+  static constexpr uint32_t kVersion = 1;
+
+  /***
+   * @description: Build the snapshot image of regions and roi
+   */
+  static void serialize(const RegionStore& regions, const Roi2d& roi,
+                        std::vector<uint8_t>* bytes);
+  /***
+   * @description: Write the image next to path and rename it over path, so
+   * snapshots already mapped from path keep their content
+   * @return false if the file could not be written
+   */
+  NODISCARD static bool save(const RegionStore& regions, const Roi2d& roi,
+                             const std::string& path);
+
+  RegionSnapshot();
+  virtual ~RegionSnapshot();
+  RegionSnapshot(const RegionSnapshot&) = delete;
+  RegionSnapshot& operator=(const RegionSnapshot&) = delete;
+
+  /***
+   * @description: Use bytes in place
+   * @param verify check the checksum, O(size)
+   * @return false if bytes are misaligned, truncated, of another version or
+   * corrupted, the snapshot is empty afterwards
+   */
+  NODISCARD bool attach(std::span<const uint8_t> bytes, bool verify = true);
+  /***
+   * @description: Map the file read only and attach it
+   */
+  NODISCARD bool open(const std::string& path, bool verify = true);
+  /***
+   * @description: Map the whole object behind descriptor read only and
+   * attach it, e.g. a POSIX shared memory object
+   * @remark descriptor stays open, the mapping does not need it
+   */
+  NODISCARD bool map(int descriptor, bool verify = true);
+  void close();
+
+  NODISCARD inline bool empty() const { return header_ == nullptr; }
+  NODISCARD size_t regionCount() const;
+  NODISCARD size_t roiCount() const;
+  NODISCARD bool roiInterested() const;
+  NODISCARD int roiRate() const;
+
+  /***
+   * @description: Region accessors in RegionStore dense order
+   */
+  NODISCARD size_t indexAt(size_t dense) const;
+  NODISCARD std::span<const uint32_t> attributesAt(size_t dense) const;
+  NODISCARD std::span<const int32_t> valuesAt(size_t dense) const;
+  /***
+   * @description: Copy of region dense as a polygon
+   */
+  NODISCARD Polygon2d polygonAt(size_t dense) const;
+
+  /***
+   * @description: Same as RegionStore::findRelatedMessage
+   * @param flow may be nullptr
+   */
+  void findRelatedMessage(const PolygonPtr& box,
+                          std::vector<uint32_t>* attributes,
+                          std::vector<int32_t>* values,
+                          std::vector<int32_t>* ious,
+                          std::unordered_map<uint32_t, uint32_t>* flow) const;
+  /***
+   * @description: Same as Roi2d::isUseful
+   * @remark compiled ROIs sum the per polygon intersections instead of
+   * dissolving them, equal as ROI polygons do not overlap
+   */
+  NODISCARD bool isUseful(const Vec2d& point) const;
+  NODISCARD bool isUseful(const PolygonPtr& others) const;
+
+ protected:
+  // defined in region_snapshot.cc
+  struct Header;
+  struct PolygonRecord;
+  struct RingRecord;
+  struct GridRecord;
+
+  /***
+   * @description: Polygons of grid whose cell range covers box, ascending
+   */
+  void candidates(const GridRecord* grid, const GBox& box,
+                  std::vector<uint32_t>* polygons) const;
+  NODISCARD bool within(uint32_t polygon, const Vec2d& point) const;
+  NODISCARD Polygon2d materialize(uint32_t polygon, PolygonType type) const;
+  NODISCARD GBox envelopeOf(uint32_t polygon) const;
+  NODISCARD double area(uint32_t polygon) const;
+
+  /***
+   * @description: Clip rings reused over the candidates of one query
+   */
+  struct AreaScratch {
+    explicit AreaScratch(const PolygonPtr& others)
+        : convex(others->inners().empty() &&
+                 isValidConvexRing(others->outer())) {}
+    bool convex;
+    std::vector<Vec2d> input;
+    std::vector<Vec2d> output;
+  };
+  /***
+   * @description: Same as Polygon2d::calculateIntersectionArea, clipped in
+   * place if others is convex
+   */
+  NODISCARD double intersectionArea(uint32_t polygon, const PolygonPtr& others,
+                                    AreaScratch* scratch) const;
+
+  const uint8_t* base_;
+  const Header* header_;
+  const PolygonRecord* polygons_;
+  const RingRecord* rings_;
+  const double* points_;
+  const uint32_t* attributes_;
+  const int32_t* values_;
+  const GridRecord* region_grid_;
+  const GridRecord* roi_grid_;
+  // mapping owned by open
+  void* mapping_;
+  size_t mapping_size_;
+};
+
+}  // namespace geometry
+}  // namespace innovusion
@@ -0,0 +1,148 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-21
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/include/region_store.h
+ */
+#pragma once
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "frame_arena.h"
+#include "polygon2d.h"
+#include "slot_map.h"
+#include "vec2d.h"
+
+namespace innovusion {
+namespace geometry {
+
+/***
+ * @description: Region container with packed attribute / value arrays and an
+ * attribute -> region inverted index. Regions are kept densely in a SlotMap,
+ * attributes of dense region i are attributesAt(i) / valuesAt(i) in the same
+ * order.
+ */
+class RegionStore {
+ public:
+  RegionStore();
+  virtual ~RegionStore() = default;
+
+  /***
+   * @description: Add or replace region
+   * @param index      Key used to distinguish different region
+   * @param outer      Outer boundary of region polygon
+   * @param inners     Inners holes of region polygon
+   * @param attributes Unique attributes
+   * @param values     Values matching attributes
+   * @return true if polygon is valid and attributes are consistent
+   */
+  NODISCARD bool add(size_t index, const std::vector<Vec2d>& outer,
+                     const std::vector<std::vector<Vec2d>>& inners,
+                     const std::vector<uint32_t>& attributes,
+                     const std::vector<int32_t>& values);
+  NODISCARD bool add(size_t index, std::vector<Vec2d>&& outer,
+                     std::vector<std::vector<Vec2d>>&& inners,
+                     const std::vector<uint32_t>& attributes,
+                     const std::vector<int32_t>& values);
+  NODISCARD bool remove(size_t index);
+  void clear();
+
+  NODISCARD inline size_t size() const { return slots_.size(); }
+  NODISCARD inline bool empty() const { return slots_.empty(); }
+  /***
+   * @description: Process wide unique version of the regions, changed by
+   * every successful add / remove / clear and by copy, see ContentVersion
+   */
+  NODISCARD inline uint64_t version() const { return version_.value(); }
+
+  /***
+   * @description: Dense accessors, dense order changes on remove
+   */
+  NODISCARD inline size_t indexAt(size_t dense) const {
+    return indices_[dense];
+  }
+  NODISCARD inline const Polygon2d& polygonAt(size_t dense) const {
+    return polygons_[dense];
+  }
+  NODISCARD inline const GBox& envelopeAt(size_t dense) const {
+    return envelopes_[dense];
+  }
+  NODISCARD std::span<const uint32_t> attributesAt(size_t dense) const;
+  NODISCARD std::span<const int32_t> valuesAt(size_t dense) const;
+
+  /***
+   * @description: Dense index of region
+   * @return false if region does not exist
+   */
+  NODISCARD bool find(size_t index, size_t* dense) const;
+
+  /***
+   * @description: Fill dense indices of regions carrying attribute
+   */
+  void regionsWithAttribute(uint32_t attribute,
+                            std::vector<size_t>* denses) const;
+
+  /***
+   * @description: Append attributes, values and ious (percentage) of every
+   * region overlapping the box, flow counts hits per region index
+   * @param flow may be nullptr
+   */
+  void findRelatedMessage(const PolygonPtr& box,
+                          std::vector<uint32_t>* attributes,
+                          std::vector<int32_t>* values,
+                          std::vector<int32_t>* ious,
+                          std::unordered_map<uint32_t, uint32_t>* flow) const;
+
+  /***
+   * @description: Same as findRelatedMessage but only regions carrying one of
+   * the filter attributes are visited, and only those attributes are appended
+   */
+  void findRelatedMessage(const PolygonPtr& box,
+                          const std::vector<uint32_t>& filter,
+                          std::vector<uint32_t>* attributes,
+                          std::vector<int32_t>* values,
+                          std::vector<int32_t>* ious,
+                          std::unordered_map<uint32_t, uint32_t>* flow) const;
+
+  /***
+   * @description: Same as findRelatedMessage for a per-frame box, overlay
+   * scratch is allocated from arena
+   */
+  void findRelatedMessage(const FrameBox& box, FrameArena* arena,
+                          std::vector<uint32_t>* attributes,
+                          std::vector<int32_t>* values,
+                          std::vector<int32_t>* ious,
+                          std::unordered_map<uint32_t, uint32_t>* flow) const;
+
+ protected:
+  void appendRegion(size_t dense, int32_t rate,
+                    std::vector<uint32_t>* attributes,
+                    std::vector<int32_t>* values, std::vector<int32_t>* ious,
+                    std::unordered_map<uint32_t, uint32_t>* flow) const;
+  NODISCARD int32_t overlapRate(size_t dense, const PolygonPtr& box,
+                                const GBox& envelope) const;
+  void link(size_t dense);
+  void unlink(size_t dense);
+  void erase(size_t dense);
+  void compactAttributes();
+
+  SlotMap slots_;
+  std::unordered_map<size_t, SlotHandle> handles_;
+  // attribute -> handles of regions carrying it
+  std::unordered_map<uint32_t, std::vector<SlotHandle>> inverted_;
+  // dense arrays, all indexed by SlotMap::dense
+  std::vector<size_t> indices_;
+  std::vector<Polygon2d> polygons_;
+  std::vector<GBox> envelopes_;
+  std::vector<uint32_t> attribute_offsets_;
+  std::vector<uint32_t> attribute_counts_;
+  // packed attributes / values, dead ranges are reclaimed by compactAttributes
+  std::vector<uint32_t> attributes_;
+  std::vector<int32_t> values_;
+  size_t dead_attributes_;
+  ContentVersion version_;
+};
+
+}  // namespace geometry
+}  // namespace innovusion
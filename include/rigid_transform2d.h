@@ -0,0 +1,87 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-30
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/include/rigid_transform2d.h
+ */
+#pragma once
+#include <Eigen/Core>
+
+#include "vec2d.h"
+
+namespace innovusion {
+namespace geometry {
+
+/***
+ * @description: Affine map of the (y, z) plane in the RegionMonitor
+ * convention, from region (config) frame to sensor frame, as rotat_trans
+ * moves the region vertices:
+ * apply(p) = {row_y * (p - translation), row_z * (p - translation)}
+ * @remark The rows are the (y, z) block of a 3-D rotation, which is neither
+ * orthonormal nor rigid once the sensor has yaw or pitch; the inverse is the
+ * real 2x2 inverse of that block
+ */
+class RigidTransform2d {
+ public:
+  // identity
+  RigidTransform2d();
+  /***
+   * @remark a singular row block maps everything back to translation
+   */
+  RigidTransform2d(const Vec2d& row_y, const Vec2d& row_z,
+                   const Vec2d& translation);
+  virtual ~RigidTransform2d() = default;
+
+  /***
+   * @description: Same as RegionMonitor::initRtMatrix, rows are the (y, z)
+   * block of the inverted rotation, translation is the (y, z) part of the
+   * last column
+   * @return false if the rotation determinant is not 1 within precision or
+   * the (y, z) block is singular (yaw or pitch of 90 degree)
+   */
+  NODISCARD static bool fromMatrix(const Eigen::Matrix4f& matrix,
+                                   float precision,
+                                   RigidTransform2d* transform);
+
+  /***
+   * @description: Region frame point to sensor frame
+   */
+  NODISCARD inline Vec2d apply(const Vec2d& point) const {
+    const Vec2d offset = point - translation_;
+    return {row_y_ * offset, row_z_ * offset};
+  }
+  /***
+   * @description: Region frame direction to sensor frame
+   */
+  NODISCARD inline Vec2d rotate(const Vec2d& direction) const {
+    return {row_y_ * direction, row_z_ * direction};
+  }
+  /***
+   * @description: Sensor frame point back to region frame
+   */
+  NODISCARD inline Vec2d inverse(const Vec2d& point) const {
+    return inverseRotate(point) + translation_;
+  }
+  /***
+   * @description: Sensor frame direction back to region frame
+   */
+  NODISCARD inline Vec2d inverseRotate(const Vec2d& direction) const {
+    return {inverse_y_ * direction, inverse_z_ * direction};
+  }
+
+  NODISCARD bool isIdentity() const;
+  NODISCARD inline const Vec2d& rowY() const { return row_y_; }
+  NODISCARD inline const Vec2d& rowZ() const { return row_z_; }
+  NODISCARD inline const Vec2d& translation() const { return translation_; }
+
+ private:
+  Vec2d row_y_;
+  Vec2d row_z_;
+  Vec2d translation_;
+  // rows of the inverse of {row_y_, row_z_}
+  Vec2d inverse_y_;
+  Vec2d inverse_z_;
+};
+
+}  // namespace geometry
+}  // namespace innovusion
@@ -0,0 +1,117 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-01
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/include/scan_classifier.h
+ */
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "multiple_polygon2d.h"
+#include "point_view.h"
+#include "spatial_hash.h"
+#include "vec2d.h"
+
+namespace innovusion {
+namespace geometry {
+
+/***
+ * @description: Streaming point in polygon set classifier for scan ordered
+ * points. Consecutive points of a scan are close to each other, so the answer
+ * of the previous point is reused when the segment between both touches no
+ * polygon edge (same face, exactly the same answer), then the polygon which
+ * contained the previous point is tested, and only then the polygons whose
+ * envelope covers the point. Edges and envelopes are indexed by SpatialHash,
+ * rebuilt when the set version changes.
+ * @remark Not thread safe, use one classifier per thread. The set must outlive
+ * the classifier.
+ */
+class ScanClassifier {
+ public:
+  static constexpr int64_t kNone = -1;
+
+  explicit ScanClassifier(const MultiplePolygon2d* polygons);
+  /***
+   * @description: isUseful answers like roi->isUseful(point)
+   */
+  explicit ScanClassifier(const Roi2d* roi);
+  virtual ~ScanClassifier() = default;
+
+  /***
+   * @description: Same as polygons->within(point), a non finite point (invalid
+   * return) is never within and restarts the coherence chain
+   */
+  NODISCARD bool within(const Vec2d& point);
+  NODISCARD inline bool isUseful(const Vec2d& point) {
+    return within(point) != inverted_;
+  }
+  /***
+   * @param result resized to points, 1 if within
+   */
+  void within(std::span<const Vec2d> points, std::vector<uint8_t>* result);
+  void within(const PointView& points, std::vector<uint8_t>* result);
+  /***
+   * @param result resized to points, 1 if useful
+   */
+  void isUseful(std::span<const Vec2d> points, std::vector<uint8_t>* result);
+  void isUseful(const PointView& points, std::vector<uint8_t>* result);
+
+  /***
+   * @description: Dense index of the polygon containing the last point, kNone
+   * if it was outside
+   */
+  NODISCARD inline int64_t lastPolygon() const { return last_polygon_; }
+  /***
+   * @description: Forget the last point, e.g. between two scan lines
+   */
+  void reset();
+
+  /***
+   * @description: Points answered without a full lookup
+   */
+  NODISCARD inline uint64_t hits() const { return hits_; }
+  NODISCARD inline uint64_t misses() const { return misses_; }
+  NODISCARD double hitRate() const;
+  void resetMetrics();
+
+ protected:
+  struct Edge {
+    Vec2d start;
+    Vec2d end;
+  };
+
+  void reindex();
+  /***
+   * @description: Conservative, true if segment from -> to may touch any edge
+   */
+  NODISCARD bool touchesEdge(const Vec2d& from, const Vec2d& to);
+  NODISCARD int64_t lookup(const Vec2d& point);
+  /***
+   * @description: Batch loop shared by span and view inputs
+   */
+  template <typename Points>
+  void classify(const Points& points, bool useful,
+                std::vector<uint8_t>* result);
+
+  const MultiplePolygon2d* polygons_;
+  bool inverted_;
+  uint64_t version_;
+  bool indexed_;
+  std::vector<Edge> edges_;
+  SpatialHash edge_index_;
+  SpatialHash polygon_index_;
+  // previous point
+  bool has_last_;
+  Vec2d last_point_;
+  int64_t last_polygon_;
+  uint64_t hits_;
+  uint64_t misses_;
+  // query scratch
+  std::vector<GBox> envelopes_;
+  std::vector<uint32_t> candidates_;
+};
+
+}  // namespace geometry
+}  // namespace innovusion
@@ -0,0 +1,137 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-04
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/include/shared_region_store.h
+ */
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "multiple_polygon2d.h"
+#include "region_snapshot.h"
+#include "region_store.h"
+
+namespace innovusion {
+namespace geometry {
+
+// control object layout, defined in shared_region_store.cc
+struct SharedRegionControl;
+
+/***
+ * @description: Region configuration shared between processes of one host
+ * through POSIX shared memory. Every published version is an immutable
+ * RegionSnapshot image (offset based, so it is valid at any mapping address)
+ * in its own object "<name>.<generation>". A small control object "<name>"
+ * holds a versioned header and the atomic generation of the latest image.
+ * Publishing writes the new object completely, bumps the generation and
+ * unlinks the previous object, readers still mapping it keep it until they
+ * refresh. Queries touch only the mapping, no copy and no IPC call.
+ * unlink() retires the control object, so readers look the name up again
+ * and follow the next writer's create().
+ * @remark name follows shm_open, e.g. "/regions"
+ */
+class SharedRegionWriter {
+ public:
+  explicit SharedRegionWriter(const std::string& name);
+  virtual ~SharedRegionWriter();
+  SharedRegionWriter(const SharedRegionWriter&) = delete;
+  SharedRegionWriter& operator=(const SharedRegionWriter&) = delete;
+
+  /***
+   * @description: Create the control object, or reuse it and continue its
+   * generation when a previous writer left it
+   * @return false if it could not be created or mapped
+   */
+  NODISCARD bool create();
+  /***
+   * @description: Publish regions and roi as the next generation
+   * @return false if not created or the image could not be written
+   */
+  NODISCARD bool publish(const RegionStore& regions, const Roi2d& roi);
+  /***
+   * @description: Unlink the control object and the latest image, mapped
+   * readers keep working on their current generation
+   */
+  void unlink();
+
+  /***
+   * @return latest published generation, 0 if none
+   */
+  NODISCARD uint64_t generation() const;
+
+ protected:
+  std::string name_;
+  SharedRegionControl* control_;
+};
+
+/***
+ * @description: Read side of SharedRegionWriter
+ * @remark refresh must not run concurrently with queries of the same reader,
+ * e.g. call it once per frame; distinct readers are independent
+ */
+class SharedRegionReader {
+ public:
+  /***
+   * @param verify check the checksum of every newly mapped image
+   */
+  explicit SharedRegionReader(const std::string& name, bool verify = true);
+  virtual ~SharedRegionReader();
+  SharedRegionReader(const SharedRegionReader&) = delete;
+  SharedRegionReader& operator=(const SharedRegionReader&) = delete;
+
+  /***
+   * @description: Map the latest generation if it changed, two atomic loads
+   * when it did not, plus a lookup of the control object name once per
+   * second to notice it was replaced without unlink()
+   * @return true if a snapshot is mapped, possibly an older one when the
+   * latest could not be mapped
+   */
+  NODISCARD bool refresh();
+
+  /***
+   * @return mapped generation, 0 if none
+   */
+  NODISCARD inline uint64_t generation() const { return generation_; }
+  NODISCARD inline const RegionSnapshot& snapshot() const {
+    return *snapshot_;
+  }
+
+  /***
+   * @description: Same as RegionStore::findRelatedMessage and
+   * Roi2d::isUseful on the mapped generation, empty before the first
+   * successful refresh
+   */
+  void findRelatedMessage(const PolygonPtr& box,
+                          std::vector<uint32_t>* attributes,
+                          std::vector<int32_t>* values,
+                          std::vector<int32_t>* ious,
+                          std::unordered_map<uint32_t, uint32_t>* flow) const;
+  NODISCARD bool isUseful(const Vec2d& point) const;
+  NODISCARD bool isUseful(const PolygonPtr& others) const;
+
+ protected:
+  NODISCARD bool attachControl();
+  void detachControl();
+  /***
+   * @description: Rate limited check that name_ still is the mapped object
+   */
+  NODISCARD bool controlReplaced();
+
+  std::string name_;
+  bool verify_;
+  const SharedRegionControl* control_;
+  // identity of the mapped control object
+  uint64_t control_device_;
+  uint64_t control_inode_;
+  std::chrono::steady_clock::time_point next_check_;
+  uint64_t generation_;
+  std::unique_ptr<RegionSnapshot> snapshot_;
+};
+
+}  // namespace geometry
+}  // namespace innovusion
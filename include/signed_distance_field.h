@@ -0,0 +1,76 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-30
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/include/signed_distance_field.h
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "polygon2d.h"
+#include "vec2d.h"
+
+namespace innovusion {
+namespace geometry {
+
+/***
+ * @description: Signed distance to the boundary of a set of non-overlapping
+ * polygons sampled on a regular grid, negative inside. Built by scanline
+ * rasterization of the rings followed by an exact separable squared distance
+ * transform (Felzenszwalb & Huttenlocher), both linear in the number of grid
+ * nodes. Samples are bilinear and off by up to about one resolution, callers
+ * needing more near the boundary refine with the exact distance.
+ */
+class SignedDistanceField {
+ public:
+  SignedDistanceField();
+  virtual ~SignedDistanceField() = default;
+
+  /***
+   * @param resolution grid step
+   * @param padding    margin added around the polygons envelope, at least
+   *                   one resolution
+   * @param max_nodes  build fails instead of allocating a larger grid
+   * @return false if polygons is empty or the grid would be too large, the
+   * field is empty afterwards
+   */
+  NODISCARD bool build(std::span<const Polygon2d> polygons, double resolution,
+                       double padding, size_t max_nodes = size_t(1) << 22);
+  void clear();
+
+  NODISCARD inline bool empty() const { return values_.empty(); }
+  NODISCARD inline double resolution() const { return resolution_; }
+  NODISCARD inline size_t columns() const { return columns_; }
+  NODISCARD inline size_t rows() const { return rows_; }
+
+  /***
+   * @description: Checks if point is inside the grid
+   */
+  NODISCARD bool contains(const Vec2d& point) const;
+
+  /***
+   * @description: Bilinear signed distance, O(1). Outside the grid the value
+   * at the nearest grid point plus the distance to it, an upper bound only.
+   */
+  NODISCARD double sample(const Vec2d& point) const;
+
+ protected:
+  void rasterize(std::span<const Polygon2d> polygons,
+                 std::vector<uint8_t>* inside) const;
+  NODISCARD inline double nodeValue(size_t column, size_t row) const {
+    return values_[row * columns_ + column];
+  }
+
+  Vec2d origin_;
+  double resolution_;
+  size_t columns_;
+  size_t rows_;
+  // node (column, row) is origin_ + (column, row) * resolution_
+  std::vector<float> values_;
+};
+
+}  // namespace geometry
+}  // namespace innovusion
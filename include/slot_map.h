@@ -0,0 +1,123 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-20
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/include/slot_map.h
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "pre_define.h"
+
+namespace innovusion {
+namespace geometry {
+
+/***
+ * @description: Stable handle into a SlotMap, a handle becomes stale once its
+ * element is erased (the slot generation is bumped)
+ */
+struct SlotHandle {
+  uint32_t slot = 0;
+  uint32_t generation = 0;
+
+  NODISCARD bool operator==(const SlotHandle& other) const {
+    return slot == other.slot && generation == other.generation;
+  }
+  NODISCARD bool operator!=(const SlotHandle& other) const {
+    return !(*this == other);
+  }
+};
+
+/***
+ * @description: Process wide unique version of a container content, drawn
+ * from one global counter. Owners bump it on every mutation; a copy draws a
+ * new version, a move carries it and bumps the moved-from one, so equal
+ * versions always mean equal content, even across rebuilt containers.
+ */
+class ContentVersion {
+ public:
+  ContentVersion() : value_(next()) {}
+  ContentVersion(const ContentVersion&) : value_(next()) {}
+  ContentVersion& operator=(const ContentVersion&) {
+    value_ = next();
+    return *this;
+  }
+  ContentVersion(ContentVersion&& other) noexcept : value_(other.value_) {
+    other.bump();
+  }
+  ContentVersion& operator=(ContentVersion&& other) noexcept {
+    if (this != &other) {
+      value_ = other.value_;
+      other.bump();
+    }
+    return *this;
+  }
+
+  inline void bump() { value_ = next(); }
+  NODISCARD inline uint64_t value() const { return value_; }
+
+ private:
+  NODISCARD static uint64_t next();
+
+  uint64_t value_;
+};
+
+/***
+ * @description: Generational slot map which only manages handle <-> dense
+ * index bookkeeping. Owners keep their payload in parallel dense arrays and
+ * mirror the swap-and-pop reported by erase(), so that every payload array
+ * stays contiguous and can be scanned sequentially.
+ */
+class SlotMap {
+ public:
+  SlotMap() = default;
+  virtual ~SlotMap() = default;
+
+  /***
+   * @description: Allocate a new handle, its dense index is always size() - 1
+   * after the call
+   */
+  SlotHandle insert();
+
+  /***
+   * @description: Erase handle, the last dense element is moved into the hole
+   * @param handle element to erase
+   * @param hole   dense index owners must fill with their last element
+   * @return false if handle is stale
+   */
+  NODISCARD bool erase(const SlotHandle& handle, size_t* hole);
+
+  /***
+   * @description: Check if handle is still alive
+   */
+  NODISCARD bool contains(const SlotHandle& handle) const;
+
+  /***
+   * @description: Dense index of an alive handle
+   */
+  NODISCARD size_t dense(const SlotHandle& handle) const;
+
+  /***
+   * @description: Handle owning dense index
+   */
+  NODISCARD SlotHandle handle(size_t dense) const;
+
+  NODISCARD inline size_t size() const { return dense_slot_.size(); }
+  NODISCARD inline bool empty() const { return dense_slot_.empty(); }
+
+  /***
+   * @description: Invalidate every handle and release all dense entries
+   */
+  void clear();
+
+ private:
+  std::vector<uint32_t> slot_dense_;
+  std::vector<uint32_t> slot_generation_;
+  std::vector<uint32_t> dense_slot_;
+  std::vector<uint32_t> free_slots_;
+};
+
+}  // namespace geometry
+}  // namespace innovusion
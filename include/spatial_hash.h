@@ -0,0 +1,173 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-28
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/include/spatial_hash.h
+ */
+#pragma once
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "polygon2d.h"
+#include "vec2d.h"
+
+namespace innovusion {
+namespace geometry {
+
+/***
+ * @description: Inclusive range of grid cells, cell (y, z) spans
+ * [origin + y * cell_size, origin + (y + 1) * cell_size) on each axis
+ */
+struct CellRange {
+  int64_t min_y;
+  int64_t min_z;
+  int64_t max_y;
+  int64_t max_z;
+};
+
+/***
+ * @description: Cells of the grid anchored at origin covered by box
+ * @return false if box is not finite or too far from origin
+ */
+NODISCARD bool gridCellRange(const GBox& box, const Vec2d& origin,
+                             double cell_size, CellRange* range);
+
+/***
+ * @description: Counting sort of items into cells, item i is stored once in
+ * every cell cellOf(y, z) of ranges[i]; an empty range (min > max) stores
+ * nothing. Cell c then holds entries[offsets[c], offsets[c + 1]) ascending.
+ * @param cursor scatter scratch, reused by the caller across calls
+ */
+template <typename CellOf>
+void countingSort(std::span<const CellRange> ranges, size_t cell_count,
+                  CellOf&& cellOf, std::vector<uint32_t>* offsets,
+                  std::vector<uint32_t>* entries,
+                  std::vector<uint32_t>* cursor) {
+  offsets->assign(cell_count + 1, 0);
+  for (const auto& range : ranges) {
+    for (int64_t y = range.min_y; y <= range.max_y; ++y) {
+      for (int64_t z = range.min_z; z <= range.max_z; ++z) {
+        ++(*offsets)[cellOf(y, z) + 1];
+      }
+    }
+  }
+  for (size_t c = 0; c < cell_count; ++c) {
+    (*offsets)[c + 1] += (*offsets)[c];
+  }
+  entries->resize(offsets->back());
+  cursor->assign(offsets->begin(), offsets->end() - 1);
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    const CellRange& range = ranges[i];
+    for (int64_t y = range.min_y; y <= range.max_y; ++y) {
+      for (int64_t z = range.min_z; z <= range.max_z; ++z) {
+        (*entries)[(*cursor)[cellOf(y, z)]++] = static_cast<uint32_t>(i);
+      }
+    }
+  }
+}
+
+/***
+ * @description: Uniform grid spatial hash over per-frame envelopes. Every
+ * envelope is registered in each grid cell it covers, cells are hashed into a
+ * power of two bucket table and the entries of a bucket are stored
+ * contiguously (counting sort), so rebuild is O(n) with two allocations
+ * reused across frames. Items are identified by their position in the
+ * rebuild input.
+ * @remark Queries are const and may run concurrently, rebuild may not
+ */
+class SpatialHash {
+ public:
+  /***
+   * @param cell_size grid step, about the typical object size
+   */
+  explicit SpatialHash(double cell_size = 4.0);
+  virtual ~SpatialHash() = default;
+
+  /***
+   * @description: Cell size matching the objects, mean of the longer side of
+   * the envelopes, 0 if there is none
+   */
+  NODISCARD static double suggestCellSize(std::span<const GBox> envelopes);
+
+  void setCellSize(double cell_size);
+  NODISCARD inline double cellSize() const { return cell_size_; }
+
+  /***
+   * @description: Replace the content with envelopes
+   */
+  void rebuild(std::span<const GBox> envelopes);
+  void rebuild(const std::vector<PolygonPtr>& polygons);
+
+  NODISCARD inline size_t size() const { return envelopes_.size(); }
+  NODISCARD inline const GBox& envelopeAt(uint32_t item) const {
+    return envelopes_[item];
+  }
+
+  /***
+   * @description: Items whose envelope is within radius of point, ascending
+   */
+  void near(const Vec2d& point, double radius,
+            std::vector<uint32_t>* items) const;
+  /***
+   * @description: Items whose envelope is within radius of box, ascending
+   */
+  void near(const GBox& box, double radius,
+            std::vector<uint32_t>* items) const;
+
+  /***
+   * @description: Items whose envelope intersects region, ascending
+   */
+  void overlapping(const GBox& region, std::vector<uint32_t>* items) const;
+
+  /***
+   * @description: Pairs (i < j) whose envelopes are at most distance apart,
+   * sorted
+   */
+  void candidatePairs(double distance,
+                      std::vector<std::pair<uint32_t, uint32_t>>* pairs) const;
+
+  /***
+   * @description: Distance between two envelopes, 0 if they intersect
+   */
+  NODISCARD static double envelopeDistance(const GBox& first,
+                                           const GBox& second);
+
+ protected:
+  /***
+   * @description: Grid cells covered by box
+   * @return false if box is not finite or covers more cells than buckets
+   */
+  NODISCARD bool cellRange(const GBox& box, CellRange* range) const;
+  NODISCARD inline size_t bucketOf(int64_t y, int64_t z) const {
+    const uint64_t hash = static_cast<uint64_t>(y) * 73856093ULL ^
+                          static_cast<uint64_t>(z) * 19349663ULL;
+    return static_cast<size_t>(hash) & (bucket_count_ - 1);
+  }
+  /***
+   * @description: Counting sort of envelopes_ into buckets
+   */
+  void index();
+  /***
+   * @description: Calls visit(item) for every item possibly intersecting
+   * region, an item may be visited more than once
+   */
+  template <typename Visitor>
+  void visitCandidates(const GBox& region, Visitor&& visit) const;
+
+  double cell_size_;
+  size_t bucket_count_;
+  std::vector<GBox> envelopes_;
+  // bucket b holds entries_[offsets_[b], offsets_[b + 1])
+  std::vector<uint32_t> offsets_;
+  std::vector<uint32_t> entries_;
+  // items too large (or not finite) to be bucketed, visited by every query
+  std::vector<uint32_t> oversized_;
+  // per item cells and scatter cursor, reused across rebuilds
+  std::vector<CellRange> ranges_;
+  std::vector<uint32_t> cursor_;
+};
+
+}  // namespace geometry
+}  // namespace innovusion
@@ -0,0 +1,110 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-28
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/include/temporal_iou_cache.h
+ */
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "polygon2d.h"
+#include "vec2d.h"
+
+namespace innovusion {
+namespace geometry {
+
+struct CoherentIouResult {
+  // same as box->iou(region)
+  double iou = 0.0;
+  // same as region.iouSelf(box), i.e. box->iouTarget(region)
+  int iou_target = 0;
+  // true if the overlay was skipped
+  bool cached = false;
+};
+
+/***
+ * @description: Frame to frame memoization of box vs region overlap, keyed by
+ * (track id, region id) and checked against the region container version. A
+ * miss runs the overlay and, when the box is fully
+ * inside or fully outside the region, remembers its ring together with the
+ * distance to the region boundary. A later pose whose vertices all moved less
+ * than that distance cannot have crossed the boundary, so the overlay is
+ * skipped and the result follows from the box area alone.
+ * @remark Not thread safe
+ */
+class TemporalIouCache {
+ public:
+  TemporalIouCache() = default;
+  virtual ~TemporalIouCache() = default;
+
+  /***
+   * @description: Overlap of the current box pose of track with region
+   * @param track     track id
+   * @param region_id region id
+   * @param region_version version of the container holding region,
+   *                  MultiplePolygon2d::version() / RegionStore::version();
+   *                  those are unique across the process, a different version
+   *                  than the cached one for the same id is a miss
+   * @param box       current box pose, its outer ring is compared to the
+   *                  cached one vertex by vertex
+   * @param region    region polygon, e.g. RegionStore::polygonAt
+   */
+  NODISCARD CoherentIouResult query(uint32_t track, uint32_t region_id,
+                                    uint64_t region_version,
+                                    const PolygonPtr& box,
+                                    const Polygon2d& region);
+
+  /***
+   * @description: Drop entries of a finished track / an edited region
+   */
+  void eraseTrack(uint32_t track);
+  void eraseRegion(uint32_t region_id);
+  void clear();
+
+  NODISCARD inline size_t size() const { return entries_.size(); }
+
+  /***
+   * @description: Hit metrics since construction or resetMetrics
+   */
+  NODISCARD inline uint64_t hits() const { return hits_; }
+  NODISCARD inline uint64_t misses() const { return misses_; }
+  NODISCARD double hitRate() const;
+  void resetMetrics();
+
+ protected:
+  enum class Placement : uint8_t {
+    Crossing = 0,
+    Inside = 1,
+    Outside = 2,
+  };
+  struct Entry {
+    uint64_t region_version = 0;
+    double region_area = 0.0;
+    Placement placement = Placement::Crossing;
+    // distance from the cached ring to the region boundary
+    double margin = 0.0;
+    std::vector<Vec2d> ring;
+  };
+
+  NODISCARD static inline uint64_t key(uint32_t track, uint32_t region_id) {
+    return static_cast<uint64_t>(track) << 32 | region_id;
+  }
+  /***
+   * @description: Upper bound of the motion of any boundary point between
+   * two rings with the same vertex count, negative if they do not match
+   */
+  NODISCARD static double displacement(const GRing& current,
+                                       const std::vector<Vec2d>& cached);
+  void refresh(uint64_t region_version, const PolygonPtr& box,
+               const Polygon2d& region, CoherentIouResult* result,
+               Entry* entry);
+
+  std::unordered_map<uint64_t, Entry> entries_;
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+};
+
+}  // namespace geometry
+}  // namespace innovusion
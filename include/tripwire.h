@@ -0,0 +1,127 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-29
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/include/tripwire.h
+ */
+#pragma once
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "polygon2d.h"
+#include "spatial_hash.h"
+#include "vec2d.h"
+
+namespace innovusion {
+namespace geometry {
+
+enum class TripwireDirection : uint8_t {
+  // from the side where (end - start) ^ (point - start) > 0 to the other one
+  Forward = 0,
+  Backward = 1,
+};
+
+struct TripwireTrack {
+  uint32_t track;
+  // reference segment of the box this frame, f_segment() or b_segment()
+  Gsegment segment;
+};
+
+struct TripwireCrossing {
+  uint32_t track;
+  uint32_t line;
+  TripwireDirection direction;
+};
+
+/***
+ * @description: Directional count lines. A track crosses a line when the
+ * midpoint of its reference segment moves across it between two consecutive
+ * frames. A point exactly on the line belongs to neither side: a track
+ * reaching the line is counted only once it leaves it on the other side, a
+ * track touching the line and coming back is not counted. Lines are
+ * indexed by a SpatialHash rebuilt only when lines change, each motion only
+ * tests the lines whose envelope it overlaps.
+ * @remark Not thread safe
+ */
+class TripwireSet {
+ public:
+  TripwireSet();
+  virtual ~TripwireSet() = default;
+
+  /***
+   * @description: Add or replace line
+   * @return false for a degenerated line
+   */
+  NODISCARD bool addLine(uint32_t line, const Vec2d& start, const Vec2d& end);
+  NODISCARD bool removeLine(uint32_t line);
+  NODISCARD inline size_t lineCount() const { return lines_.size(); }
+
+  /***
+   * @description: Advance one frame
+   * @param tracks    every live track of the frame, missing tracks are
+   *                  forgotten and their next appearance starts a new motion
+   * @param crossings cleared, then filled with the crossings of the frame
+   */
+  void update(std::span<const TripwireTrack> tracks,
+              std::vector<TripwireCrossing>* crossings);
+
+  /***
+   * @description: Crossing counts accumulated since the line was added or the
+   * last resetCounts
+   * @return false if line does not exist
+   */
+  NODISCARD bool counts(uint32_t line, uint64_t* forward,
+                        uint64_t* backward) const;
+  void resetCounts();
+
+ protected:
+  struct Line {
+    uint32_t id;
+    Vec2d start;
+    Vec2d end;
+    uint64_t forward;
+    uint64_t backward;
+  };
+  struct Touch {
+    uint32_t line;
+    // side the track came from before reaching the line
+    int side;
+  };
+  struct TrackState {
+    Vec2d previous;
+    uint64_t seen_frame = 0;
+    // lines the track currently sits on, usually empty
+    std::vector<Touch> touching;
+  };
+
+  void reindex();
+  /***
+   * @description: Drop the touches of line, it was replaced or removed
+   */
+  void forget(uint32_t line);
+  /***
+   * @description: 1 on the positive side of line, -1 on the other one, 0 on
+   * the line
+   */
+  NODISCARD static int side(const Line& line, const Vec2d& point);
+  /***
+   * @description: Check the motion from -> to meets the line between its end
+   * points, given that from and to are not strictly on the same side
+   */
+  NODISCARD static bool reaches(const Line& line, const Vec2d& from,
+                                const Vec2d& to);
+
+  std::vector<Line> lines_;
+  SpatialHash index_;
+  bool dirty_;
+  uint64_t frame_;
+  std::unordered_map<uint32_t, TrackState> tracks_;
+  // query scratch
+  std::vector<GBox> envelopes_;
+  std::vector<uint32_t> candidates_;
+};
+
+}  // namespace geometry
+}  // namespace innovusion
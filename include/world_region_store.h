@@ -0,0 +1,121 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-02
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/include/world_region_store.h
+ */
+#pragma once
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "multiple_polygon2d.h"
+#include "region_store.h"
+#include "rigid_transform2d.h"
+#include "vec2d.h"
+
+namespace innovusion {
+namespace geometry {
+
+class WorldRegionStore;
+
+/***
+ * @description: One sensor's window on a WorldRegionStore. The transform is
+ * the one a per sensor RegionMonitor would apply to every region
+ * (initRtMatrix / doRotatTrans), here the query geometry is moved back to the
+ * world frame with its inverse instead. The transform is affine, not rigid,
+ * but IoUs and coverage rates are area ratios, so answers match that monitor.
+ * @remark Cheap to copy, the store must outlive the view
+ */
+class SensorRegionView {
+ public:
+  SensorRegionView();
+  SensorRegionView(const WorldRegionStore* store,
+                   const RigidTransform2d& transform);
+  virtual ~SensorRegionView() = default;
+
+  /***
+   * @description: RegionStore::findRelatedMessage for a sensor frame box
+   */
+  void findRelatedMessage(const PolygonPtr& box,
+                          std::vector<uint32_t>* attributes,
+                          std::vector<int32_t>* values,
+                          std::vector<int32_t>* ious,
+                          std::unordered_map<uint32_t, uint32_t>* flow) const;
+  NODISCARD bool isUseful(const PolygonPtr& others) const;
+  NODISCARD bool isUseful(const Vec2d& point) const;
+
+  /***
+   * @description: Sensor frame geometry to world frame
+   */
+  NODISCARD inline Vec2d toWorld(const Vec2d& point) const {
+    return transform_.inverse(point);
+  }
+  NODISCARD PolygonPtr toWorld(const PolygonPtr& polygon) const;
+
+  NODISCARD inline bool valid() const { return store_ != nullptr; }
+  NODISCARD inline const RigidTransform2d& transform() const {
+    return transform_;
+  }
+
+ private:
+  const WorldRegionStore* store_;
+  RigidTransform2d transform_;
+  bool identity_;
+};
+
+/***
+ * @description: Regions and ROI of all sensors stored once in the world
+ * frame. Every sensor registers its transform and queries through a
+ * SensorRegionView, so memory and update cost do not grow with the sensor
+ * count and an add / remove is seen by every sensor at once.
+ * @remark Updates take an exclusive lock, queries a shared one
+ */
+class WorldRegionStore {
+ public:
+  /***
+   * @param roi_interested see Roi2d
+   * @param roi_rate       see Roi2d
+   */
+  explicit WorldRegionStore(bool roi_interested = true, int roi_rate = 50);
+  virtual ~WorldRegionStore() = default;
+
+  /***
+   * @description: Add or replace world frame region, see RegionStore::add
+   */
+  NODISCARD bool add(size_t index, const std::vector<Vec2d>& outer,
+                     const std::vector<std::vector<Vec2d>>& inners,
+                     const std::vector<uint32_t>& attributes,
+                     const std::vector<int32_t>& values);
+  NODISCARD bool remove(size_t index);
+  NODISCARD bool addRoi(size_t index, const std::vector<Vec2d>& outer,
+                        const std::vector<std::vector<Vec2d>>& inners);
+  NODISCARD bool removeRoi(size_t index);
+
+  /***
+   * @description: Add or replace sensor
+   * @param transform world to sensor frame, see SensorRegionView
+   */
+  void addSensor(uint32_t sensor, const RigidTransform2d& transform);
+  NODISCARD bool removeSensor(uint32_t sensor);
+  /***
+   * @return false if sensor is unknown
+   */
+  NODISCARD bool view(uint32_t sensor, SensorRegionView* view) const;
+
+  NODISCARD size_t size() const;
+  NODISCARD size_t roiSize() const;
+  NODISCARD size_t sensorCount() const;
+
+ private:
+  friend class SensorRegionView;
+
+  mutable std::shared_mutex mutex_;
+  RegionStore regions_;
+  Roi2d roi_;
+  std::unordered_map<uint32_t, RigidTransform2d> sensors_;
+};
+
+}  // namespace geometry
+}  // namespace innovusion
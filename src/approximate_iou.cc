@@ -0,0 +1,171 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-22
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/src/approximate_iou.cc
+ */
+#include "approximate_iou.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace innovusion {
+namespace geometry {
+
+ApproximateIou::ApproximateIou(double error, size_t max_rows)
+    : error_(error), max_rows_(std::max<size_t>(max_rows, 1)) {}
+
+ApproximateIouResult ApproximateIou::estimate(const Polygon2d& first,
+                                              const Polygon2d& second,
+                                              double threshold) {
+  ApproximateIouResult result;
+  // lay rows in the box frame so that box edges are parallel to the rows
+  Vec2d axis(1.0, 0.0);
+  if (first.type() == PolygonType::Box) {
+    const Gsegment front = first.f_segment();
+    const Vec2d direction = front.second - front.first;
+    if (!direction.isZeroVector()) {
+      axis = direction / direction.norm();
+    }
+  }
+  GBox first_envelope;
+  GBox second_envelope;
+  loadEdges(first, axis, &first_edges_, &first_envelope);
+  loadEdges(second, axis, &second_edges_, &second_envelope);
+
+  const double first_area = first.area();
+  const double second_area = second.area();
+  const double low = std::max(first_envelope.min_corner().z,
+                              second_envelope.min_corner().z);
+  const double high = std::min(first_envelope.max_corner().z,
+                               second_envelope.max_corner().z);
+  if (first_area <= 0 || second_area <= 0 || high <= low ||
+      envelopeOverlapArea(first_envelope, second_envelope) <= 0) {
+    return result;
+  }
+
+  const double extent = lateralExtent(first_edges_, low, high) +
+                        lateralExtent(second_edges_, low, high);
+  // iou = I / (A + B - I) has slope at most (A + B) / max(A, B)^2
+  const double max_area = std::max(first_area, second_area);
+  const double min_area = std::min(first_area, second_area);
+  const double sum_area = first_area + second_area;
+  const double tolerance = error_ * max_area * max_area / sum_area;
+  size_t rows = 1;
+  if (tolerance > 0) {
+    rows = static_cast<size_t>(std::ceil((high - low) * extent / tolerance));
+  } else {
+    rows = max_rows_;
+  }
+  rows = std::clamp<size_t>(rows, 1, max_rows_);
+
+  const double height = (high - low) / static_cast<double>(rows);
+  double intersection = 0.0;
+  for (size_t row = 0; row < rows; ++row) {
+    const double z = low + (static_cast<double>(row) + 0.5) * height;
+    crossings(first_edges_, z, &first_crossings_);
+    crossings(second_edges_, z, &second_crossings_);
+    intersection +=
+        height * overlapLength(first_crossings_, second_crossings_);
+  }
+  intersection = std::clamp(intersection, 0.0, min_area);
+
+  const double delta = height * extent;
+  auto iou = [&](double value) { return value / (sum_area - value); };
+  result.iou = iou(intersection);
+  const double lower = iou(std::max(0.0, intersection - delta));
+  const double upper = iou(std::min(min_area, intersection + delta));
+  result.error = std::max(upper - result.iou, result.iou - lower);
+  result.ambiguous = result.iou - result.error < threshold &&
+                     threshold <= result.iou + result.error;
+  return result;
+}
+
+bool ApproximateIou::iouAtLeast(const PolygonPtr& first,
+                                const PolygonPtr& second, double threshold) {
+  const ApproximateIouResult result = estimate(*first, *second, threshold);
+  if (!result.ambiguous) {
+    return result.iou >= threshold;
+  }
+  return first->iouAtLeast(second, threshold);
+}
+
+void ApproximateIou::loadEdges(const Polygon2d& polygon, const Vec2d& axis,
+                               std::vector<Edge>* edges,
+                               GBox* envelope) const {
+  edges->clear();
+  bg::assign_inverse(*envelope);
+  auto to_frame = [&axis](const Vec2d& point) {
+    return Vec2d(point * axis, axis ^ point);
+  };
+  auto load_ring = [&](const GRing& ring) {
+    for (size_t i = 0; i + 1 < ring.size(); ++i) {
+      const Vec2d from = to_frame(ring[i]);
+      edges->push_back({from, to_frame(ring[i + 1])});
+      bg::expand(*envelope, from);
+    }
+  };
+  const GPolygon& source = polygon.getPolygon();
+  load_ring(source.outer());
+  for (const auto& inner : source.inners()) {
+    load_ring(inner);
+  }
+}
+
+void ApproximateIou::crossings(const std::vector<Edge>& edges, double z,
+                               std::vector<double>* values) const {
+  values->clear();
+  for (const auto& edge : edges) {
+    if ((edge.from.z > z) != (edge.to.z > z)) {
+      values->emplace_back(edge.from.y + (z - edge.from.z) *
+                                             (edge.to.y - edge.from.y) /
+                                             (edge.to.z - edge.from.z));
+    }
+  }
+  std::sort(values->begin(), values->end());
+}
+
+double ApproximateIou::lateralExtent(const std::vector<Edge>& edges,
+                                     double low, double high) const {
+  double extent = 0.0;
+  for (const auto& edge : edges) {
+    const double dy = std::fabs(edge.to.y - edge.from.y);
+    const double z_min = std::min(edge.from.z, edge.to.z);
+    const double z_max = std::max(edge.from.z, edge.to.z);
+    if (z_max - z_min < kGeometryEpsilon) {
+      // edges lying on the band limits never split a row
+      if (z_min > low + kGeometryEpsilon && z_min < high - kGeometryEpsilon) {
+        extent += dy;
+      }
+    } else {
+      const double inside = std::min(z_max, high) - std::max(z_min, low);
+      if (inside > 0) {
+        extent += dy * inside / (z_max - z_min);
+      }
+    }
+  }
+  return extent;
+}
+
+double ApproximateIou::overlapLength(const std::vector<double>& first,
+                                     const std::vector<double>& second) const {
+  double length = 0.0;
+  size_t i = 0;
+  size_t j = 0;
+  while (i + 1 < first.size() && j + 1 < second.size()) {
+    const double begin = std::max(first[i], second[j]);
+    const double end = std::min(first[i + 1], second[j + 1]);
+    if (end > begin) {
+      length += end - begin;
+    }
+    if (first[i + 1] < second[j + 1]) {
+      i += 2;
+    } else {
+      j += 2;
+    }
+  }
+  return length;
+}
+
+}  // namespace geometry
+}  // namespace innovusion
@@ -0,0 +1,174 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-27
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/src/cluster_geometry.cc
+ */
+#include "cluster_geometry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace innovusion {
+namespace geometry {
+
+namespace {
+// positive if o -> a -> b turns counter clockwise
+inline double cross(const Vec2d& o, const Vec2d& a, const Vec2d& b) {
+  return (a - o) ^ (b - o);
+}
+
+uint32_t headingToSpindle(const Vec2d& heading) {
+  // a box is symmetric, keep the heading in [0, 180) degree
+  double angle = std::atan2(heading.y, heading.z);
+  if (angle < 0) {
+    angle += M_PI;
+  }
+  return static_cast<uint32_t>(std::lround(angle * 18000 / M_PI)) % 18000;
+}
+}  // namespace
+
+size_t convexHull(std::span<Vec2d> points, std::span<Vec2d> hull) {
+  const size_t size = points.size();
+  if (size == 0 || hull.size() < size + 1) {
+    return 0;
+  }
+  std::sort(points.begin(), points.end(), [](const Vec2d& a, const Vec2d& b) {
+    return a.y < b.y || (a.y == b.y && a.z < b.z);
+  });
+  if (size == 1) {
+    hull[0] = points[0];
+    return 1;
+  }
+
+  size_t k = 0;
+  for (size_t i = 0; i < size; ++i) {
+    while (k >= 2 && cross(hull[k - 2], hull[k - 1], points[i]) <= 0) {
+      --k;
+    }
+    hull[k++] = points[i];
+  }
+  for (size_t i = size - 1, lower = k + 1; i-- > 0;) {
+    while (k >= lower && cross(hull[k - 2], hull[k - 1], points[i]) <= 0) {
+      --k;
+    }
+    hull[k++] = points[i];
+  }
+  // last point repeats the first one
+  size_t count = k - 1;
+  if (count == 2 && hull[0] == hull[1]) {
+    count = 1;
+  }
+  // counter clockwise to clockwise
+  std::reverse(hull.begin(), hull.begin() + count);
+  return count;
+}
+
+bool minimumAreaBox(std::span<const Vec2d> hull, BoxParameters* box) {
+  const size_t size = hull.size();
+  if (size == 0) {
+    return false;
+  }
+  if (size == 1) {
+    *box = BoxParameters{hull[0], 0.0, 0.0, 0};
+    return true;
+  }
+  if (size == 2) {
+    const Vec2d direction = hull[1] - hull[0];
+    box->center = (hull[0] + hull[1]) / 2;
+    box->length = direction.norm();
+    box->width = 0.0;
+    box->spindle = headingToSpindle(direction);
+    return true;
+  }
+
+  double best_area = std::numeric_limits<double>::max();
+  Vec2d best_origin;
+  Vec2d best_u(0.0, 1.0);
+  Vec2d best_n(1.0, 0.0);
+  double best_min_u = 0.0;
+  double best_max_u = 0.0;
+  double best_max_n = 0.0;
+
+  // calipers: farthest along edge, farthest from edge, farthest behind edge
+  size_t right = 0;
+  size_t top = 0;
+  size_t left = 0;
+  bool initialized = false;
+  for (size_t i = 0; i < size; ++i) {
+    const Vec2d& origin = hull[i];
+    const Vec2d edge = hull[(i + 1) % size] - origin;
+    const double edge_length = edge.norm();
+    if (edge_length < kGeometryEpsilon) {
+      continue;
+    }
+    const Vec2d u = edge / edge_length;
+    // clockwise ring, inward normal is on the right of the edge
+    const Vec2d n(u.z, -u.y);
+    auto along = [&](size_t j) { return (hull[j] - origin) * u; };
+    auto away = [&](size_t j) { return (hull[j] - origin) * n; };
+
+    if (!initialized) {
+      for (size_t j = 1; j < size; ++j) {
+        right = along(j) > along(right) ? j : right;
+        top = away(j) > away(top) ? j : top;
+        left = along(j) < along(left) ? j : left;
+      }
+      initialized = true;
+    } else {
+      for (size_t step = 0;
+           step < size && along((right + 1) % size) >= along(right); ++step) {
+        right = (right + 1) % size;
+      }
+      for (size_t step = 0;
+           step < size && away((top + 1) % size) >= away(top); ++step) {
+        top = (top + 1) % size;
+      }
+      for (size_t step = 0;
+           step < size && along((left + 1) % size) <= along(left); ++step) {
+        left = (left + 1) % size;
+      }
+    }
+
+    const double min_u = along(left);
+    const double max_u = along(right);
+    const double max_n = away(top);
+    const double area = (max_u - min_u) * max_n;
+    if (area < best_area) {
+      best_area = area;
+      best_origin = origin;
+      best_u = u;
+      best_n = n;
+      best_min_u = min_u;
+      best_max_u = max_u;
+      best_max_n = max_n;
+    }
+  }
+
+  const double extent_u = best_max_u - best_min_u;
+  box->center = best_origin + best_u * ((best_min_u + best_max_u) / 2) +
+                best_n * (best_max_n / 2);
+  if (extent_u >= best_max_n) {
+    box->length = extent_u;
+    box->width = best_max_n;
+    box->spindle = headingToSpindle(best_u);
+  } else {
+    box->length = best_max_n;
+    box->width = extent_u;
+    box->spindle = headingToSpindle(best_n);
+  }
+  return true;
+}
+
+bool fitBox(std::span<Vec2d> points, std::span<Vec2d> buffer,
+            BoxParameters* box) {
+  const size_t count = convexHull(points, buffer);
+  if (count == 0) {
+    return false;
+  }
+  return minimumAreaBox(buffer.first(count), box);
+}
+
+}  // namespace geometry
+}  // namespace innovusion
@@ -0,0 +1,158 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-25
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/src/frame_arena.cc
+ */
+#include "frame_arena.h"
+
+#include <algorithm>
+#include <cmath>
+#include <new>
+
+namespace innovusion {
+namespace geometry {
+
+namespace {
+// twice the signed area, positive for counter clockwise rings
+template <typename Range>
+double doubleSignedArea(const Range& ring) {
+  double sum = 0.0;
+  const size_t size = ring.size();
+  for (size_t i = 0; i < size; ++i) {
+    const Vec2d& current = ring[i];
+    const Vec2d& next = ring[(i + 1) % size];
+    sum += current ^ next;
+  }
+  return sum;
+}
+}  // namespace
+
+double FrameBox::area() const {
+  // ring is closed, the closing point adds a null term
+  return -doubleSignedArea(ring()) / 2;
+}
+
+GBox FrameBox::envelope() const {
+  GBox box;
+  bg::assign_inverse(box);
+  for (size_t i = 0; i + 1 < kRingSize; ++i) {
+    bg::expand(box, corners_[i]);
+  }
+  return box;
+}
+
+bool FrameBox::within(const Vec2d& point) const {
+  for (size_t i = 0; i + 1 < kRingSize; ++i) {
+    // clockwise ring, interior is on the right of every edge
+    if (((corners_[i + 1] - corners_[i]) ^ (point - corners_[i])) >=
+        -kGeometryEpsilon) {
+      return false;
+    }
+  }
+  return true;
+}
+
+double FrameBox::calculateIntersectionArea(const Polygon2d& polygon,
+                                           FrameArena* arena) const {
+  if (envelopeOverlapArea(envelope(), polygon.envelope()) <= 0) {
+    return 0.0;
+  }
+  // Sutherland-Hodgman against a convex clip region keeps the signed area of
+  // any subject ring exact, degenerate edges along the box cancel out
+  const GPolygon& source = polygon.getPolygon();
+  size_t capacity = source.outer().size();
+  for (const auto& inner : source.inners()) {
+    capacity = std::max(capacity, inner.size());
+  }
+  capacity = 2 * capacity + 2 * kRingSize;
+  auto input = arena->makeVector<Vec2d>(capacity);
+  auto output = arena->makeVector<Vec2d>(capacity);
+
+  auto clip = [&](const GRing& ring) {
+    // open ring
+    output.assign(ring.begin(), ring.end());
+    if (output.size() > 1 && output.front() == output.back()) {
+      output.pop_back();
+    }
+    for (size_t c = 0; c + 1 < kRingSize && !output.empty(); ++c) {
+      const Vec2d& a = corners_[c];
+      const Vec2d edge = corners_[c + 1] - a;
+      input.swap(output);
+      output.clear();
+      const size_t size = input.size();
+      for (size_t i = 0; i < size; ++i) {
+        const Vec2d& current = input[i];
+        const Vec2d& next = input[(i + 1) % size];
+        const double current_side = edge ^ (current - a);
+        const double next_side = edge ^ (next - a);
+        if (current_side <= 0) {
+          output.emplace_back(current);
+        }
+        if ((current_side < 0 && next_side > 0) ||
+            (current_side > 0 && next_side < 0)) {
+          const double ratio = current_side / (current_side - next_side);
+          output.emplace_back(current + (next - current) * ratio);
+        }
+      }
+    }
+    return -doubleSignedArea(output) / 2;
+  };
+
+  double sum_area = clip(source.outer());
+  for (const auto& inner : source.inners()) {
+    sum_area += clip(inner);
+  }
+  return std::max(sum_area, 0.0);
+}
+
+double FrameBox::iou(const Polygon2d& polygon, FrameArena* arena) const {
+  double intersection_area = calculateIntersectionArea(polygon, arena);
+  if (intersection_area > 0) {
+    return intersection_area /
+           (area() + polygon.area() - intersection_area);
+  } else {
+    return 0;
+  }
+}
+
+int FrameBox::iouTarget(const Polygon2d& others, FrameArena* arena) const {
+  double intersection_area = calculateIntersectionArea(others, arena);
+  if (intersection_area > 0) {
+    return std::round((intersection_area / others.area()) * 100);
+  } else {
+    return 0;
+  }
+}
+
+int FrameBox::iouSelf(const Polygon2d& others, FrameArena* arena) const {
+  double intersection_area = calculateIntersectionArea(others, arena);
+  if (intersection_area > 0) {
+    return std::round((intersection_area / area()) * 100);
+  } else {
+    return 0;
+  }
+}
+
+FrameArena::FrameArena(size_t initial_bytes,
+                       std::pmr::memory_resource* upstream)
+    : initial_(std::max<size_t>(initial_bytes, 1)),
+      resource_(initial_.data(), initial_.size(), upstream) {}
+
+FrameBox FrameArena::makeBox(const Vec2d& center, double length, double width,
+                             uint32_t spindle) {
+  void* memory = resource_.allocate(sizeof(Vec2d) * FrameBox::kRingSize,
+                                    alignof(Vec2d));
+  Vec2d* corners = static_cast<Vec2d*>(memory);
+  for (size_t i = 0; i < FrameBox::kRingSize; ++i) {
+    new (corners + i) Vec2d();
+  }
+  boxCorners(center, length, width, spindle, corners);
+  corners[4] = corners[0];
+  return FrameBox(corners);
+}
+
+void FrameArena::reset() { resource_.release(); }
+
+}  // namespace geometry
+}  // namespace innovusion
@@ -1,81 +1,611 @@
 /***
  * @Copyright [2023] <Innovusion Inc.>
- * @LastEditTime: 2023-09-13
+ * @LastEditTime: 2023-09-20
  * @LastEditors: Tianyun Xuan
  * @FilePath: geometry/src/multiple_polygon2d.cc
  */
 
 #include "multiple_polygon2d.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
 namespace innovusion {
 namespace geometry {
 
-MultiplePolygon2d::MultiplePolygon2d() : polygons_({}) {}
+namespace {
+/***
+ * @description: Winding number test of point against a closed ring
+ * @return -1 outside, 0 on the ring, 1 inside
+ */
+int ringSide(std::span<const Vec2d> ring, const Vec2d& point) {
+  int winding = 0;
+  for (size_t i = 0; i + 1 < ring.size(); ++i) {
+    const Vec2d& first = ring[i];
+    const Vec2d& second = ring[i + 1];
+    // the boost within / covered_by side strategy, so both paths agree on
+    // points within rounding of an edge
+    const int side = bg::strategy::side::side_by_triangle<>::apply(
+        first, second, point);
+    if (side == 0 && point.y >= std::min(first.y, second.y) &&
+        point.y <= std::max(first.y, second.y) &&
+        point.z >= std::min(first.z, second.z) &&
+        point.z <= std::max(first.z, second.z)) {
+      return 0;
+    }
+    if (first.z <= point.z) {
+      winding += (second.z > point.z && side > 0);
+    } else {
+      winding -= (second.z <= point.z && side < 0);
+    }
+  }
+  return winding != 0 ? 1 : -1;
+}
+}  // namespace
+
+MultiplePolygon2d::MultiplePolygon2d()
+    : dead_vertices_(0),
+      field_resolution_(0.0),
+      field_refine_(0.0) {}
+
+MultiplePolygon2d::MultiplePolygon2d(const MultiplePolygon2d& other)
+    : MultiplePolygon2d() {
+  assign(other);
+}
+
+MultiplePolygon2d& MultiplePolygon2d::operator=(
+    const MultiplePolygon2d& other) {
+  if (this != &other) {
+    assign(other);
+  }
+  return *this;
+}
+
+MultiplePolygon2d::MultiplePolygon2d(MultiplePolygon2d&& other) noexcept
+    : MultiplePolygon2d() {
+  assign(std::move(other));
+}
+
+MultiplePolygon2d& MultiplePolygon2d::operator=(
+    MultiplePolygon2d&& other) noexcept {
+  if (this != &other) {
+    assign(std::move(other));
+  }
+  return *this;
+}
+
+void MultiplePolygon2d::assign(const MultiplePolygon2d& other) {
+  slots_ = other.slots_;
+  handles_ = other.handles_;
+  indices_ = other.indices_;
+  polygons_ = other.polygons_;
+  envelopes_ = other.envelopes_;
+  areas_ = other.areas_;
+  vertex_offsets_ = other.vertex_offsets_;
+  vertex_counts_ = other.vertex_counts_;
+  vertices_ = other.vertices_;
+  dead_vertices_ = other.dead_vertices_;
+  version_.bump();
+  field_resolution_ = other.field_resolution_;
+  field_refine_ = other.field_refine_;
+  field_ = other.field_;
+  index_ = other.index_;
+}
+
+void MultiplePolygon2d::assign(MultiplePolygon2d&& other) {
+  slots_ = std::move(other.slots_);
+  handles_ = std::move(other.handles_);
+  indices_ = std::move(other.indices_);
+  polygons_ = std::move(other.polygons_);
+  envelopes_ = std::move(other.envelopes_);
+  areas_ = std::move(other.areas_);
+  vertex_offsets_ = std::move(other.vertex_offsets_);
+  vertex_counts_ = std::move(other.vertex_counts_);
+  vertices_ = std::move(other.vertices_);
+  dead_vertices_ = other.dead_vertices_;
+  // same content, other is left empty under a new version
+  version_ = std::move(other.version_);
+  other.slots_ = SlotMap();
+  other.handles_.clear();
+  other.indices_.clear();
+  other.polygons_.clear();
+  other.envelopes_.clear();
+  other.areas_.clear();
+  other.vertex_offsets_.clear();
+  other.vertex_counts_.clear();
+  other.vertices_.clear();
+  other.dead_vertices_ = 0;
+  field_resolution_ = other.field_resolution_;
+  field_refine_ = other.field_refine_;
+  field_ = std::move(other.field_);
+  other.field_.clear();
+  index_ = std::move(other.index_);
+  other.index_.rebuild(other.envelopes_);
+}
 
 bool MultiplePolygon2d::add(size_t index, const std::vector<Vec2d>& outer,
                             const std::vector<std::vector<Vec2d>>& inners) {
-  PolygonPtr ptr_polygon =
-      std::make_shared<Polygon2d>(PolygonType::Polygon, outer, inners);
+  return add(index, std::vector<Vec2d>(outer),
+             std::vector<std::vector<Vec2d>>(inners));
+}
+
+bool MultiplePolygon2d::add(size_t index, std::vector<Vec2d>&& outer,
+                            std::vector<std::vector<Vec2d>>&& inners) {
+  Polygon2d polygon(PolygonType::Polygon, std::move(outer), std::move(inners));
 
-  if (!ptr_polygon->isValid()) {
+  if (!polygon.isValid()) {
     return false;
   }  // Not valid polygon
 
-  const auto& it = polygons_.find(index);
+  const GBox envelope = polygon.envelope();
+  const auto it = handles_.find(index);
 
-  if (it == polygons_.end()) {
-    if (overlaped(ptr_polygon)) {
+  if (it == handles_.end()) {
+    if (overlaped(polygon, envelope, size())) {
       return false;
-    } else {
-      polygons_.emplace(index, ptr_polygon);
-      return true;
     }
+    const SlotHandle handle = slots_.insert();
+    indices_.emplace_back(index);
+    polygons_.emplace_back(std::move(polygon));
+    envelopes_.emplace_back();
+    areas_.emplace_back();
+    vertex_offsets_.emplace_back();
+    vertex_counts_.emplace_back(0);
+    handles_.emplace(index, handle);
+    refresh(slots_.dense(handle));
+    version_.bump();
+    updateCaches();
+    return true;
   } else {
-    // if exist we need to remove current first than check for overlaped
-    auto temp_ptr = it->second;
-    polygons_.erase(it);
-    if (overlaped(ptr_polygon)) {
-      polygons_[index] = temp_ptr;  // recover
+    // if exist the current one is skipped while checking for overlaped
+    const size_t dense = slots_.dense(it->second);
+    if (overlaped(polygon, envelope, dense)) {
       return false;
-    } else {
-      polygons_[index] = ptr_polygon;  // replace
-      return true;
     }
+    polygons_[dense] = std::move(polygon);  // replace
+    refresh(dense);
+    version_.bump();
+    updateCaches();
+    return true;
   }
 }
 
 bool MultiplePolygon2d::remove(size_t index) {
-  return polygons_.erase(index) == 1;
+  const auto it = handles_.find(index);
+  if (it == handles_.end()) {
+    return false;
+  }
+  size_t hole = 0;
+  if (!slots_.erase(it->second, &hole)) {
+    return false;
+  }
+  handles_.erase(it);
+  erase(hole);
+  version_.bump();
+  updateCaches();
+  return true;
+}
+
+bool MultiplePolygon2d::find(size_t index, SlotHandle* handle) const {
+  const auto it = handles_.find(index);
+  if (it == handles_.end()) {
+    return false;
+  }
+  *handle = it->second;
+  return true;
+}
+
+std::span<const Vec2d> MultiplePolygon2d::outerAt(size_t dense) const {
+  return {vertices_.data() + vertex_offsets_[dense], vertex_counts_[dense]};
+}
+
+void MultiplePolygon2d::refresh(size_t dense) {
+  const Polygon2d& stored = polygons_[dense];
+  envelopes_[dense] = stored.envelope();
+  areas_[dense] = stored.area();
+
+  dead_vertices_ += vertex_counts_[dense];
+  const auto& outer = bg::exterior_ring(stored.getPolygon());
+  vertex_offsets_[dense] = static_cast<uint32_t>(vertices_.size());
+  vertex_counts_[dense] = static_cast<uint32_t>(outer.size());
+  vertices_.insert(vertices_.end(), outer.begin(), outer.end());
+  if (dead_vertices_ > vertices_.size() / 2) {
+    compactVertices();
+  }
+}
+
+void MultiplePolygon2d::erase(size_t dense) {
+  dead_vertices_ += vertex_counts_[dense];
+  const size_t last = indices_.size() - 1;
+  if (dense != last) {
+    indices_[dense] = indices_[last];
+    polygons_[dense] = std::move(polygons_[last]);
+    envelopes_[dense] = envelopes_[last];
+    areas_[dense] = areas_[last];
+    vertex_offsets_[dense] = vertex_offsets_[last];
+    vertex_counts_[dense] = vertex_counts_[last];
+  }
+  indices_.pop_back();
+  polygons_.pop_back();
+  envelopes_.pop_back();
+  areas_.pop_back();
+  vertex_offsets_.pop_back();
+  vertex_counts_.pop_back();
+  if (dead_vertices_ > vertices_.size() / 2) {
+    compactVertices();
+  }
+}
+
+void MultiplePolygon2d::compactVertices() {
+  std::vector<Vec2d> packed;
+  packed.reserve(vertices_.size() - dead_vertices_);
+  for (size_t i = 0; i < vertex_offsets_.size(); ++i) {
+    const auto begin = vertices_.begin() + vertex_offsets_[i];
+    vertex_offsets_[i] = static_cast<uint32_t>(packed.size());
+    packed.insert(packed.end(), begin, begin + vertex_counts_[i]);
+  }
+  vertices_.swap(packed);
+  dead_vertices_ = 0;
 }
 
 bool MultiplePolygon2d::overlaped(const PolygonPtr& polygon) const {
-  return iouTarget(polygon) > 0;
+  return iouTargetAtLeast(polygon, 1);
+}
+
+bool MultiplePolygon2d::overlaped(const Polygon2d& polygon,
+                                  const GBox& envelope, size_t skip) const {
+  const double target_area = polygon.area();
+  if (target_area <= 0) {
+    return false;
+  }
+  const GPolygon& target = polygon.getPolygon();
+  std::vector<GPolygon> intersections{};
+  for (size_t i = 0; i < envelopes_.size(); ++i) {
+    if (i == skip || bg::disjoint(envelopes_[i], envelope)) {
+      continue;
+    }
+    intersections.clear();
+    bg::intersection(polygons_[i].getPolygon(), target, intersections);
+    double sum_area = 0.0;
+    for (const auto& poly : intersections) {
+      sum_area += bg::area(poly);
+    }
+    if (std::round((sum_area / target_area) * 100) > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename Distance>
+void MultiplePolygon2d::nearest(const GBox& envelope, size_t k,
+                                double max_distance, Distance&& distance,
+                                std::vector<NearestPolygon>* result) const {
+  result->clear();
+  if (k == 0 || envelopes_.empty() || !(max_distance >= 0)) {
+    return;
+  }
+  const SpatialHash& index = envelopeIndex();
+  const auto greater = [](const auto& a, const auto& b) {
+    return a.first > b.first;
+  };
+  std::vector<uint32_t> items{};
+  // (lower bound, dense index) min heap, kept across radius expansions
+  std::vector<std::pair<double, size_t>> heap{};
+  double reached = -1.0;
+  double radius = std::min(index.cellSize(), max_distance);
+  while (true) {
+    // near() returns exactly the envelopes within radius, the ones within
+    // reached are in the heap or popped already
+    index.near(envelope, radius, &items);
+    for (const auto& item : items) {
+      const double bound =
+          SpatialHash::envelopeDistance(envelopes_[item], envelope);
+      if (bound > reached) {
+        heap.emplace_back(bound, item);
+        std::push_heap(heap.begin(), heap.end(), greater);
+      }
+    }
+    reached = radius;
+    const bool complete =
+        radius >= max_distance || items.size() == envelopes_.size();
+    // polygons not reached yet are farther than radius, pop what is inside
+    while (!heap.empty() && (complete || heap.front().first <= radius)) {
+      const auto [bound, dense] = heap.front();
+      if (bound > max_distance ||
+          (result->size() == k && bound >= result->back().distance)) {
+        return;
+      }
+      std::pop_heap(heap.begin(), heap.end(), greater);
+      heap.pop_back();
+      const double exact = distance(dense);
+      if (exact > max_distance ||
+          (result->size() == k && exact >= result->back().distance)) {
+        continue;
+      }
+      // k is small, keep result sorted by insertion
+      const NearestPolygon found{indices_[dense], dense, exact};
+      const auto position = std::upper_bound(
+          result->begin(), result->end(), exact,
+          [](double value, const NearestPolygon& other) {
+            return value < other.distance;
+          });
+      result->insert(position, found);
+      if (result->size() > k) {
+        result->pop_back();
+      }
+    }
+    if (complete ||
+        (result->size() == k && result->back().distance <= radius)) {
+      return;
+    }
+    radius = std::min(2 * radius, max_distance);
+  }
+}
+
+void MultiplePolygon2d::nearest(const Vec2d& point, size_t k,
+                                double max_distance,
+                                std::vector<NearestPolygon>* result) const {
+  nearest(
+      GBox(point, point), k, max_distance,
+      [&](size_t dense) {
+        return bg::distance(point, polygons_[dense].getPolygon());
+      },
+      result);
+}
+
+void MultiplePolygon2d::nearest(const PolygonPtr& polygon, size_t k,
+                                double max_distance,
+                                std::vector<NearestPolygon>* result) const {
+  const GPolygon& target = polygon->getPolygon();
+  nearest(
+      polygon->envelope(), k, max_distance,
+      [&](size_t dense) {
+        return bg::distance(target, polygons_[dense].getPolygon());
+      },
+      result);
+}
+
+bool MultiplePolygon2d::nearest(const Vec2d& point, double max_distance,
+                                NearestPolygon* result) const {
+  std::vector<NearestPolygon> found{};
+  nearest(point, 1, max_distance, &found);
+  if (found.empty()) {
+    return false;
+  }
+  *result = found.front();
+  return true;
+}
+
+bool MultiplePolygon2d::nearest(const PolygonPtr& polygon,
+                                double max_distance,
+                                NearestPolygon* result) const {
+  std::vector<NearestPolygon> found{};
+  nearest(polygon, 1, max_distance, &found);
+  if (found.empty()) {
+    return false;
+  }
+  *result = found.front();
+  return true;
+}
+
+void MultiplePolygon2d::enableDistanceField(double resolution,
+                                            double refine_distance) {
+  field_resolution_ = resolution;
+  field_refine_ = refine_distance;
+  buildDistanceField();
+}
+
+void MultiplePolygon2d::updateCaches() {
+  index_.setCellSize(SpatialHash::suggestCellSize(envelopes_));
+  index_.rebuild(envelopes_);
+  buildDistanceField();
+}
+
+void MultiplePolygon2d::buildDistanceField() {
+  // padding covers the refinement band around the outermost polygons
+  if (field_resolution_ <= 0 ||
+      !field_.build(polygons_, field_resolution_,
+                    field_refine_ + 2 * field_resolution_)) {
+    field_.clear();
+  }
+}
+
+double MultiplePolygon2d::signedDistance(const Vec2d& point) const {
+  const SignedDistanceField* field = distanceField();
+  if (field != nullptr && field->contains(point)) {
+    const double approximate = field->sample(point);
+    if (std::abs(approximate) >= field_refine_) {
+      return approximate;
+    }
+  }
+  return exactSignedDistance(point);
+}
+
+double MultiplePolygon2d::exactSignedDistance(const Vec2d& point) const {
+  for (size_t i = 0; i < envelopes_.size(); ++i) {
+    if (bg::covered_by(point, envelopes_[i]) && polygons_[i].covered(point)) {
+      return -boundaryDistance(point, polygons_[i].getPolygon());
+    }
+  }
+  std::vector<NearestPolygon> found{};
+  nearest(point, 1, std::numeric_limits<double>::max(), &found);
+  return found.empty() ? std::numeric_limits<double>::max()
+                       : found.front().distance;
 }
 
 int MultiplePolygon2d::iouTarget(const PolygonPtr& others) const {
-  return std::accumulate(polygons_.begin(), polygons_.end(), 0,
-                         [&](int sum, const auto& ptr) {
-                           return sum + ptr.second->iouTarget(others);
-                         });
+  const GBox envelope = others->envelope();
+  int sum = 0;
+  for (size_t i = 0; i < envelopes_.size(); ++i) {
+    if (!bg::disjoint(envelopes_[i], envelope)) {
+      sum += polygons_[i].iouTarget(others);
+    }
+  }
+  return sum;
+}
+
+bool MultiplePolygon2d::iouTargetAtLeast(const PolygonPtr& others,
+                                         int percent) const {
+  if (percent <= 0) {
+    return true;
+  }
+  const double target_area = others->area();
+  if (target_area <= 0) {
+    return false;
+  }
+  const GBox envelope = others->envelope();
+  // (upper bound, dense index), the rounded upper bound can only be larger
+  // than the rounded exact term
+  std::vector<std::pair<int, size_t>> candidates{};
+  int remaining = 0;
+  for (size_t i = 0; i < envelopes_.size(); ++i) {
+    const double bound =
+        std::min({envelopeOverlapArea(envelopes_[i], envelope), areas_[i],
+                  target_area});
+    const int term = static_cast<int>(std::round((bound / target_area) * 100));
+    if (term > 0) {
+      candidates.emplace_back(term, i);
+      remaining += term;
+    }
+  }
+  if (remaining < percent) {
+    return false;
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const auto& a, const auto& b) { return a.first > b.first; });
+  int sum = 0;
+  for (const auto& [bound, dense] : candidates) {
+    remaining -= bound;
+    sum += polygons_[dense].iouTarget(others);
+    if (sum >= percent) {
+      return true;
+    }
+    if (sum + remaining < percent) {
+      return false;
+    }
+  }
+  return false;
 }
 
 bool MultiplePolygon2d::within(const Vec2d& point) const {
-  return std::any_of(polygons_.begin(), polygons_.end(), [&](const auto& ptr) {
-    return ptr.second->within(point);
-  });
+  for (size_t i = 0; i < envelopes_.size(); ++i) {
+    if (!bg::covered_by(point, envelopes_[i]) ||
+        ringSide(outerAt(i), point) <= 0) {
+      continue;
+    }
+    // holes are rare, only then the full polygon is visited
+    if (polygons_[i].inners().empty() || polygons_[i].within(point)) {
+      return true;
+    }
+  }
+  return false;
 }
 
 bool MultiplePolygon2d::covered(const Vec2d& point) const {
-  return std::any_of(polygons_.begin(), polygons_.end(), [&](const auto& ptr) {
-    return ptr.second->covered(point);
-  });
+  for (size_t i = 0; i < envelopes_.size(); ++i) {
+    if (!bg::covered_by(point, envelopes_[i]) ||
+        ringSide(outerAt(i), point) < 0) {
+      continue;
+    }
+    if (polygons_[i].inners().empty() || polygons_[i].covered(point)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+Roi2d::Roi2d(const Roi2d& other)
+    : MultiplePolygon2d(other),
+      intreseted_(other.intreseted_),
+      rate_(other.rate_),
+      compiled_(other.compiled_),
+      union_(other.union_),
+      union_envelope_(other.union_envelope_) {}
+
+Roi2d& Roi2d::operator=(const Roi2d& other) {
+  if (this != &other) {
+    MultiplePolygon2d::operator=(other);
+    intreseted_ = other.intreseted_;
+    rate_ = other.rate_;
+    compiled_ = other.compiled_;
+    union_ = other.union_;
+    union_envelope_ = other.union_envelope_;
+  }
+  return *this;
+}
+
+Roi2d::Roi2d(Roi2d&& other) noexcept
+    : MultiplePolygon2d(std::move(other)),
+      intreseted_(other.intreseted_),
+      rate_(other.rate_),
+      compiled_(other.compiled_),
+      union_(std::move(other.union_)),
+      union_envelope_(other.union_envelope_) {
+  other.union_.clear();
+}
+
+Roi2d& Roi2d::operator=(Roi2d&& other) noexcept {
+  if (this != &other) {
+    MultiplePolygon2d::operator=(std::move(other));
+    intreseted_ = other.intreseted_;
+    rate_ = other.rate_;
+    compiled_ = other.compiled_;
+    union_ = std::move(other.union_);
+    union_envelope_ = other.union_envelope_;
+    other.union_.clear();
+  }
+  return *this;
 }
 
 bool Roi2d::isUseful(const PolygonPtr& others) const {
-  bool result = iouTarget(others) > rate_;
+  bool result = compiled_ ? coverage(others) > rate_
+                          : iouTargetAtLeast(others, rate_ + 1);
   return intreseted_ ? result : !result;
 }
 
+double Roi2d::coverage(const PolygonPtr& others) const {
+  const double target_area = others->area();
+  if (union_.empty() || target_area <= 0 ||
+      envelopeOverlapArea(union_envelope_, others->envelope()) <= 0) {
+    return 0.0;
+  }
+  GMultiPolygon intersections{};
+  bg::intersection(union_, others->getPolygon(), intersections);
+  return bg::area(intersections) / target_area * 100;
+}
+
+void Roi2d::updateCaches() {
+  MultiplePolygon2d::updateCaches();
+  union_.clear();
+  if (!compiled_) {
+    return;
+  }
+  // pairwise cascade keeps every union step between similarly sized inputs
+  std::vector<GMultiPolygon> level(polygons_.size());
+  for (size_t i = 0; i < polygons_.size(); ++i) {
+    level[i].emplace_back(polygons_[i].getPolygon());
+  }
+  while (level.size() > 1) {
+    std::vector<GMultiPolygon> next((level.size() + 1) / 2);
+    for (size_t i = 0; i + 1 < level.size(); i += 2) {
+      bg::union_(level[i], level[i + 1], next[i / 2]);
+    }
+    if (level.size() % 2 == 1) {
+      next.back().swap(level.back());
+    }
+    level.swap(next);
+  }
+  if (!level.empty()) {
+    union_.swap(level.front());
+  }
+  if (!union_.empty()) {
+    union_envelope_ = bg::return_envelope<GBox>(union_);
+  }
+}
+
 bool Roi2d::isUseful(const Vec2d& point) const {
   return intreseted_ ? within(point) : !within(point);
 }
@@ -0,0 +1,167 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-01
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/src/point_partition.cc
+ */
+#include "point_partition.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+
+namespace innovusion {
+namespace geometry {
+
+namespace {
+// smaller chunks are not worth a thread
+constexpr size_t kMinChunkPoints = 4096;
+
+inline size_t maxThreads() {
+#ifdef _OPENMP
+  return static_cast<size_t>(omp_get_max_threads());
+#else
+  return 1;
+#endif
+}
+}  // namespace
+
+PointPartition::PointPartition(bool parallel)
+    : parallel_(parallel), chunks_(0) {
+  offsets_.assign(1, 0);
+}
+
+void PointPartition::bind(const MultiplePolygon2d& polygons) {
+  regions_.clear();
+  envelopes_.clear();
+  for (size_t i = 0; i < polygons.size(); ++i) {
+    regions_.emplace_back(&polygons.polygonAt(i));
+    envelopes_.emplace_back(polygons.envelopeAt(i));
+  }
+  index();
+}
+
+void PointPartition::bind(const RegionStore& regions) {
+  regions_.clear();
+  envelopes_.clear();
+  for (size_t i = 0; i < regions.size(); ++i) {
+    regions_.emplace_back(&regions.polygonAt(i));
+    envelopes_.emplace_back(regions.envelopeAt(i));
+  }
+  index();
+}
+
+void PointPartition::bind(const std::vector<PolygonPtr>& regions) {
+  regions_.clear();
+  envelopes_.clear();
+  for (const auto& region : regions) {
+    regions_.emplace_back(region.get());
+    envelopes_.emplace_back(region->envelope());
+  }
+  index();
+}
+
+void PointPartition::index() {
+  index_.setCellSize(SpatialHash::suggestCellSize(envelopes_));
+  index_.rebuild(envelopes_);
+  offsets_.assign(regions_.size() + 1, 0);
+  indices_.clear();
+}
+
+template <typename Points>
+void PointPartition::classify(const Points& points, bool keep_hits) {
+  const size_t regions = regions_.size();
+  const size_t threads = parallel_ ? maxThreads() : 1;
+  chunks_ = std::clamp(points.size() / kMinChunkPoints, size_t(1), threads);
+  chunk_counts_.assign(chunks_ * regions, 0);
+  hits_.resize(chunks_);
+  const size_t chunk_size = (points.size() + chunks_ - 1) / chunks_;
+
+#pragma omp parallel for schedule(static, 1) if (chunks_ > 1)
+  for (size_t chunk = 0; chunk < chunks_; ++chunk) {
+    uint32_t* counts = chunk_counts_.data() + chunk * regions;
+    std::vector<Hit>& hits = hits_[chunk];
+    hits.clear();
+    std::vector<uint32_t> candidates{};
+    const size_t end = std::min(points.size(), (chunk + 1) * chunk_size);
+    for (size_t i = chunk * chunk_size; i < end; ++i) {
+      const Vec2d point = points[i];
+      index_.overlapping(GBox(point, point), &candidates);
+      for (const auto& region : candidates) {
+        if (!regions_[region]->within(point)) {
+          continue;
+        }
+        ++counts[region];
+        if (keep_hits) {
+          hits.push_back({static_cast<uint32_t>(i), region});
+        }
+      }
+    }
+  }
+}
+
+void PointPartition::partition(std::span<const Vec2d> points) {
+  classify(points, true);
+  scatter();
+}
+
+void PointPartition::partition(const PointView& points) {
+  classify(points, true);
+  scatter();
+}
+
+void PointPartition::scatter() {
+  const size_t regions = regions_.size();
+  // region major prefix sum, chunk c of region r starts at cursor[c][r]
+  offsets_.assign(regions + 1, 0);
+  std::vector<uint32_t> cursor(chunks_ * regions);
+  uint32_t total = 0;
+  for (size_t region = 0; region < regions; ++region) {
+    offsets_[region] = total;
+    for (size_t chunk = 0; chunk < chunks_; ++chunk) {
+      cursor[chunk * regions + region] = total;
+      total += chunk_counts_[chunk * regions + region];
+    }
+  }
+  offsets_[regions] = total;
+
+  indices_.resize(total);
+  for (size_t chunk = 0; chunk < chunks_; ++chunk) {
+    uint32_t* starts = cursor.data() + chunk * regions;
+    for (const auto& [point, region] : hits_[chunk]) {
+      indices_[starts[region]++] = point;
+    }
+  }
+}
+
+void PointPartition::count(std::span<const Vec2d> points,
+                           std::vector<uint32_t>* counts) {
+  classify(points, false);
+  sum(counts);
+}
+
+void PointPartition::count(const PointView& points,
+                           std::vector<uint32_t>* counts) {
+  classify(points, false);
+  sum(counts);
+}
+
+void PointPartition::sum(std::vector<uint32_t>* counts) const {
+  const size_t regions = regions_.size();
+  counts->assign(regions, 0);
+  for (size_t chunk = 0; chunk < chunks_; ++chunk) {
+    for (size_t region = 0; region < regions; ++region) {
+      (*counts)[region] += chunk_counts_[chunk * regions + region];
+    }
+  }
+}
+
+std::span<const uint32_t> PointPartition::pointsOf(size_t region) const {
+  return {indices_.data() + offsets_[region],
+          offsets_[region + 1] - offsets_[region]};
+}
+
+}  // namespace geometry
+}  // namespace innovusion
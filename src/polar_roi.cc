@@ -0,0 +1,121 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-30
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/src/polar_roi.cc
+ */
+#include "polar_roi.h"
+
+#include <limits>
+#include <utility>
+
+namespace innovusion {
+namespace geometry {
+
+namespace {
+// ranges > 0 where the ray origin + range * direction crosses ring, with a
+// half open side rule so a ring vertex on the ray is crossed once
+void rayCrossings(const Vec2d& origin, const Vec2d& direction,
+                  const GRing& ring, std::vector<float>* ranges) {
+  for (size_t i = 0; i + 1 < ring.size(); ++i) {
+    const Vec2d& a = ring[i];
+    const Vec2d& b = ring[i + 1];
+    const double side_a = direction ^ (a - origin);
+    const double side_b = direction ^ (b - origin);
+    if ((side_a > 0) == (side_b > 0)) {
+      continue;
+    }
+    const Vec2d crossing = a + (b - a) * (side_a / (side_a - side_b));
+    const double range = (crossing - origin) * direction;
+    if (range > 0) {
+      ranges->emplace_back(static_cast<float>(range));
+    }
+  }
+}
+
+bool rayMissesBox(const Vec2d& origin, const Vec2d& direction,
+                  const GBox& box) {
+  // slab test on the ray range [0, inf)
+  double low = 0.0;
+  double high = std::numeric_limits<double>::max();
+  const double starts[2] = {origin.y, origin.z};
+  const double steps[2] = {direction.y, direction.z};
+  const double mins[2] = {box.min_corner().y, box.min_corner().z};
+  const double maxs[2] = {box.max_corner().y, box.max_corner().z};
+  for (int axis = 0; axis < 2; ++axis) {
+    if (std::abs(steps[axis]) < kGeometryEpsilon) {
+      if (starts[axis] < mins[axis] || starts[axis] > maxs[axis]) {
+        return true;
+      }
+      continue;
+    }
+    double enter = (mins[axis] - starts[axis]) / steps[axis];
+    double leave = (maxs[axis] - starts[axis]) / steps[axis];
+    if (enter > leave) {
+      std::swap(enter, leave);
+    }
+    low = std::max(low, enter);
+    high = std::min(high, leave);
+  }
+  return low > high;
+}
+}  // namespace
+
+PolarRoiTable::PolarRoiTable()
+    : origin_(0.0, 0.0), bins_(0), bin_scale_(0.0), interested_(true) {}
+
+bool PolarRoiTable::build(const Roi2d& roi, const RigidTransform2d& transform,
+                          const Vec2d& origin, uint32_t bins) {
+  bins_ = 0;
+  offsets_.clear();
+  bounds_.clear();
+  if (bins == 0) {
+    return false;
+  }
+  origin_ = origin;
+  bin_scale_ = bins / (2 * M_PI);
+  interested_ = roi.interested();
+
+  // rays are traced in region frame, where the ROI polygons are
+  const Vec2d start = transform.inverse(origin);
+  std::vector<float> ranges{};
+  offsets_.reserve(bins + 1);
+  offsets_.emplace_back(0);
+  for (uint32_t bin = 0; bin < bins; ++bin) {
+    const double azimuth = -M_PI + (bin + 0.5) / bin_scale_;
+    const Vec2d direction =
+        transform.inverseRotate(Vec2d(std::sin(azimuth), std::cos(azimuth)));
+    ranges.clear();
+    for (size_t i = 0; i < roi.size(); ++i) {
+      if (rayMissesBox(start, direction, roi.envelopeAt(i))) {
+        continue;
+      }
+      const Polygon2d& polygon = roi.polygonAt(i);
+      rayCrossings(start, direction, polygon.outer(), &ranges);
+      for (const auto& inner : polygon.inners()) {
+        rayCrossings(start, direction, inner, &ranges);
+      }
+    }
+    std::sort(ranges.begin(), ranges.end());
+    if (ranges.size() % 2 == 1) {
+      // the ray starts inside, enter at range 0
+      bounds_.emplace_back(0.0f);
+    }
+    bounds_.insert(bounds_.end(), ranges.begin(), ranges.end());
+    offsets_.emplace_back(static_cast<uint32_t>(bounds_.size()));
+  }
+  bins_ = bins;
+  return true;
+}
+
+bool PolarRoiTable::isUseful(const Vec2d& point) const {
+  const Vec2d offset = point - origin_;
+  return isUseful(azimuthOf(offset), offset.norm());
+}
+
+std::span<const float> PolarRoiTable::boundsAt(uint32_t bin) const {
+  return {bounds_.data() + offsets_[bin], offsets_[bin + 1] - offsets_[bin]};
+}
+
+}  // namespace geometry
+}  // namespace innovusion
@@ -8,35 +8,171 @@
 
 #include <boost/geometry/algorithms/assign.hpp>
 #include <boost/geometry/geometry.hpp>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <utility>
 
 namespace innovusion {
 namespace geometry {
 
 namespace bg = boost::geometry;
 
-Polygon2d::Polygon2d(PolygonType type, const Vec2d& center, double length,
-                     double width, uint32_t spindle)
-    : type_(type) {
-  const float value_cos = cos(spindle * M_PI / 18000);
-  const float value_sin = sin(spindle * M_PI / 18000);
+double envelopeOverlapArea(const GBox& first, const GBox& second) {
+  const double dy =
+      std::min(first.max_corner().y, second.max_corner().y) -
+      std::max(first.min_corner().y, second.min_corner().y);
+  const double dz =
+      std::min(first.max_corner().z, second.max_corner().z) -
+      std::max(first.min_corner().z, second.min_corner().z);
+  return (dy > 0 && dz > 0) ? dy * dz : 0.0;
+}
+
+namespace {
+constexpr uint32_t kSpindleResolution = 36000;
+
+// cos / sin of every 0.01 degree spindle, stored in float as the box corners
+// have always been computed in float
+struct SpindleTable {
+  SpindleTable() {
+    for (uint32_t i = 0; i < kSpindleResolution; ++i) {
+      cos_value[i] = cos(i * M_PI / 18000);
+      sin_value[i] = sin(i * M_PI / 18000);
+    }
+  }
+  float cos_value[kSpindleResolution];
+  float sin_value[kSpindleResolution];
+};
+
+const SpindleTable& spindleTable() {
+  static const SpindleTable table;
+  return table;
+}
+
+inline void fillBoxCorners(const SpindleTable& table, const Vec2d& center,
+                           double length, double width, uint32_t spindle,
+                           Vec2d* corners) {
+  float value_cos;
+  float value_sin;
+  if (spindle < kSpindleResolution) LIKELY {
+    value_cos = table.cos_value[spindle];
+    value_sin = table.sin_value[spindle];
+  } else {
+    value_cos = cos(spindle * M_PI / 18000);
+    value_sin = sin(spindle * M_PI / 18000);
+  }
   const float cos_y = value_cos * width / 2;
   const float cos_z = value_cos * length / 2;
   const float sin_y = value_sin * width / 2;
   const float sin_z = value_sin * length / 2;
-  std::vector<Vec2d> bbox = {{cos_y + sin_z, -sin_y + cos_z},
-                             {cos_y + (-sin_z), -sin_y + (-cos_z)},
-                             {-cos_y + (-sin_z), sin_y + (-cos_z)},
-                             {-cos_y + sin_z, sin_y + cos_z}};
-
-  // use transform to replace loop
-  std::transform(bbox.begin(), bbox.end(), bbox.begin(),
-                 [&center](const Vec2d& point) { return point + center; });
-
-  f_segment_ = {bbox[3], bbox[0]};
-  b_segment_ = {bbox[1], bbox[2]};
-  setOuter(bbox);
-  correct();
+  corners[0] = Vec2d(cos_y + sin_z, -sin_y + cos_z) + center;
+  corners[1] = Vec2d(cos_y + (-sin_z), -sin_y + (-cos_z)) + center;
+  corners[2] = Vec2d(-cos_y + (-sin_z), sin_y + (-cos_z)) + center;
+  corners[3] = Vec2d(-cos_y + sin_z, sin_y + cos_z) + center;
+}
+}  // namespace
+
+void boxCorners(const Vec2d& center, double length, double width,
+                uint32_t spindle, Vec2d* corners) {
+  fillBoxCorners(spindleTable(), center, length, width, spindle, corners);
+}
+
+bool isValidConvexRing(const GRing& ring) {
+  const size_t size = ring.size();
+  if (size < 4 || ring.front() != ring.back()) {
+    return false;
+  }
+  const size_t edges = size - 1;
+  // every turn strictly clockwise and the edge direction sweeps each axis
+  // sign at most twice, which rules out multi turn (star) rings
+  size_t y_flips = 0;
+  size_t z_flips = 0;
+  int last_y_sign = 0;
+  int last_z_sign = 0;
+  for (size_t i = 0; i < edges; ++i) {
+    const Vec2d& current = ring[i];
+    if (!std::isfinite(current.y) || !std::isfinite(current.z)) {
+      return false;
+    }
+    const Vec2d edge = ring[i + 1] - current;
+    const Vec2d next = ring[(i + 2) % size == 0 ? 1 : i + 2] - ring[i + 1];
+    if ((edge ^ next) >= -kGeometryEpsilon) {
+      return false;
+    }
+    const int y_sign = (edge.y > 0) - (edge.y < 0);
+    const int z_sign = (edge.z > 0) - (edge.z < 0);
+    if (y_sign != 0) {
+      y_flips += (last_y_sign != 0 && y_sign != last_y_sign);
+      last_y_sign = y_sign;
+    }
+    if (z_sign != 0) {
+      z_flips += (last_z_sign != 0 && z_sign != last_z_sign);
+      last_z_sign = z_sign;
+    }
+  }
+  return y_flips <= 2 && z_flips <= 2;
+}
+
+double boundaryDistance(const Vec2d& point, const GPolygon& polygon) {
+  double distance = std::numeric_limits<double>::max();
+  auto visit = [&](const GRing& ring) {
+    for (size_t i = 0; i + 1 < ring.size(); ++i) {
+      const Vec2d edge = ring[i + 1] - ring[i];
+      const Vec2d offset = point - ring[i];
+      const double length = edge * edge;
+      const double t =
+          length > 0 ? std::clamp((offset * edge) / length, 0.0, 1.0) : 0.0;
+      distance = std::min(distance, (offset - edge * t).norm());
+    }
+  };
+  visit(polygon.outer());
+  for (const auto& inner : polygon.inners()) {
+    visit(inner);
+  }
+  return distance;
+}
+
+bool batchBoxCorners(std::span<const Vec2d> centers,
+                     std::span<const double> lengths,
+                     std::span<const double> widths,
+                     std::span<const uint32_t> spindles,
+                     std::span<Vec2d> rings) {
+  const size_t size = centers.size();
+  if (lengths.size() != size || widths.size() != size ||
+      spindles.size() != size || rings.size() < size * kBoxRingSize) {
+    return false;
+  }
+  const SpindleTable& table = spindleTable();
+  for (size_t i = 0; i < size; ++i) {
+    Vec2d* ring = rings.data() + i * kBoxRingSize;
+    fillBoxCorners(table, centers[i], lengths[i], widths[i], spindles[i],
+                   ring);
+    ring[4] = ring[0];
+  }
+  return true;
+}
+
+Polygon2d::Polygon2d(PolygonType type, const Vec2d& center, double length,
+                     double width, uint32_t spindle)
+    : type_(type) {
+  GRing& outer = polygon_.outer();
+  outer.resize(kBoxRingSize);
+  boxCorners(center, length, width, spindle, outer.data());
+  outer[4] = outer[0];
+
+  f_segment_ = {outer[3], outer[0]};
+  b_segment_ = {outer[1], outer[2]};
+  // positive sizes give a clockwise closed ring, closing it is all correct()
+  // would do. The corners are computed in float, so a huge size overflows
+  // and a tiny one collapses them: only a ring passing the convex check is
+  // known valid, anything else (e.g. a negative length reversing the ring)
+  // goes through correct() and the full validity check
+  if (length > 0 && width > 0 && isValidConvexRing(outer)) {
+    validity_.store(Validity::Valid, std::memory_order_relaxed);
+  } else {
+    correct();
+  }
 }
 
 Polygon2d::Polygon2d(PolygonType type, const std::vector<Vec2d>& outer,
@@ -47,8 +183,73 @@ Polygon2d::Polygon2d(PolygonType type, const std::vector<Vec2d>& outer,
   correct();
 }
 
+Polygon2d::Polygon2d(PolygonType type, std::vector<Vec2d>&& outer,
+                     std::vector<std::vector<Vec2d>>&& inners)
+    : type_(type) {
+  setOuter(std::move(outer));
+  setInners(std::move(inners));
+  correct();
+}
+
+Polygon2d::Polygon2d(PolygonType type, std::span<const Vec2d> outer,
+                     std::span<const std::vector<Vec2d>> inners)
+    : type_(type) {
+  polygon_.outer().assign(outer.begin(), outer.end());
+  polygon_.inners().resize(inners.size());
+  for (size_t i = 0; i < inners.size(); ++i) {
+    polygon_.inners()[i].assign(inners[i].begin(), inners[i].end());
+  }
+  correct();
+}
+
+Polygon2d::Polygon2d(PolygonType type, GPolygon&& polygon)
+    : type_(type), polygon_(std::move(polygon)) {
+  correct();
+}
+
+Polygon2d::Polygon2d(const Polygon2d& other)
+    : type_(other.type_),
+      polygon_(other.polygon_),
+      f_segment_(other.f_segment_),
+      b_segment_(other.b_segment_),
+      validity_(other.validity_.load(std::memory_order_relaxed)) {}
+
+Polygon2d& Polygon2d::operator=(const Polygon2d& other) {
+  type_ = other.type_;
+  polygon_ = other.polygon_;
+  f_segment_ = other.f_segment_;
+  b_segment_ = other.b_segment_;
+  validity_.store(other.validity_.load(std::memory_order_relaxed),
+                  std::memory_order_relaxed);
+  return *this;
+}
+
+Polygon2d::Polygon2d(Polygon2d&& other) noexcept
+    : type_(other.type_),
+      polygon_(std::move(other.polygon_)),
+      f_segment_(other.f_segment_),
+      b_segment_(other.b_segment_),
+      validity_(other.validity_.load(std::memory_order_relaxed)) {}
+
+Polygon2d& Polygon2d::operator=(Polygon2d&& other) noexcept {
+  type_ = other.type_;
+  polygon_ = std::move(other.polygon_);
+  f_segment_ = other.f_segment_;
+  b_segment_ = other.b_segment_;
+  validity_.store(other.validity_.load(std::memory_order_relaxed),
+                  std::memory_order_relaxed);
+  return *this;
+}
+
 void Polygon2d::setOuter(const std::vector<Vec2d>& outer) {
   bg::assign_points(polygon_, outer);
+  invalidate();
+}
+
+void Polygon2d::setOuter(std::vector<Vec2d>&& outer) {
+  // GRing is a std::vector<Vec2d>, take over the buffer
+  static_cast<std::vector<Vec2d>&>(polygon_.outer()) = std::move(outer);
+  invalidate();
 }
 
 void Polygon2d::setInners(const std::vector<std::vector<Vec2d>>& inners) {
@@ -57,15 +258,41 @@ void Polygon2d::setInners(const std::vector<std::vector<Vec2d>>& inners) {
   for (size_t i = 0; i < inners.size(); ++i, ++inner) {
     bg::assign_points(*inner, inners[i]);
   }
+  invalidate();
 }
 
-void Polygon2d::correct() { bg::correct(polygon_); }
+void Polygon2d::setInners(std::vector<std::vector<Vec2d>>&& inners) {
+  polygon_.inners().resize(inners.size());
+  for (size_t i = 0; i < inners.size(); ++i) {
+    static_cast<std::vector<Vec2d>&>(polygon_.inners()[i]) =
+        std::move(inners[i]);
+  }
+  invalidate();
+}
 
-bool Polygon2d::isValid() const { return bg::is_valid(polygon_); }
+void Polygon2d::correct() {
+  bg::correct(polygon_);
+  invalidate();
+}
+
+bool Polygon2d::isValid() const {
+  const Validity cached = validity_.load(std::memory_order_relaxed);
+  if (cached != Validity::Unknown) {
+    return cached == Validity::Valid;
+  }
+  const bool valid =
+      (polygon_.inners().empty() && isValidConvexRing(polygon_.outer())) ||
+      bg::is_valid(polygon_);
+  validity_.store(valid ? Validity::Valid : Validity::Invalid,
+                  std::memory_order_relaxed);
+  return valid;
+}
 
 double Polygon2d::area() const { return bg::area(polygon_); }
 
-GPolygon Polygon2d::getPolygon() const { return polygon_; }
+const GPolygon& Polygon2d::getPolygon() const { return polygon_; }
+
+GBox Polygon2d::envelope() const { return bg::return_envelope<GBox>(polygon_); }
 
 double Polygon2d::calculateIntersectionArea(const PolygonPtr& polygon) const {
   std::vector<GPolygon> intersections{};
@@ -104,6 +331,38 @@ int Polygon2d::iouSelf(const PolygonPtr& others) const {
   }
 }
 
+bool Polygon2d::iouAtLeast(const PolygonPtr& polygon, double threshold) const {
+  if (threshold <= 0) {
+    return true;
+  }
+  const double self_area = area();
+  const double other_area = polygon->area();
+  const double bound =
+      std::min({envelopeOverlapArea(envelope(), polygon->envelope()),
+                self_area, other_area});
+  if (bound <= 0 || bound / (self_area + other_area - bound) < threshold) {
+    return false;
+  }
+  return iou(polygon) >= threshold;
+}
+
+bool Polygon2d::iouTargetAtLeast(const PolygonPtr& others, int percent) const {
+  if (percent <= 0) {
+    return true;
+  }
+  const double target_area = others->area();
+  if (target_area <= 0) {
+    return false;
+  }
+  const double bound = std::min(
+      {envelopeOverlapArea(envelope(), others->envelope()), area(),
+       target_area});
+  if (std::round((bound / target_area) * 100) < percent) {
+    return false;
+  }
+  return iouTarget(others) >= percent;
+}
+
 bool Polygon2d::within(const Vec2d& point) const {
   return bg::within(point, polygon_);
 }
@@ -0,0 +1,174 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-02
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/src/prism_set.cc
+ */
+#include "prism_set.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace innovusion {
+namespace geometry {
+
+namespace {
+constexpr HeightRange kEmptyHeight{std::numeric_limits<double>::max(),
+                                   std::numeric_limits<double>::lowest()};
+}  // namespace
+
+PrismSet::PrismSet() : height_(kEmptyHeight) {}
+
+bool PrismSet::add(size_t index, const std::vector<Vec2d>& outer,
+                   const std::vector<std::vector<Vec2d>>& inners,
+                   const HeightRange& height) {
+  if (!(height.low <= height.high)) {
+    return false;
+  }
+  Polygon2d polygon(PolygonType::Polygon, outer, inners);
+  if (!polygon.isValid()) {
+    return false;
+  }
+  const GBox envelope = polygon.envelope();
+  const auto it = handles_.find(index);
+  if (it == handles_.end()) {
+    handles_.emplace(index, slots_.insert());
+    indices_.emplace_back(index);
+    polygons_.emplace_back(std::move(polygon));
+    envelopes_.emplace_back(envelope);
+    heights_.emplace_back(height);
+  } else {
+    const size_t dense = slots_.dense(it->second);
+    polygons_[dense] = std::move(polygon);
+    envelopes_[dense] = envelope;
+    heights_[dense] = height;
+  }
+  updateCaches();
+  return true;
+}
+
+bool PrismSet::remove(size_t index) {
+  const auto it = handles_.find(index);
+  if (it == handles_.end()) {
+    return false;
+  }
+  size_t dense = 0;
+  if (!slots_.erase(it->second, &dense)) {
+    return false;
+  }
+  handles_.erase(it);
+  const size_t last = indices_.size() - 1;
+  if (dense != last) {
+    indices_[dense] = indices_[last];
+    polygons_[dense] = std::move(polygons_[last]);
+    envelopes_[dense] = envelopes_[last];
+    heights_[dense] = heights_[last];
+  }
+  indices_.pop_back();
+  polygons_.pop_back();
+  envelopes_.pop_back();
+  heights_.pop_back();
+  updateCaches();
+  return true;
+}
+
+void PrismSet::updateCaches() {
+  height_ = kEmptyHeight;
+  for (const auto& height : heights_) {
+    height_.low = std::min(height_.low, height.low);
+    height_.high = std::max(height_.high, height.high);
+  }
+  index_.setCellSize(SpatialHash::suggestCellSize(envelopes_));
+  index_.rebuild(envelopes_);
+}
+
+int64_t PrismSet::find(double x, const Vec2d& point,
+                       std::vector<uint32_t>* candidates) const {
+  if (!height_.contains(x)) {
+    return -1;
+  }
+  index_.overlapping(GBox(point, point), candidates);
+  for (const auto& candidate : *candidates) {
+    if (heights_[candidate].contains(x) &&
+        polygons_[candidate].within(point)) {
+      return candidate;
+    }
+  }
+  return -1;
+}
+
+bool PrismSet::within(double x, const Vec2d& point) const {
+  std::vector<uint32_t> candidates;
+  return find(x, point, &candidates) >= 0;
+}
+
+void PrismSet::within(std::span<const float> xyz,
+                      std::vector<uint8_t>* result) const {
+  const PointView points(xyz.data(), xyz.size() / 3, 3 * sizeof(float),
+                         sizeof(float), 2 * sizeof(float),
+                         PointFieldType::Float32, 0);
+  (void)within(points, result);
+}
+
+bool PrismSet::within(const PointView& points,
+                      std::vector<uint8_t>* result) const {
+  if (!points.hasX()) {
+    result->clear();
+    return false;
+  }
+  // one scratch for the whole batch
+  std::vector<uint32_t> candidates;
+  result->resize(points.size());
+  for (size_t i = 0; i < points.size(); ++i) {
+    (*result)[i] = find(points.x(i), points[i], &candidates) >= 0 ? 1 : 0;
+  }
+  return true;
+}
+
+template <typename Visitor>
+bool PrismSet::visitOverlaps(const PolygonPtr& box, const HeightRange& height,
+                             std::vector<uint32_t>* candidates,
+                             Visitor&& visit) const {
+  if (!height_.overlaps(height)) {
+    return false;
+  }
+  index_.overlapping(box->envelope(), candidates);
+  for (const auto& candidate : *candidates) {
+    if (heights_[candidate].overlaps(height) &&
+        bg::intersects(polygons_[candidate].getPolygon(),
+                       box->getPolygon()) &&
+        visit(candidate)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void PrismSet::overlaped(const PolygonPtr& box, const HeightRange& height,
+                         std::vector<size_t>* indices) const {
+  indices->clear();
+  std::vector<uint32_t> candidates;
+  (void)visitOverlaps(box, height, &candidates, [&](uint32_t dense) {
+    indices->emplace_back(indices_[dense]);
+    return false;
+  });
+}
+
+void PrismSet::overlaped(std::span<const PolygonPtr> boxes,
+                         std::span<const HeightRange> heights,
+                         std::vector<uint8_t>* result) const {
+  const size_t count = std::min(boxes.size(), heights.size());
+  // one scratch for the whole batch
+  std::vector<uint32_t> candidates;
+  result->resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    (*result)[i] = visitOverlaps(boxes[i], heights[i], &candidates,
+                                 [](uint32_t) { return true; })
+                       ? 1
+                       : 0;
+  }
+}
+
+}  // namespace geometry
+}  // namespace innovusion
@@ -7,6 +7,7 @@
 #include "region2d.h"
 
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace innovusion {
@@ -20,6 +21,15 @@ Region2d::Region2d(const size_t index, const std::vector<Vec2d>& outer,
   init_ = setAttributesAndValues(attributes, values);
 }
 
+Region2d::Region2d(const size_t index, std::vector<Vec2d>&& outer,
+                   std::vector<std::vector<Vec2d>>&& inners,
+                   const std::vector<uint32_t>& attributes,
+                   const std::vector<int32_t>& values)
+    : Polygon2d(PolygonType::Region, std::move(outer), std::move(inners)),
+      index_(index) {
+  init_ = setAttributesAndValues(attributes, values);
+}
+
 bool Region2d::setAttributesAndValues(const std::vector<uint32_t>& attributes,
                                       const std::vector<int32_t>& values) {
   if (attributes.size() != values.size()) {
@@ -66,7 +76,7 @@ bool Region2d::getValue(const uint32_t& attribute, int32_t* value) const {
   }
 }
 
-bool Region2d::isValid() const { return bg::is_valid(polygon_) && init_; }
+bool Region2d::isValid() const { return Polygon2d::isValid() && init_; }
 
 }  // namespace geometry
 }  // namespace innovusion
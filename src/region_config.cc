@@ -0,0 +1,155 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-05
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/src/region_config.cc
+ */
+#include "region_config.h"
+
+#include <yaml-cpp/yaml.h>
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace innovusion {
+namespace geometry {
+
+namespace {
+// layout errors, caught in fromYaml with the YAML ones
+class ConfigError : public std::runtime_error {
+ public:
+  explicit ConfigError(const std::string& msg) : std::runtime_error(msg) {}
+};
+
+std::vector<Vec2d> readRing(const YAML::Node& node, const std::string& what) {
+  if (!node.IsSequence()) {
+    throw ConfigError(what + " is not a sequence of points");
+  }
+  std::vector<Vec2d> ring{};
+  ring.reserve(node.size());
+  for (const auto& point : node) {
+    if (!point.IsSequence() || point.size() != 2) {
+      throw ConfigError(what + " has a point which is not [y, z]");
+    }
+    ring.emplace_back(point[0].as<double>(), point[1].as<double>());
+  }
+  return ring;
+}
+
+void readPolygons(const YAML::Node& node, bool attributed,
+                  const std::string& what,
+                  std::map<size_t, RegionConfigPolygon>* polygons) {
+  if (!node) {
+    return;
+  }
+  if (!node.IsSequence()) {
+    throw ConfigError(what + " is not a sequence");
+  }
+  for (const auto& item : node) {
+    if (!item["index"] || !item["outer"]) {
+      throw ConfigError(what + " entry needs index and outer");
+    }
+    const size_t index = item["index"].as<size_t>();
+    const std::string name = what + " " + std::to_string(index);
+    RegionConfigPolygon polygon{};
+    polygon.outer = readRing(item["outer"], name + " outer");
+    if (const YAML::Node inners = item["inners"]) {
+      if (!inners.IsSequence()) {
+        throw ConfigError(name + " inners is not a sequence");
+      }
+      for (const auto& inner : inners) {
+        polygon.inners.emplace_back(readRing(inner, name + " inner"));
+      }
+    }
+    if (attributed) {
+      if (item["attributes"]) {
+        polygon.attributes = item["attributes"].as<std::vector<uint32_t>>();
+      }
+      if (item["values"]) {
+        polygon.values = item["values"].as<std::vector<int32_t>>();
+      }
+      if (polygon.attributes.size() != polygon.values.size()) {
+        throw ConfigError(name + " attributes and values differ in size");
+      }
+    }
+    if (!polygons->emplace(index, std::move(polygon)).second) {
+      throw ConfigError(name + " is duplicated");
+    }
+  }
+}
+}  // namespace
+
+bool RegionConfigPolygon::operator==(const RegionConfigPolygon& other) const {
+  return outer == other.outer && inners == other.inners &&
+         attributes == other.attributes && values == other.values;
+}
+
+bool RegionConfig::operator==(const RegionConfig& other) const {
+  return regions == other.regions && roi == other.roi &&
+         roi_interested == other.roi_interested &&
+         roi_rate == other.roi_rate && roi_compiled == other.roi_compiled &&
+         has_rt_matrix == other.has_rt_matrix &&
+         rt_matrix == other.rt_matrix && rt_precision == other.rt_precision;
+}
+
+bool RegionConfig::fromYaml(const std::string& text, RegionConfig* config,
+                            std::string* error) {
+  RegionConfig parsed{};
+  try {
+    const YAML::Node root = YAML::Load(text);
+    if (!root.IsNull() && !root.IsMap()) {
+      throw ConfigError("root is not a map");
+    }
+    if (const YAML::Node rt = root["rt_matrix"]) {
+      const auto data = rt["data"].as<std::vector<float>>();
+      if (data.size() != 16) {
+        throw ConfigError("rt_matrix data needs 16 values");
+      }
+      parsed.has_rt_matrix = true;
+      parsed.rt_matrix =
+          Eigen::Map<const Eigen::Matrix<float, 4, 4, Eigen::RowMajor>>(
+              data.data());
+      if (rt["precision"]) {
+        parsed.rt_precision = rt["precision"].as<float>();
+      }
+    }
+    if (const YAML::Node roi = root["roi"]) {
+      if (roi["interested"]) {
+        parsed.roi_interested = roi["interested"].as<bool>();
+      }
+      if (roi["rate"]) {
+        parsed.roi_rate = roi["rate"].as<int>();
+      }
+      if (roi["compiled"]) {
+        parsed.roi_compiled = roi["compiled"].as<bool>();
+      }
+      readPolygons(roi["polygons"], false, "roi", &parsed.roi);
+    }
+    readPolygons(root["regions"], true, "region", &parsed.regions);
+  } catch (const std::exception& exception) {
+    if (error != nullptr) {
+      *error = exception.what();
+    }
+    return false;
+  }
+  *config = std::move(parsed);
+  return true;
+}
+
+bool RegionConfig::fromFile(const std::string& path, RegionConfig* config,
+                            std::string* error) {
+  std::ifstream file(path);
+  if (!file) {
+    if (error != nullptr) {
+      *error = "cannot read " + path;
+    }
+    return false;
+  }
+  std::stringstream text;
+  text << file.rdbuf();
+  return fromYaml(text.str(), config, error);
+}
+
+}  // namespace geometry
+}  // namespace innovusion
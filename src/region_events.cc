@@ -0,0 +1,165 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-29
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/src/region_events.cc
+ */
+#include "region_events.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "spatial_hash.h"
+
+namespace innovusion {
+namespace geometry {
+
+RegionEventEngine::RegionEventEngine(uint32_t dwell_frames)
+    : dwell_frames_(dwell_frames), frame_(0), evaluated_(0) {}
+
+bool RegionEventEngine::addRegion(uint32_t region, const PolygonPtr& polygon) {
+  if (!polygon || !polygon->isValid()) {
+    return false;
+  }
+  const auto it = std::find(regions_.begin(), regions_.end(), region);
+  if (it == regions_.end()) {
+    regions_.emplace_back(region);
+    polygons_.emplace_back(polygon);
+    envelopes_.emplace_back(polygon->envelope());
+  } else {
+    const size_t i = it - regions_.begin();
+    polygons_[i] = polygon;
+    envelopes_[i] = polygon->envelope();
+  }
+  invalidate();
+  return true;
+}
+
+bool RegionEventEngine::removeRegion(uint32_t region) {
+  const auto it = std::find(regions_.begin(), regions_.end(), region);
+  if (it == regions_.end()) {
+    return false;
+  }
+  const size_t i = it - regions_.begin();
+  regions_.erase(it);
+  polygons_.erase(polygons_.begin() + i);
+  envelopes_.erase(envelopes_.begin() + i);
+  invalidate();
+  return true;
+}
+
+void RegionEventEngine::update(std::span<const TrackPosition> tracks,
+                               std::vector<RegionEvent>* events) {
+  events->clear();
+  ++frame_;
+  evaluated_ = 0;
+  for (const auto& [track, position] : tracks) {
+    TrackState& state = tracks_[track];
+    state.seen_frame = frame_;
+    if (state.slack < 0 || (position - state.anchor).norm() >= state.slack) {
+      evaluate(track, position, &state, events);
+      ++evaluated_;
+    }
+    reportDwell(track, &state, events);
+  }
+  for (auto it = tracks_.begin(); it != tracks_.end();) {
+    if (it->second.seen_frame == frame_) {
+      ++it;
+      continue;
+    }
+    for (const auto& membership : it->second.memberships) {
+      events->push_back(
+          {RegionEventType::Exit, it->first, membership.region,
+           static_cast<uint32_t>(frame_ - membership.enter_frame)});
+    }
+    it = tracks_.erase(it);
+  }
+}
+
+void RegionEventEngine::evaluate(uint32_t track, const Vec2d& position,
+                                 TrackState* state,
+                                 std::vector<RegionEvent>* events) {
+  scratch_.clear();
+  double slack = std::numeric_limits<double>::max();
+  for (size_t i = 0; i < regions_.size(); ++i) {
+    // outside the envelope the boundary is at least that far
+    const double outside = SpatialHash::envelopeDistance(
+        GBox(position, position), envelopes_[i]);
+    if (outside > 0) {
+      slack = std::min(slack, outside);
+      continue;
+    }
+    if (polygons_[i]->within(position)) {
+      scratch_.push_back({regions_[i], frame_, false});
+    }
+    slack = std::min(slack,
+                     boundaryDistance(position, polygons_[i]->getPolygon()));
+  }
+  std::sort(scratch_.begin(), scratch_.end(),
+            [](const Membership& a, const Membership& b) {
+              return a.region < b.region;
+            });
+
+  // sorted merge, kept regions carry their enter frame over
+  auto& previous = state->memberships;
+  auto old_it = previous.begin();
+  for (auto& current : scratch_) {
+    for (; old_it != previous.end() && old_it->region < current.region;
+         ++old_it) {
+      events->push_back(
+          {RegionEventType::Exit, track, old_it->region,
+           static_cast<uint32_t>(frame_ - old_it->enter_frame)});
+    }
+    if (old_it != previous.end() && old_it->region == current.region) {
+      current = *old_it++;
+    }
+  }
+  for (; old_it != previous.end(); ++old_it) {
+    events->push_back({RegionEventType::Exit, track, old_it->region,
+                       static_cast<uint32_t>(frame_ - old_it->enter_frame)});
+  }
+  for (const auto& current : scratch_) {
+    if (current.enter_frame == frame_) {
+      events->push_back({RegionEventType::Enter, track, current.region, 0});
+    }
+  }
+  previous.swap(scratch_);
+  state->anchor = position;
+  state->slack = slack;
+}
+
+void RegionEventEngine::reportDwell(uint32_t track, TrackState* state,
+                                    std::vector<RegionEvent>* events) const {
+  if (dwell_frames_ == 0) {
+    return;
+  }
+  for (auto& membership : state->memberships) {
+    const uint64_t frames = frame_ - membership.enter_frame;
+    if (!membership.dwell_reported && frames >= dwell_frames_) {
+      membership.dwell_reported = true;
+      events->push_back({RegionEventType::Dwell, track, membership.region,
+                         static_cast<uint32_t>(frames)});
+    }
+  }
+}
+
+void RegionEventEngine::regionsOf(uint32_t track,
+                                  std::vector<uint32_t>* regions) const {
+  regions->clear();
+  const auto it = tracks_.find(track);
+  if (it == tracks_.end()) {
+    return;
+  }
+  for (const auto& membership : it->second.memberships) {
+    regions->emplace_back(membership.region);
+  }
+}
+
+void RegionEventEngine::invalidate() {
+  for (auto& [track, state] : tracks_) {
+    state.slack = -1.0;
+  }
+}
+
+}  // namespace geometry
+}  // namespace innovusion
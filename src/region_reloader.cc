@@ -0,0 +1,260 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-05
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/src/region_reloader.cc
+ */
+#include "region_reloader.h"
+
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+namespace innovusion {
+namespace geometry {
+
+namespace {
+std::vector<Vec2d> transformed(const RigidTransform2d& transform,
+                               const std::vector<Vec2d>& ring) {
+  std::vector<Vec2d> result{};
+  result.reserve(ring.size());
+  for (const auto& point : ring) {
+    result.emplace_back(transform.apply(point));
+  }
+  return result;
+}
+
+std::vector<std::vector<Vec2d>> transformed(
+    const RigidTransform2d& transform,
+    const std::vector<std::vector<Vec2d>>& rings) {
+  std::vector<std::vector<Vec2d>> result{};
+  result.reserve(rings.size());
+  for (const auto& ring : rings) {
+    result.emplace_back(transformed(transform, ring));
+  }
+  return result;
+}
+
+bool readFile(const std::string& path, std::string* text) {
+  std::ifstream file(path);
+  if (!file) {
+    return false;
+  }
+  std::stringstream stream;
+  stream << file.rdbuf();
+  *text = stream.str();
+  return true;
+}
+
+void setError(std::string* error, const std::string& reason) {
+  if (error != nullptr) {
+    *error = reason;
+  }
+}
+}  // namespace
+
+RegionState::RegionState()
+    : generation_(0),
+      regions_(std::make_shared<const RegionStore>()),
+      roi_(std::make_shared<const Roi2d>()) {}
+
+bool RegionState::build(const RegionConfig& config,
+                        const RegionState& previous,
+                        std::shared_ptr<const RegionState>* state,
+                        std::string* error) {
+  auto next = std::make_shared<RegionState>();
+  next->generation_ = previous.generation_ + 1;
+  next->config_ = config;
+  if (config.has_rt_matrix &&
+      !RigidTransform2d::fromMatrix(config.rt_matrix, config.rt_precision,
+                                    &next->transform_)) {
+    setError(error, "rt_matrix rotation is not valid");
+    return false;
+  }
+  const RegionConfig& before = previous.config_;
+  const bool moved = config.has_rt_matrix != before.has_rt_matrix ||
+                     config.rt_matrix != before.rt_matrix ||
+                     config.rt_precision != before.rt_precision;
+
+  if (!moved && config.regions == before.regions) {
+    next->regions_ = previous.regions_;
+  } else {
+    auto regions = moved ? std::make_shared<RegionStore>()
+                         : std::make_shared<RegionStore>(*previous.regions_);
+    if (!moved) {
+      for (const auto& [index, polygon] : before.regions) {
+        if (config.regions.count(index) == 0) {
+          (void)regions->remove(index);
+        }
+      }
+    }
+    for (const auto& [index, polygon] : config.regions) {
+      const auto found = before.regions.find(index);
+      if (!moved && found != before.regions.end() &&
+          found->second == polygon) {
+        continue;
+      }
+      if (!regions->add(index, transformed(next->transform_, polygon.outer),
+                        transformed(next->transform_, polygon.inners),
+                        polygon.attributes, polygon.values)) {
+        setError(error, "region " + std::to_string(index) + " is not valid");
+        return false;
+      }
+    }
+    next->regions_ = std::move(regions);
+  }
+
+  if (!moved && config.roi == before.roi &&
+      config.roi_interested == before.roi_interested &&
+      config.roi_rate == before.roi_rate &&
+      config.roi_compiled == before.roi_compiled) {
+    next->roi_ = previous.roi_;
+  } else {
+    // ROI polygons are few, rebuild them in the new frame
+    auto roi = std::make_shared<Roi2d>(config.roi_interested, config.roi_rate,
+                                       config.roi_compiled);
+    for (const auto& [index, polygon] : config.roi) {
+      if (!roi->add(index, transformed(next->transform_, polygon.outer),
+                    transformed(next->transform_, polygon.inners))) {
+        setError(error, "roi " + std::to_string(index) + " is not valid");
+        return false;
+      }
+    }
+    // add() already built the index and the compiled union
+    next->roi_ = std::move(roi);
+  }
+  *state = std::move(next);
+  return true;
+}
+
+void RegionState::findRelatedMessage(
+    const PolygonPtr& box, std::vector<uint32_t>* attributes,
+    std::vector<int32_t>* values, std::vector<int32_t>* ious,
+    std::unordered_map<uint32_t, uint32_t>* flow) const {
+  regions_->findRelatedMessage(box, attributes, values, ious, flow);
+}
+
+bool RegionState::isUseful(const PolygonPtr& others) const {
+  return roi_->isUseful(others);
+}
+
+bool RegionState::isUseful(const Vec2d& point) const {
+  return roi_->isUseful(point);
+}
+
+RegionReloader::RegionReloader(const std::string& path)
+    : path_(path),
+      state_(std::make_shared<const RegionState>()),
+      stopping_(false) {}
+
+RegionReloader::~RegionReloader() { stop(); }
+
+bool RegionReloader::reload() {
+  std::lock_guard<std::mutex> lock(reload_mutex_);
+  std::string text{};
+  if (!readFile(path_, &text)) {
+    error_ = "cannot read " + path_;
+    return false;
+  }
+  text_ = text;
+  return load(text);
+}
+
+bool RegionReloader::apply(const RegionConfig& config) {
+  std::lock_guard<std::mutex> lock(reload_mutex_);
+  return publish(config);
+}
+
+bool RegionReloader::load(const std::string& text) {
+  RegionConfig config{};
+  if (!RegionConfig::fromYaml(text, &config, &error_)) {
+    return false;
+  }
+  return publish(config);
+}
+
+bool RegionReloader::publish(const RegionConfig& config) {
+  const std::shared_ptr<const RegionState> current = state();
+  if (current->generation() != 0 && current->config() == config) {
+    error_.clear();
+    return true;
+  }
+  std::shared_ptr<const RegionState> next{};
+  if (!RegionState::build(config, *current, &next, &error_)) {
+    return false;
+  }
+  error_.clear();
+  state_.store(std::move(next), std::memory_order_release);
+  return true;
+}
+
+void RegionReloader::poll() {
+  std::lock_guard<std::mutex> lock(reload_mutex_);
+  std::string text{};
+  // a file being replaced may be missing for a moment, keep the state
+  if (!readFile(path_, &text) || text == text_) {
+    pending_.clear();
+    return;
+  }
+  // a file edited in place is applied once two polls read the same content
+  if (text != pending_) {
+    pending_ = std::move(text);
+    return;
+  }
+  text_ = std::move(pending_);
+  pending_.clear();
+  (void)load(text_);
+}
+
+void RegionReloader::watch(std::chrono::milliseconds period) {
+  stop();
+  stopping_ = false;
+  watcher_ = std::thread([this, period] {
+    std::unique_lock<std::mutex> lock(watch_mutex_);
+    while (!stopping_) {
+      lock.unlock();
+      poll();
+      lock.lock();
+      wake_.wait_for(lock, period, [this] { return stopping_; });
+    }
+  });
+}
+
+void RegionReloader::stop() {
+  if (!watcher_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(watch_mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  watcher_.join();
+}
+
+std::shared_ptr<const RegionState> RegionReloader::state() const {
+  return state_.load(std::memory_order_acquire);
+}
+
+std::string RegionReloader::error() const {
+  std::lock_guard<std::mutex> lock(reload_mutex_);
+  return error_;
+}
+
+void RegionReloader::findRelatedMessage(
+    const PolygonPtr& box, std::vector<uint32_t>* attributes,
+    std::vector<int32_t>* values, std::vector<int32_t>* ious,
+    std::unordered_map<uint32_t, uint32_t>* flow) const {
+  state()->findRelatedMessage(box, attributes, values, ious, flow);
+}
+
+bool RegionReloader::isUseful(const PolygonPtr& others) const {
+  return state()->isUseful(others);
+}
+
+bool RegionReloader::isUseful(const Vec2d& point) const {
+  return state()->isUseful(point);
+}
+
+}  // namespace geometry
+}  // namespace innovusion
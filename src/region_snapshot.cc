@@ -0,0 +1,769 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-03
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/src/region_snapshot.cc
+ */
+#include "region_snapshot.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include "spatial_hash.h"
+
+namespace innovusion {
+namespace geometry {
+
+enum Section : uint32_t {
+  kPolygons = 0,
+  kRings,
+  kPoints,
+  kAttributes,
+  kValues,
+  kRegionGrid,
+  kRoiGrid,
+  kSectionCount,
+};
+
+struct RegionSnapshot::Header {
+  uint32_t magic;
+  uint32_t version;
+  // whole image, header included
+  uint64_t size;
+  // FNV-1a 64 of the bytes after the header
+  uint64_t checksum;
+  uint32_t region_count;
+  uint32_t roi_count;
+  uint32_t ring_count;
+  uint32_t point_count;
+  uint32_t attribute_count;
+  int32_t roi_rate;
+  uint8_t roi_interested;
+  uint8_t roi_compiled;
+  uint8_t reserved[6];
+  // byte offsets from the image start, see Section
+  uint64_t sections[kSectionCount];
+};
+
+struct RegionSnapshot::PolygonRecord {
+  uint64_t index;
+  double min_y;
+  double min_z;
+  double max_y;
+  double max_z;
+  uint32_t ring_begin;
+  uint32_t ring_count;
+  uint32_t attribute_begin;
+  uint32_t attribute_count;
+};
+
+struct RegionSnapshot::RingRecord {
+  uint32_t point_begin;
+  uint32_t point_count;
+};
+
+// followed by uint32 offsets[columns * rows + 1] and uint32 entries[]
+struct RegionSnapshot::GridRecord {
+  double origin_y;
+  double origin_z;
+  double cell_size;
+  uint32_t columns;
+  uint32_t rows;
+  uint32_t entry_count;
+  uint32_t reserved;
+
+  NODISCARD inline const uint32_t* offsets() const {
+    return reinterpret_cast<const uint32_t*>(this + 1);
+  }
+  NODISCARD inline const uint32_t* entries() const {
+    return offsets() + static_cast<size_t>(columns) * rows + 1;
+  }
+};
+
+namespace {
+// grids larger than that get coarser cells
+constexpr uint64_t kMaxGridCells = uint64_t(1) << 20;
+
+inline size_t align8(size_t size) { return (size + 7) & ~size_t(7); }
+
+uint64_t fnv1a(const uint8_t* data, size_t size) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ data[i]) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+// twice the signed area of a mapped closed ring, negative for clockwise
+double doubleSignedArea(const double* points, uint32_t count) {
+  double sum = 0.0;
+  for (uint32_t i = 0; i + 1 < count; ++i, points += 2) {
+    sum += points[0] * points[3] - points[1] * points[2];
+  }
+  return sum;
+}
+
+double doubleSignedArea(const std::vector<Vec2d>& ring) {
+  double sum = 0.0;
+  const size_t size = ring.size();
+  for (size_t i = 0; i < size; ++i) {
+    sum += ring[i] ^ ring[(i + 1) % size];
+  }
+  return sum;
+}
+
+// Sutherland-Hodgman of a mapped closed ring against the convex clockwise
+// closed ring clip, the signed area stays exact for any subject ring as the
+// degenerate edges along clip cancel out; -area for counter clockwise rings
+double clippedArea(const double* points, uint32_t count, const GRing& clip,
+                   std::vector<Vec2d>* input, std::vector<Vec2d>* output) {
+  // open ring
+  output->clear();
+  for (uint32_t i = 0; i + 1 < count; ++i, points += 2) {
+    output->emplace_back(points[0], points[1]);
+  }
+  for (size_t c = 0; c + 1 < clip.size() && !output->empty(); ++c) {
+    const Vec2d& a = clip[c];
+    const Vec2d edge = clip[c + 1] - a;
+    input->swap(*output);
+    output->clear();
+    const size_t size = input->size();
+    for (size_t i = 0; i < size; ++i) {
+      const Vec2d& current = (*input)[i];
+      const Vec2d& next = (*input)[(i + 1) % size];
+      const double current_side = edge ^ (current - a);
+      const double next_side = edge ^ (next - a);
+      if (current_side <= 0) {
+        output->emplace_back(current);
+      }
+      if ((current_side < 0 && next_side > 0) ||
+          (current_side > 0 && next_side < 0)) {
+        const double ratio = current_side / (current_side - next_side);
+        output->emplace_back(current + (next - current) * ratio);
+      }
+    }
+  }
+  return -doubleSignedArea(*output) / 2;
+}
+
+struct GridImage {
+  double origin_y = 0.0;
+  double origin_z = 0.0;
+  double cell_size = 1.0;
+  uint32_t columns = 0;
+  uint32_t rows = 0;
+  std::vector<uint32_t> offsets{0};
+  std::vector<uint32_t> entries{};
+};
+
+// uniform grid over envelopes, every polygon registered in each covered cell
+GridImage buildGrid(std::span<const GBox> envelopes) {
+  GridImage grid;
+  if (envelopes.empty()) {
+    return grid;
+  }
+  GBox bounds = envelopes.front();
+  double sum = 0.0;
+  for (const auto& envelope : envelopes) {
+    bg::expand(bounds, envelope);
+    sum += std::max(envelope.max_corner().y - envelope.min_corner().y,
+                    envelope.max_corner().z - envelope.min_corner().z);
+  }
+  const double span_y = bounds.max_corner().y - bounds.min_corner().y;
+  const double span_z = bounds.max_corner().z - bounds.min_corner().z;
+  grid.origin_y = bounds.min_corner().y;
+  grid.origin_z = bounds.min_corner().z;
+  grid.cell_size = std::max(sum / envelopes.size(), kGeometryEpsilon);
+  while (true) {
+    const double columns = std::floor(span_y / grid.cell_size) + 1;
+    const double rows = std::floor(span_z / grid.cell_size) + 1;
+    if (columns * rows <= kMaxGridCells) {
+      grid.columns = static_cast<uint32_t>(columns);
+      grid.rows = static_cast<uint32_t>(rows);
+      break;
+    }
+    grid.cell_size *= 2;
+  }
+
+  // envelopes lie within bounds, only rounding can step past the last cell
+  const Vec2d origin(grid.origin_y, grid.origin_z);
+  std::vector<CellRange> ranges(envelopes.size());
+  for (size_t i = 0; i < envelopes.size(); ++i) {
+    CellRange& range = ranges[i];
+    if (!gridCellRange(envelopes[i], origin, grid.cell_size, &range)) {
+      range = {0, 0, -1, -1};
+      continue;
+    }
+    range.min_y = std::max<int64_t>(range.min_y, 0);
+    range.min_z = std::max<int64_t>(range.min_z, 0);
+    range.max_y = std::min<int64_t>(range.max_y, grid.columns - 1);
+    range.max_z = std::min<int64_t>(range.max_z, grid.rows - 1);
+  }
+  std::vector<uint32_t> cursor{};
+  countingSort(
+      ranges, static_cast<size_t>(grid.columns) * grid.rows,
+      [&grid](int64_t y, int64_t z) {
+        return static_cast<size_t>(z) * grid.columns + static_cast<size_t>(y);
+      },
+      &grid.offsets, &grid.entries, &cursor);
+  return grid;
+}
+
+template <typename T>
+inline bool fits(size_t offset, size_t count, size_t size) {
+  return offset % 8 == 0 && offset <= size &&
+         count <= (size - offset) / sizeof(T);
+}
+}  // namespace
+
+void RegionSnapshot::serialize(const RegionStore& regions, const Roi2d& roi,
+                               std::vector<uint8_t>* bytes) {
+  std::vector<PolygonRecord> polygons{};
+  std::vector<RingRecord> rings{};
+  std::vector<double> points{};
+  std::vector<uint32_t> attributes{};
+  std::vector<int32_t> values{};
+  std::vector<GBox> region_envelopes{};
+  std::vector<GBox> roi_envelopes{};
+
+  const auto addPolygon = [&](size_t index, const Polygon2d& polygon,
+                              const GBox& envelope) {
+    PolygonRecord record{};
+    record.index = index;
+    record.min_y = envelope.min_corner().y;
+    record.min_z = envelope.min_corner().z;
+    record.max_y = envelope.max_corner().y;
+    record.max_z = envelope.max_corner().z;
+    record.ring_begin = static_cast<uint32_t>(rings.size());
+    record.ring_count = static_cast<uint32_t>(1 + polygon.inners().size());
+    record.attribute_begin = static_cast<uint32_t>(attributes.size());
+    const auto addRing = [&](const GRing& ring) {
+      rings.push_back({static_cast<uint32_t>(points.size() / 2),
+                       static_cast<uint32_t>(ring.size())});
+      for (const auto& point : ring) {
+        points.insert(points.end(), {point.y, point.z});
+      }
+    };
+    addRing(polygon.outer());
+    for (const auto& inner : polygon.inners()) {
+      addRing(inner);
+    }
+    polygons.emplace_back(record);
+  };
+  for (size_t i = 0; i < regions.size(); ++i) {
+    addPolygon(regions.indexAt(i), regions.polygonAt(i), regions.envelopeAt(i));
+    const auto region_attributes = regions.attributesAt(i);
+    const auto region_values = regions.valuesAt(i);
+    polygons.back().attribute_count =
+        static_cast<uint32_t>(region_attributes.size());
+    attributes.insert(attributes.end(), region_attributes.begin(),
+                      region_attributes.end());
+    values.insert(values.end(), region_values.begin(), region_values.end());
+    region_envelopes.emplace_back(regions.envelopeAt(i));
+  }
+  for (size_t i = 0; i < roi.size(); ++i) {
+    addPolygon(roi.indexAt(i), roi.polygonAt(i), roi.envelopeAt(i));
+    roi_envelopes.emplace_back(roi.envelopeAt(i));
+  }
+  const GridImage region_grid = buildGrid(region_envelopes);
+  const GridImage roi_grid = buildGrid(roi_envelopes);
+  const auto gridBytes = [](const GridImage& grid) {
+    return sizeof(GridRecord) +
+           sizeof(uint32_t) * (grid.offsets.size() + grid.entries.size());
+  };
+
+  Header header{};
+  header.magic = kMagic;
+  header.version = kVersion;
+  header.region_count = static_cast<uint32_t>(regions.size());
+  header.roi_count = static_cast<uint32_t>(roi.size());
+  header.ring_count = static_cast<uint32_t>(rings.size());
+  header.point_count = static_cast<uint32_t>(points.size() / 2);
+  header.attribute_count = static_cast<uint32_t>(attributes.size());
+  header.roi_rate = roi.rate();
+  header.roi_interested = roi.interested() ? 1 : 0;
+  header.roi_compiled = roi.compiled() ? 1 : 0;
+  const size_t sizes[kSectionCount] = {
+      polygons.size() * sizeof(PolygonRecord),
+      rings.size() * sizeof(RingRecord),
+      points.size() * sizeof(double),
+      attributes.size() * sizeof(uint32_t),
+      values.size() * sizeof(int32_t),
+      gridBytes(region_grid),
+      gridBytes(roi_grid)};
+  size_t size = align8(sizeof(Header));
+  for (uint32_t section = 0; section < kSectionCount; ++section) {
+    header.sections[section] = size;
+    size = align8(size + sizes[section]);
+  }
+  header.size = size;
+
+  bytes->assign(size, 0);
+  uint8_t* base = bytes->data();
+  const auto copy = [&](Section section, const void* data, size_t length) {
+    if (length > 0) {
+      std::memcpy(base + header.sections[section], data, length);
+    }
+  };
+  copy(kPolygons, polygons.data(), sizes[kPolygons]);
+  copy(kRings, rings.data(), sizes[kRings]);
+  copy(kPoints, points.data(), sizes[kPoints]);
+  copy(kAttributes, attributes.data(), sizes[kAttributes]);
+  copy(kValues, values.data(), sizes[kValues]);
+  const auto copyGrid = [&](Section section, const GridImage& grid) {
+    GridRecord record{grid.origin_y, grid.origin_z, grid.cell_size,
+                      grid.columns, grid.rows,
+                      static_cast<uint32_t>(grid.entries.size()), 0};
+    uint8_t* target = base + header.sections[section];
+    std::memcpy(target, &record, sizeof(record));
+    target += sizeof(record);
+    std::memcpy(target, grid.offsets.data(), 4 * grid.offsets.size());
+    target += 4 * grid.offsets.size();
+    if (!grid.entries.empty()) {
+      std::memcpy(target, grid.entries.data(), 4 * grid.entries.size());
+    }
+  };
+  copyGrid(kRegionGrid, region_grid);
+  copyGrid(kRoiGrid, roi_grid);
+  header.checksum = fnv1a(base + sizeof(Header), size - sizeof(Header));
+  std::memcpy(base, &header, sizeof(header));
+}
+
+bool RegionSnapshot::save(const RegionStore& regions, const Roi2d& roi,
+                          const std::string& path) {
+  std::vector<uint8_t> bytes{};
+  serialize(regions, roi, &bytes);
+  // a reader may have path mapped, truncating it in place would fault its
+  // pages; write a sibling file and swap it in, the old inode stays alive
+  // until the last mapping goes away
+  std::string temporary = path + ".XXXXXX";
+  const int descriptor = ::mkstemp(temporary.data());
+  if (descriptor < 0) {
+    return false;
+  }
+  bool written = ::fchmod(descriptor, 0644) == 0;
+  for (size_t done = 0; written && done < bytes.size();) {
+    const ssize_t count =
+        ::write(descriptor, bytes.data() + done, bytes.size() - done);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    written = count > 0;
+    done += written ? static_cast<size_t>(count) : 0;
+  }
+  written = written && ::fsync(descriptor) == 0;
+  written = ::close(descriptor) == 0 && written;
+  if (!written || ::rename(temporary.c_str(), path.c_str()) != 0) {
+    ::unlink(temporary.c_str());
+    return false;
+  }
+  return true;
+}
+
+RegionSnapshot::RegionSnapshot()
+    : base_(nullptr),
+      header_(nullptr),
+      polygons_(nullptr),
+      rings_(nullptr),
+      points_(nullptr),
+      attributes_(nullptr),
+      values_(nullptr),
+      region_grid_(nullptr),
+      roi_grid_(nullptr),
+      mapping_(nullptr),
+      mapping_size_(0) {}
+
+RegionSnapshot::~RegionSnapshot() { close(); }
+
+bool RegionSnapshot::attach(std::span<const uint8_t> bytes, bool verify) {
+  header_ = nullptr;
+  const uint8_t* base = bytes.data();
+  const size_t size = bytes.size();
+  if (size < sizeof(Header) || reinterpret_cast<uintptr_t>(base) % 8 != 0) {
+    return false;
+  }
+  const Header* header = reinterpret_cast<const Header*>(base);
+  if (header->magic != kMagic || header->version != kVersion ||
+      header->size != size) {
+    return false;
+  }
+  if (verify &&
+      fnv1a(base + sizeof(Header), size - sizeof(Header)) !=
+          header->checksum) {
+    return false;
+  }
+  const size_t polygon_count =
+      static_cast<size_t>(header->region_count) + header->roi_count;
+  const uint64_t* sections = header->sections;
+  if (!fits<PolygonRecord>(sections[kPolygons], polygon_count, size) ||
+      !fits<RingRecord>(sections[kRings], header->ring_count, size) ||
+      !fits<double>(sections[kPoints], 2 * size_t(header->point_count),
+                    size) ||
+      !fits<uint32_t>(sections[kAttributes], header->attribute_count, size) ||
+      !fits<int32_t>(sections[kValues], header->attribute_count, size)) {
+    return false;
+  }
+  const auto* polygons =
+      reinterpret_cast<const PolygonRecord*>(base + sections[kPolygons]);
+  const auto* rings =
+      reinterpret_cast<const RingRecord*>(base + sections[kRings]);
+  // record ranges, so queries need no bound checks
+  for (size_t i = 0; i < polygon_count; ++i) {
+    const PolygonRecord& record = polygons[i];
+    if (record.ring_count == 0 || record.ring_count > header->ring_count ||
+        record.ring_begin > header->ring_count - record.ring_count ||
+        record.attribute_begin > header->attribute_count ||
+        record.attribute_count >
+            header->attribute_count - record.attribute_begin) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < header->ring_count; ++i) {
+    if (rings[i].point_begin > header->point_count ||
+        rings[i].point_count > header->point_count - rings[i].point_begin) {
+      return false;
+    }
+  }
+  const auto checkGrid = [&](Section section, uint32_t count) {
+    if (!fits<GridRecord>(sections[section], 1, size)) {
+      return false;
+    }
+    const auto* grid =
+        reinterpret_cast<const GridRecord*>(base + sections[section]);
+    const size_t cells = static_cast<size_t>(grid->columns) * grid->rows;
+    const size_t offset = sections[section] + sizeof(GridRecord);
+    if (!(grid->cell_size > 0) || cells > kMaxGridCells ||
+        (count > 0 && cells == 0) ||
+        !fits<uint32_t>(offset, cells + 1 + grid->entry_count, size) ||
+        grid->offsets()[cells] != grid->entry_count) {
+      return false;
+    }
+    for (size_t cell = 0; cell < cells; ++cell) {
+      if (grid->offsets()[cell] > grid->offsets()[cell + 1]) {
+        return false;
+      }
+    }
+    for (size_t i = 0; i < grid->entry_count; ++i) {
+      if (grid->entries()[i] >= count) {
+        return false;
+      }
+    }
+    return true;
+  };
+  if (!checkGrid(kRegionGrid, header->region_count) ||
+      !checkGrid(kRoiGrid, header->roi_count)) {
+    return false;
+  }
+
+  base_ = base;
+  polygons_ = polygons;
+  rings_ = rings;
+  points_ = reinterpret_cast<const double*>(base + sections[kPoints]);
+  attributes_ = reinterpret_cast<const uint32_t*>(base + sections[kAttributes]);
+  values_ = reinterpret_cast<const int32_t*>(base + sections[kValues]);
+  region_grid_ =
+      reinterpret_cast<const GridRecord*>(base + sections[kRegionGrid]);
+  roi_grid_ = reinterpret_cast<const GridRecord*>(base + sections[kRoiGrid]);
+  header_ = header;
+  return true;
+}
+
+bool RegionSnapshot::open(const std::string& path, bool verify) {
+  close();
+  const int descriptor = ::open(path.c_str(), O_RDONLY);
+  if (descriptor < 0) {
+    return false;
+  }
+  const bool mapped = map(descriptor, verify);
+  ::close(descriptor);
+  return mapped;
+}
+
+bool RegionSnapshot::map(int descriptor, bool verify) {
+  close();
+  struct stat status {};
+  if (::fstat(descriptor, &status) != 0 || status.st_size <= 0) {
+    return false;
+  }
+  const size_t size = static_cast<size_t>(status.st_size);
+  void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, descriptor, 0);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+  mapping_ = mapping;
+  mapping_size_ = size;
+  if (!attach({static_cast<const uint8_t*>(mapping), size}, verify)) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void RegionSnapshot::close() {
+  header_ = nullptr;
+  base_ = nullptr;
+  if (mapping_ != nullptr) {
+    ::munmap(mapping_, mapping_size_);
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+  }
+}
+
+size_t RegionSnapshot::regionCount() const {
+  return empty() ? 0 : header_->region_count;
+}
+
+size_t RegionSnapshot::roiCount() const {
+  return empty() ? 0 : header_->roi_count;
+}
+
+bool RegionSnapshot::roiInterested() const {
+  return empty() || header_->roi_interested != 0;
+}
+
+int RegionSnapshot::roiRate() const {
+  return empty() ? 0 : header_->roi_rate;
+}
+
+size_t RegionSnapshot::indexAt(size_t dense) const {
+  return polygons_[dense].index;
+}
+
+std::span<const uint32_t> RegionSnapshot::attributesAt(size_t dense) const {
+  return {attributes_ + polygons_[dense].attribute_begin,
+          polygons_[dense].attribute_count};
+}
+
+std::span<const int32_t> RegionSnapshot::valuesAt(size_t dense) const {
+  return {values_ + polygons_[dense].attribute_begin,
+          polygons_[dense].attribute_count};
+}
+
+Polygon2d RegionSnapshot::polygonAt(size_t dense) const {
+  return materialize(static_cast<uint32_t>(dense), PolygonType::Region);
+}
+
+GBox RegionSnapshot::envelopeOf(uint32_t polygon) const {
+  const PolygonRecord& record = polygons_[polygon];
+  return GBox(Vec2d(record.min_y, record.min_z),
+              Vec2d(record.max_y, record.max_z));
+}
+
+Polygon2d RegionSnapshot::materialize(uint32_t polygon,
+                                      PolygonType type) const {
+  const PolygonRecord& record = polygons_[polygon];
+  GPolygon result;
+  result.inners().resize(record.ring_count - 1);
+  for (uint32_t i = 0; i < record.ring_count; ++i) {
+    const RingRecord& ring = rings_[record.ring_begin + i];
+    GRing& target = i == 0 ? result.outer() : result.inners()[i - 1];
+    target.reserve(ring.point_count);
+    const double* point = points_ + 2 * size_t(ring.point_begin);
+    for (uint32_t j = 0; j < ring.point_count; ++j, point += 2) {
+      target.emplace_back(point[0], point[1]);
+    }
+  }
+  return Polygon2d(type, std::move(result));
+}
+
+double RegionSnapshot::area(uint32_t polygon) const {
+  const PolygonRecord& record = polygons_[polygon];
+  double sum = 0.0;
+  for (uint32_t i = 0; i < record.ring_count; ++i) {
+    const RingRecord& ring = rings_[record.ring_begin + i];
+    sum -= doubleSignedArea(points_ + 2 * size_t(ring.point_begin),
+                            ring.point_count);
+  }
+  return sum / 2;
+}
+
+double RegionSnapshot::intersectionArea(uint32_t polygon,
+                                        const PolygonPtr& others,
+                                        AreaScratch* scratch) const {
+  if (!scratch->convex) {
+    return materialize(polygon, PolygonType::Polygon)
+        .calculateIntersectionArea(others);
+  }
+  const PolygonRecord& record = polygons_[polygon];
+  double sum = 0.0;
+  for (uint32_t i = 0; i < record.ring_count; ++i) {
+    const RingRecord& ring = rings_[record.ring_begin + i];
+    sum += clippedArea(points_ + 2 * size_t(ring.point_begin),
+                       ring.point_count, others->outer(), &scratch->input,
+                       &scratch->output);
+  }
+  return std::max(sum, 0.0);
+}
+
+void RegionSnapshot::candidates(const GridRecord* grid, const GBox& box,
+                                std::vector<uint32_t>* polygons) const {
+  polygons->clear();
+  if (grid->columns == 0 || grid->rows == 0) {
+    return;
+  }
+  const double min_y = (box.min_corner().y - grid->origin_y) / grid->cell_size;
+  const double min_z = (box.min_corner().z - grid->origin_z) / grid->cell_size;
+  const double max_y = (box.max_corner().y - grid->origin_y) / grid->cell_size;
+  const double max_z = (box.max_corner().z - grid->origin_z) / grid->cell_size;
+  // the grid covers every envelope, nothing outside of it
+  if (!(max_y >= 0 && max_z >= 0 && min_y < grid->columns &&
+        min_z < grid->rows)) {
+    return;
+  }
+  const uint32_t first_column = static_cast<uint32_t>(std::max(0.0, min_y));
+  const uint32_t first_row = static_cast<uint32_t>(std::max(0.0, min_z));
+  const uint32_t last_column = static_cast<uint32_t>(
+      std::min(max_y, static_cast<double>(grid->columns - 1)));
+  const uint32_t last_row = static_cast<uint32_t>(
+      std::min(max_z, static_cast<double>(grid->rows - 1)));
+  const uint32_t* offsets = grid->offsets();
+  const uint32_t* entries = grid->entries();
+  for (uint32_t row = first_row; row <= last_row; ++row) {
+    for (uint32_t column = first_column; column <= last_column; ++column) {
+      const size_t cell = static_cast<size_t>(row) * grid->columns + column;
+      polygons->insert(polygons->end(), entries + offsets[cell],
+                       entries + offsets[cell + 1]);
+    }
+  }
+  if (first_row != last_row || first_column != last_column) {
+    std::sort(polygons->begin(), polygons->end());
+    polygons->erase(std::unique(polygons->begin(), polygons->end()),
+                    polygons->end());
+  }
+}
+
+bool RegionSnapshot::within(uint32_t polygon, const Vec2d& point) const {
+  const PolygonRecord& record = polygons_[polygon];
+  if (point.y < record.min_y || point.y > record.max_y ||
+      point.z < record.min_z || point.z > record.max_z) {
+    return false;
+  }
+  // even odd rule over all rings, a point on any edge is not within
+  bool inside = false;
+  for (uint32_t i = 0; i < record.ring_count; ++i) {
+    const RingRecord& ring = rings_[record.ring_begin + i];
+    const double* a = points_ + 2 * size_t(ring.point_begin);
+    for (uint32_t j = 0; j + 1 < ring.point_count; ++j, a += 2) {
+      const double* b = a + 2;
+      const double side =
+          (b[0] - a[0]) * (point.z - a[1]) - (b[1] - a[1]) * (point.y - a[0]);
+      if (side == 0 && point.y >= std::min(a[0], b[0]) &&
+          point.y <= std::max(a[0], b[0]) &&
+          point.z >= std::min(a[1], b[1]) &&
+          point.z <= std::max(a[1], b[1])) {
+        return false;
+      }
+      if ((a[1] > point.z) != (b[1] > point.z)) {
+        const double crossing =
+            a[0] + (point.z - a[1]) * (b[0] - a[0]) / (b[1] - a[1]);
+        if (point.y < crossing) {
+          inside = !inside;
+        }
+      }
+    }
+  }
+  return inside;
+}
+
+void RegionSnapshot::findRelatedMessage(
+    const PolygonPtr& box, std::vector<uint32_t>* attributes,
+    std::vector<int32_t>* values, std::vector<int32_t>* ious,
+    std::unordered_map<uint32_t, uint32_t>* flow) const {
+  attributes->clear();
+  values->clear();
+  ious->clear();
+  if (empty()) {
+    return;
+  }
+  const GBox envelope = box->envelope();
+  std::vector<uint32_t> found{};
+  candidates(region_grid_, envelope, &found);
+  const double box_area = box->area();
+  AreaScratch scratch(box);
+  for (const auto& dense : found) {
+    if (bg::disjoint(envelopeOf(dense), envelope)) {
+      continue;
+    }
+    // same as Polygon2d::iou
+    const double intersection = intersectionArea(dense, box, &scratch);
+    if (!(intersection > 0)) {
+      continue;
+    }
+    const int32_t rate = static_cast<int32_t>(std::round(
+        intersection / (area(dense) + box_area - intersection) * 100));
+    if (rate <= 0) {
+      continue;
+    }
+    if (flow != nullptr) {
+      ++(*flow)[static_cast<uint32_t>(polygons_[dense].index)];
+    }
+    const auto region_attributes = attributesAt(dense);
+    const auto region_values = valuesAt(dense);
+    attributes->insert(attributes->end(), region_attributes.begin(),
+                       region_attributes.end());
+    values->insert(values->end(), region_values.begin(), region_values.end());
+    ious->insert(ious->end(), region_attributes.size(), rate);
+  }
+}
+
+bool RegionSnapshot::isUseful(const Vec2d& point) const {
+  if (empty()) {
+    return false;
+  }
+  std::vector<uint32_t> found{};
+  candidates(roi_grid_, GBox(point, point), &found);
+  bool result = false;
+  for (const auto& polygon : found) {
+    if (within(header_->region_count + polygon, point)) {
+      result = true;
+      break;
+    }
+  }
+  return header_->roi_interested != 0 ? result : !result;
+}
+
+bool RegionSnapshot::isUseful(const PolygonPtr& others) const {
+  if (empty()) {
+    return false;
+  }
+  const double target_area = others->area();
+  const GBox envelope = others->envelope();
+  std::vector<uint32_t> found{};
+  candidates(roi_grid_, envelope, &found);
+  bool result = false;
+  if (target_area > 0) {
+    AreaScratch scratch(others);
+    double covered = 0.0;
+    int sum = 0;
+    for (const auto& polygon : found) {
+      const uint32_t record = header_->region_count + polygon;
+      if (bg::disjoint(envelopeOf(record), envelope)) {
+        continue;
+      }
+      const double intersection = intersectionArea(record, others, &scratch);
+      if (header_->roi_compiled != 0) {
+        covered += intersection;
+      } else if (intersection > 0) {
+        // same as Polygon2d::iouTarget
+        sum += static_cast<int>(std::round(intersection / target_area * 100));
+      }
+    }
+    result = header_->roi_compiled != 0
+                 ? covered / target_area * 100 > header_->roi_rate
+                 : sum >= header_->roi_rate + 1;
+  }
+  return header_->roi_interested != 0 ? result : !result;
+}
+
+}  // namespace geometry
+}  // namespace innovusion
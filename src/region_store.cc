@@ -0,0 +1,304 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-21
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/src/region_store.cc
+ */
+#include "region_store.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace innovusion {
+namespace geometry {
+
+namespace {
+bool uniqueAttributes(const std::vector<uint32_t>& attributes) {
+  std::vector<uint32_t> sorted(attributes);
+  std::sort(sorted.begin(), sorted.end());
+  return std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end();
+}
+}  // namespace
+
+RegionStore::RegionStore() : dead_attributes_(0) {}
+
+bool RegionStore::add(size_t index, const std::vector<Vec2d>& outer,
+                      const std::vector<std::vector<Vec2d>>& inners,
+                      const std::vector<uint32_t>& attributes,
+                      const std::vector<int32_t>& values) {
+  return add(index, std::vector<Vec2d>(outer),
+             std::vector<std::vector<Vec2d>>(inners), attributes, values);
+}
+
+bool RegionStore::add(size_t index, std::vector<Vec2d>&& outer,
+                      std::vector<std::vector<Vec2d>>&& inners,
+                      const std::vector<uint32_t>& attributes,
+                      const std::vector<int32_t>& values) {
+  if (attributes.size() != values.size() || !uniqueAttributes(attributes)) {
+    return false;
+  }
+  Polygon2d polygon(PolygonType::Region, std::move(outer), std::move(inners));
+  if (!polygon.isValid()) {
+    return false;
+  }
+
+  size_t dense;
+  const auto it = handles_.find(index);
+  if (it == handles_.end()) {
+    const SlotHandle handle = slots_.insert();
+    handles_.emplace(index, handle);
+    dense = slots_.dense(handle);
+    indices_.emplace_back(index);
+    polygons_.emplace_back(std::move(polygon));
+    envelopes_.emplace_back();
+    attribute_offsets_.emplace_back();
+    attribute_counts_.emplace_back(0);
+  } else {
+    dense = slots_.dense(it->second);
+    unlink(dense);
+    dead_attributes_ += attribute_counts_[dense];
+    polygons_[dense] = std::move(polygon);  // replace
+  }
+
+  envelopes_[dense] = polygons_[dense].envelope();
+  attribute_offsets_[dense] = static_cast<uint32_t>(attributes_.size());
+  attribute_counts_[dense] = static_cast<uint32_t>(attributes.size());
+  attributes_.insert(attributes_.end(), attributes.begin(), attributes.end());
+  values_.insert(values_.end(), values.begin(), values.end());
+  link(dense);
+  if (dead_attributes_ > attributes_.size() / 2) {
+    compactAttributes();
+  }
+  version_.bump();
+  return true;
+}
+
+bool RegionStore::remove(size_t index) {
+  const auto it = handles_.find(index);
+  if (it == handles_.end()) {
+    return false;
+  }
+  unlink(slots_.dense(it->second));
+  size_t hole = 0;
+  if (!slots_.erase(it->second, &hole)) {
+    return false;
+  }
+  handles_.erase(it);
+  erase(hole);
+  version_.bump();
+  return true;
+}
+
+void RegionStore::clear() {
+  slots_.clear();
+  handles_.clear();
+  inverted_.clear();
+  indices_.clear();
+  polygons_.clear();
+  envelopes_.clear();
+  attribute_offsets_.clear();
+  attribute_counts_.clear();
+  attributes_.clear();
+  values_.clear();
+  dead_attributes_ = 0;
+  version_.bump();
+}
+
+std::span<const uint32_t> RegionStore::attributesAt(size_t dense) const {
+  return {attributes_.data() + attribute_offsets_[dense],
+          attribute_counts_[dense]};
+}
+
+std::span<const int32_t> RegionStore::valuesAt(size_t dense) const {
+  return {values_.data() + attribute_offsets_[dense], attribute_counts_[dense]};
+}
+
+bool RegionStore::find(size_t index, size_t* dense) const {
+  const auto it = handles_.find(index);
+  if (it == handles_.end()) {
+    return false;
+  }
+  *dense = slots_.dense(it->second);
+  return true;
+}
+
+void RegionStore::regionsWithAttribute(uint32_t attribute,
+                                       std::vector<size_t>* denses) const {
+  denses->clear();
+  const auto it = inverted_.find(attribute);
+  if (it == inverted_.end()) {
+    return;
+  }
+  denses->reserve(it->second.size());
+  for (const auto& handle : it->second) {
+    denses->emplace_back(slots_.dense(handle));
+  }
+}
+
+void RegionStore::findRelatedMessage(
+    const PolygonPtr& box, std::vector<uint32_t>* attributes,
+    std::vector<int32_t>* values, std::vector<int32_t>* ious,
+    std::unordered_map<uint32_t, uint32_t>* flow) const {
+  attributes->clear();
+  values->clear();
+  ious->clear();
+  const GBox envelope = box->envelope();
+  for (size_t i = 0; i < indices_.size(); ++i) {
+    const int32_t rate = overlapRate(i, box, envelope);
+    if (rate > 0) {
+      appendRegion(i, rate, attributes, values, ious, flow);
+    }
+  }
+}
+
+void RegionStore::findRelatedMessage(
+    const FrameBox& box, FrameArena* arena, std::vector<uint32_t>* attributes,
+    std::vector<int32_t>* values, std::vector<int32_t>* ious,
+    std::unordered_map<uint32_t, uint32_t>* flow) const {
+  attributes->clear();
+  values->clear();
+  ious->clear();
+  const GBox envelope = box.envelope();
+  for (size_t i = 0; i < indices_.size(); ++i) {
+    if (bg::disjoint(envelopes_[i], envelope)) {
+      continue;
+    }
+    const int32_t rate = static_cast<int32_t>(
+        std::round(box.iou(polygons_[i], arena) * 100));
+    if (rate > 0) {
+      appendRegion(i, rate, attributes, values, ious, flow);
+    }
+  }
+}
+
+void RegionStore::appendRegion(
+    size_t dense, int32_t rate, std::vector<uint32_t>* attributes,
+    std::vector<int32_t>* values, std::vector<int32_t>* ious,
+    std::unordered_map<uint32_t, uint32_t>* flow) const {
+  if (flow != nullptr) {
+    ++(*flow)[indices_[dense]];
+  }
+  const auto region_attributes = attributesAt(dense);
+  const auto region_values = valuesAt(dense);
+  attributes->insert(attributes->end(), region_attributes.begin(),
+                     region_attributes.end());
+  values->insert(values->end(), region_values.begin(), region_values.end());
+  ious->insert(ious->end(), region_attributes.size(), rate);
+}
+
+void RegionStore::findRelatedMessage(
+    const PolygonPtr& box, const std::vector<uint32_t>& filter,
+    std::vector<uint32_t>* attributes, std::vector<int32_t>* values,
+    std::vector<int32_t>* ious,
+    std::unordered_map<uint32_t, uint32_t>* flow) const {
+  attributes->clear();
+  values->clear();
+  ious->clear();
+  std::vector<size_t> candidates{};
+  for (const auto& attribute : filter) {
+    const auto it = inverted_.find(attribute);
+    if (it != inverted_.end()) {
+      for (const auto& handle : it->second) {
+        candidates.emplace_back(slots_.dense(handle));
+      }
+    }
+  }
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                   candidates.end());
+
+  const GBox envelope = box->envelope();
+  for (const auto& dense : candidates) {
+    const int32_t rate = overlapRate(dense, box, envelope);
+    if (rate > 0) {
+      if (flow != nullptr) {
+        ++(*flow)[indices_[dense]];
+      }
+      const auto region_attributes = attributesAt(dense);
+      const auto region_values = valuesAt(dense);
+      for (size_t k = 0; k < region_attributes.size(); ++k) {
+        if (std::find(filter.begin(), filter.end(), region_attributes[k]) !=
+            filter.end()) {
+          attributes->emplace_back(region_attributes[k]);
+          values->emplace_back(region_values[k]);
+          ious->emplace_back(rate);
+        }
+      }
+    }
+  }
+}
+
+int32_t RegionStore::overlapRate(size_t dense, const PolygonPtr& box,
+                                 const GBox& envelope) const {
+  if (bg::disjoint(envelopes_[dense], envelope)) {
+    return 0;
+  }
+  return static_cast<int32_t>(std::round(polygons_[dense].iou(box) * 100));
+}
+
+void RegionStore::link(size_t dense) {
+  const SlotHandle handle = slots_.handle(dense);
+  for (const auto& attribute : attributesAt(dense)) {
+    inverted_[attribute].emplace_back(handle);
+  }
+}
+
+void RegionStore::unlink(size_t dense) {
+  const SlotHandle handle = slots_.handle(dense);
+  for (const auto& attribute : attributesAt(dense)) {
+    const auto it = inverted_.find(attribute);
+    if (it == inverted_.end()) {
+      continue;
+    }
+    auto& handles = it->second;
+    handles.erase(std::remove(handles.begin(), handles.end(), handle),
+                  handles.end());
+    if (handles.empty()) {
+      inverted_.erase(it);
+    }
+  }
+}
+
+void RegionStore::erase(size_t dense) {
+  dead_attributes_ += attribute_counts_[dense];
+  const size_t last = indices_.size() - 1;
+  if (dense != last) {
+    indices_[dense] = indices_[last];
+    polygons_[dense] = std::move(polygons_[last]);
+    envelopes_[dense] = envelopes_[last];
+    attribute_offsets_[dense] = attribute_offsets_[last];
+    attribute_counts_[dense] = attribute_counts_[last];
+  }
+  indices_.pop_back();
+  polygons_.pop_back();
+  envelopes_.pop_back();
+  attribute_offsets_.pop_back();
+  attribute_counts_.pop_back();
+  if (dead_attributes_ > attributes_.size() / 2) {
+    compactAttributes();
+  }
+}
+
+void RegionStore::compactAttributes() {
+  std::vector<uint32_t> packed_attributes;
+  std::vector<int32_t> packed_values;
+  packed_attributes.reserve(attributes_.size() - dead_attributes_);
+  packed_values.reserve(values_.size() - dead_attributes_);
+  for (size_t i = 0; i < attribute_offsets_.size(); ++i) {
+    const size_t begin = attribute_offsets_[i];
+    const size_t end = begin + attribute_counts_[i];
+    attribute_offsets_[i] = static_cast<uint32_t>(packed_attributes.size());
+    packed_attributes.insert(packed_attributes.end(),
+                             attributes_.begin() + begin,
+                             attributes_.begin() + end);
+    packed_values.insert(packed_values.end(), values_.begin() + begin,
+                         values_.begin() + end);
+  }
+  attributes_.swap(packed_attributes);
+  values_.swap(packed_values);
+  dead_attributes_ = 0;
+}
+
+}  // namespace geometry
+}  // namespace innovusion
@@ -0,0 +1,60 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-30
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/src/rigid_transform2d.cc
+ */
+#include "rigid_transform2d.h"
+
+#include <Eigen/LU>
+#include <cmath>
+
+namespace innovusion {
+namespace geometry {
+
+RigidTransform2d::RigidTransform2d()
+    : row_y_(1.0, 0.0),
+      row_z_(0.0, 1.0),
+      translation_(0.0, 0.0),
+      inverse_y_(1.0, 0.0),
+      inverse_z_(0.0, 1.0) {}
+
+RigidTransform2d::RigidTransform2d(const Vec2d& row_y, const Vec2d& row_z,
+                                   const Vec2d& translation)
+    : row_y_(row_y),
+      row_z_(row_z),
+      translation_(translation),
+      inverse_y_(0.0, 0.0),
+      inverse_z_(0.0, 0.0) {
+  const double determinant = row_y.y * row_z.z - row_y.z * row_z.y;
+  if (std::fabs(determinant) > kGeometryEpsilon) {
+    inverse_y_ = Vec2d(row_z.z / determinant, -row_y.z / determinant);
+    inverse_z_ = Vec2d(-row_z.y / determinant, row_y.y / determinant);
+  }
+}
+
+bool RigidTransform2d::fromMatrix(const Eigen::Matrix4f& matrix,
+                                  float precision,
+                                  RigidTransform2d* transform) {
+  Eigen::Matrix3f rotation = matrix.block(0, 0, 3, 3);
+  if (std::fabs(rotation.determinant() - 1) >= precision) {
+    return false;
+  }
+  rotation = rotation.inverse().eval();
+  if (std::fabs(rotation(1, 1) * rotation(2, 2) -
+                rotation(1, 2) * rotation(2, 1)) < precision) {
+    return false;
+  }
+  *transform = RigidTransform2d({rotation(1, 1), rotation(1, 2)},
+                                {rotation(2, 1), rotation(2, 2)},
+                                {matrix(1, 3), matrix(2, 3)});
+  return true;
+}
+
+bool RigidTransform2d::isIdentity() const {
+  return row_y_ == Vec2d(1.0, 0.0) && row_z_ == Vec2d(0.0, 1.0) &&
+         translation_.isZeroVector();
+}
+
+}  // namespace geometry
+}  // namespace innovusion
@@ -0,0 +1,180 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-01
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/src/scan_classifier.cc
+ */
+#include "scan_classifier.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace innovusion {
+namespace geometry {
+
+namespace {
+inline GBox segmentEnvelope(const Vec2d& first, const Vec2d& second) {
+  return GBox(Vec2d(std::min(first.y, second.y), std::min(first.z, second.z)),
+              Vec2d(std::max(first.y, second.y), std::max(first.z, second.z)));
+}
+
+// false only if a is strictly on one side of the line through b, c and so is
+// d, i.e. near collinear counts as touching
+inline bool strictlySameSide(const Vec2d& b, const Vec2d& c, const Vec2d& a,
+                             const Vec2d& d) {
+  const Vec2d heading = c - b;
+  const double side_a = heading ^ (a - b);
+  const double side_d = heading ^ (d - b);
+  return (side_a > kGeometryEpsilon && side_d > kGeometryEpsilon) ||
+         (side_a < -kGeometryEpsilon && side_d < -kGeometryEpsilon);
+}
+}  // namespace
+
+ScanClassifier::ScanClassifier(const MultiplePolygon2d* polygons)
+    : polygons_(polygons),
+      inverted_(false),
+      version_(0),
+      indexed_(false),
+      has_last_(false),
+      last_point_(0.0, 0.0),
+      last_polygon_(kNone),
+      hits_(0),
+      misses_(0) {}
+
+ScanClassifier::ScanClassifier(const Roi2d* roi)
+    : ScanClassifier(static_cast<const MultiplePolygon2d*>(roi)) {
+  inverted_ = !roi->interested();
+}
+
+void ScanClassifier::reindex() {
+  edges_.clear();
+  envelopes_.clear();
+  for (size_t i = 0; i < polygons_->size(); ++i) {
+    const Polygon2d& polygon = polygons_->polygonAt(i);
+    const auto add_ring = [&](const GRing& ring) {
+      for (size_t j = 0; j + 1 < ring.size(); ++j) {
+        edges_.push_back({ring[j], ring[j + 1]});
+        envelopes_.emplace_back(segmentEnvelope(ring[j], ring[j + 1]));
+      }
+    };
+    add_ring(polygon.outer());
+    for (const auto& inner : polygon.inners()) {
+      add_ring(inner);
+    }
+  }
+  edge_index_.setCellSize(SpatialHash::suggestCellSize(envelopes_));
+  edge_index_.rebuild(envelopes_);
+
+  envelopes_.clear();
+  for (size_t i = 0; i < polygons_->size(); ++i) {
+    envelopes_.emplace_back(polygons_->envelopeAt(i));
+  }
+  polygon_index_.setCellSize(SpatialHash::suggestCellSize(envelopes_));
+  polygon_index_.rebuild(envelopes_);
+
+  version_ = polygons_->version();
+  indexed_ = true;
+  reset();
+}
+
+bool ScanClassifier::touchesEdge(const Vec2d& from, const Vec2d& to) {
+  edge_index_.overlapping(segmentEnvelope(from, to), &candidates_);
+  for (const auto& candidate : candidates_) {
+    const Edge& edge = edges_[candidate];
+    if (!strictlySameSide(edge.start, edge.end, from, to) &&
+        !strictlySameSide(from, to, edge.start, edge.end)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int64_t ScanClassifier::lookup(const Vec2d& point) {
+  if (last_polygon_ != kNone) {
+    const size_t dense = static_cast<size_t>(last_polygon_);
+    if (bg::covered_by(point, polygons_->envelopeAt(dense)) &&
+        polygons_->polygonAt(dense).within(point)) {
+      return last_polygon_;
+    }
+  }
+  polygon_index_.overlapping(GBox(point, point), &candidates_);
+  for (const auto& candidate : candidates_) {
+    if (bg::covered_by(point, polygons_->envelopeAt(candidate)) &&
+        polygons_->polygonAt(candidate).within(point)) {
+      return candidate;
+    }
+  }
+  return kNone;
+}
+
+bool ScanClassifier::within(const Vec2d& point) {
+  if (!indexed_ || version_ != polygons_->version()) {
+    reindex();
+  }
+  if (!std::isfinite(point.y) || !std::isfinite(point.z)) UNLIKELY {
+    // invalid return, no segment from or to it can be tested
+    ++misses_;
+    reset();
+    return false;
+  }
+  if (has_last_ && !touchesEdge(last_point_, point)) {
+    ++hits_;
+  } else {
+    const int64_t previous = last_polygon_;
+    last_polygon_ = lookup(point);
+    // the polygon of the previous point still contains this one
+    ++(previous != kNone && previous == last_polygon_ ? hits_ : misses_);
+  }
+  has_last_ = true;
+  last_point_ = point;
+  return last_polygon_ != kNone;
+}
+
+template <typename Points>
+void ScanClassifier::classify(const Points& points, bool useful,
+                              std::vector<uint8_t>* result) {
+  result->resize(points.size());
+  for (size_t i = 0; i < points.size(); ++i) {
+    const bool inside = within(points[i]);
+    (*result)[i] = (useful ? inside != inverted_ : inside) ? 1 : 0;
+  }
+}
+
+void ScanClassifier::within(std::span<const Vec2d> points,
+                            std::vector<uint8_t>* result) {
+  classify(points, false, result);
+}
+
+void ScanClassifier::within(const PointView& points,
+                            std::vector<uint8_t>* result) {
+  classify(points, false, result);
+}
+
+void ScanClassifier::isUseful(std::span<const Vec2d> points,
+                              std::vector<uint8_t>* result) {
+  classify(points, true, result);
+}
+
+void ScanClassifier::isUseful(const PointView& points,
+                              std::vector<uint8_t>* result) {
+  classify(points, true, result);
+}
+
+void ScanClassifier::reset() {
+  has_last_ = false;
+  last_polygon_ = kNone;
+}
+
+double ScanClassifier::hitRate() const {
+  const uint64_t total = hits_ + misses_;
+  return total == 0 ? 0.0
+                    : static_cast<double>(hits_) / static_cast<double>(total);
+}
+
+void ScanClassifier::resetMetrics() {
+  hits_ = 0;
+  misses_ = 0;
+}
+
+}  // namespace geometry
+}  // namespace innovusion
@@ -0,0 +1,276 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-04
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/src/shared_region_store.cc
+ */
+#include "shared_region_store.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+namespace innovusion {
+namespace geometry {
+
+struct SharedRegionControl {
+  static constexpr uint32_t kMagic = 0x4e525347;  // "GSRN" little endian
+  static constexpr uint32_t kVersion = 1;
+
+  // written last with release by create, cleared by unlink so mapped
+  // readers let go of a retired object
+  std::atomic<uint32_t> magic;
+  uint32_t version;
+  // generation of the latest image, 0 if none, release on publish
+  std::atomic<uint64_t> generation;
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+              "control fields must be address free to be shared");
+
+namespace {
+// the writer may unlink a generation between the load and the open
+constexpr int kOpenAttempts = 4;
+// an unchanged generation checks this often that name_ is still the mapped
+// control object, in case it was unlinked without unlink()
+constexpr std::chrono::seconds kControlCheckPeriod(1);
+
+std::string imageName(const std::string& name, uint64_t generation) {
+  return name + "." + std::to_string(generation);
+}
+
+bool writeImage(const std::string& name, const std::vector<uint8_t>& bytes) {
+  // leftover of a writer that died before bumping the generation
+  ::shm_unlink(name.c_str());
+  const int descriptor =
+      ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (descriptor < 0) {
+    return false;
+  }
+  void* mapping = MAP_FAILED;
+  if (::ftruncate(descriptor, static_cast<off_t>(bytes.size())) == 0) {
+    mapping = ::mmap(nullptr, bytes.size(), PROT_READ | PROT_WRITE,
+                     MAP_SHARED, descriptor, 0);
+  }
+  ::close(descriptor);
+  if (mapping == MAP_FAILED) {
+    ::shm_unlink(name.c_str());
+    return false;
+  }
+  std::memcpy(mapping, bytes.data(), bytes.size());
+  ::munmap(mapping, bytes.size());
+  return true;
+}
+}  // namespace
+
+SharedRegionWriter::SharedRegionWriter(const std::string& name)
+    : name_(name), control_(nullptr) {}
+
+SharedRegionWriter::~SharedRegionWriter() {
+  if (control_ != nullptr) {
+    ::munmap(control_, sizeof(SharedRegionControl));
+  }
+}
+
+bool SharedRegionWriter::create() {
+  if (control_ != nullptr) {
+    return true;
+  }
+  const int descriptor = ::shm_open(name_.c_str(), O_CREAT | O_RDWR, 0644);
+  if (descriptor < 0) {
+    return false;
+  }
+  struct stat status {};
+  void* mapping = MAP_FAILED;
+  if (::fstat(descriptor, &status) == 0 &&
+      (status.st_size >= off_t(sizeof(SharedRegionControl)) ||
+       ::ftruncate(descriptor, sizeof(SharedRegionControl)) == 0)) {
+    mapping = ::mmap(nullptr, sizeof(SharedRegionControl),
+                     PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+  }
+  ::close(descriptor);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+  control_ = static_cast<SharedRegionControl*>(mapping);
+  if (control_->magic.load(std::memory_order_acquire) !=
+          SharedRegionControl::kMagic ||
+      control_->version != SharedRegionControl::kVersion) {
+    // new object (zero filled) or another layout, readers reject it until
+    // the magic is written last
+    control_->generation.store(0, std::memory_order_relaxed);
+    control_->version = SharedRegionControl::kVersion;
+    control_->magic.store(SharedRegionControl::kMagic,
+                          std::memory_order_release);
+  }
+  return true;
+}
+
+bool SharedRegionWriter::publish(const RegionStore& regions,
+                                 const Roi2d& roi) {
+  if (control_ == nullptr) {
+    return false;
+  }
+  std::vector<uint8_t> bytes{};
+  RegionSnapshot::serialize(regions, roi, &bytes);
+  const uint64_t previous =
+      control_->generation.load(std::memory_order_relaxed);
+  const uint64_t next = previous + 1;
+  if (!writeImage(imageName(name_, next), bytes)) {
+    return false;
+  }
+  control_->generation.store(next, std::memory_order_release);
+  if (previous != 0) {
+    ::shm_unlink(imageName(name_, previous).c_str());
+  }
+  return true;
+}
+
+void SharedRegionWriter::unlink() {
+  const uint64_t latest = generation();
+  if (latest != 0) {
+    ::shm_unlink(imageName(name_, latest).c_str());
+  }
+  if (control_ != nullptr) {
+    // retire it first, readers then look the name up again
+    control_->magic.store(0, std::memory_order_release);
+  }
+  ::shm_unlink(name_.c_str());
+  if (control_ != nullptr) {
+    ::munmap(control_, sizeof(SharedRegionControl));
+    control_ = nullptr;
+  }
+}
+
+uint64_t SharedRegionWriter::generation() const {
+  return control_ == nullptr
+             ? 0
+             : control_->generation.load(std::memory_order_acquire);
+}
+
+SharedRegionReader::SharedRegionReader(const std::string& name, bool verify)
+    : name_(name),
+      verify_(verify),
+      control_(nullptr),
+      control_device_(0),
+      control_inode_(0),
+      generation_(0),
+      snapshot_(std::make_unique<RegionSnapshot>()) {}
+
+SharedRegionReader::~SharedRegionReader() { detachControl(); }
+
+bool SharedRegionReader::attachControl() {
+  if (control_ != nullptr) {
+    return true;
+  }
+  const int descriptor = ::shm_open(name_.c_str(), O_RDONLY, 0);
+  if (descriptor < 0) {
+    return false;
+  }
+  struct stat status {};
+  void* mapping = MAP_FAILED;
+  if (::fstat(descriptor, &status) == 0 &&
+      status.st_size >= off_t(sizeof(SharedRegionControl))) {
+    mapping = ::mmap(nullptr, sizeof(SharedRegionControl), PROT_READ,
+                     MAP_SHARED, descriptor, 0);
+  }
+  ::close(descriptor);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+  control_ = static_cast<const SharedRegionControl*>(mapping);
+  control_device_ = static_cast<uint64_t>(status.st_dev);
+  control_inode_ = static_cast<uint64_t>(status.st_ino);
+  next_check_ = std::chrono::steady_clock::now() + kControlCheckPeriod;
+  return true;
+}
+
+void SharedRegionReader::detachControl() {
+  if (control_ != nullptr) {
+    ::munmap(const_cast<SharedRegionControl*>(control_),
+             sizeof(SharedRegionControl));
+    control_ = nullptr;
+  }
+}
+
+bool SharedRegionReader::controlReplaced() {
+  const auto now = std::chrono::steady_clock::now();
+  if (now < next_check_) {
+    return false;
+  }
+  next_check_ = now + kControlCheckPeriod;
+  const int descriptor = ::shm_open(name_.c_str(), O_RDONLY, 0);
+  if (descriptor < 0) {
+    return true;
+  }
+  struct stat status {};
+  const bool same = ::fstat(descriptor, &status) == 0 &&
+                    static_cast<uint64_t>(status.st_dev) == control_device_ &&
+                    static_cast<uint64_t>(status.st_ino) == control_inode_;
+  ::close(descriptor);
+  return !same;
+}
+
+bool SharedRegionReader::refresh() {
+  // a retired control object belongs to a writer that called unlink(), a
+  // replaced one was unlinked behind our back; the snapshot stays mapped
+  if (control_ != nullptr &&
+      (control_->magic.load(std::memory_order_acquire) !=
+           SharedRegionControl::kMagic ||
+       (control_->generation.load(std::memory_order_relaxed) == generation_ &&
+        controlReplaced()))) {
+    detachControl();
+  }
+  if (!attachControl() ||
+      control_->magic.load(std::memory_order_acquire) !=
+          SharedRegionControl::kMagic ||
+      control_->version != SharedRegionControl::kVersion) {
+    // not written yet, look it up again next time
+    detachControl();
+    return generation_ != 0;
+  }
+  for (int attempt = 0; attempt < kOpenAttempts; ++attempt) {
+    const uint64_t latest =
+        control_->generation.load(std::memory_order_acquire);
+    if (latest == 0 || latest == generation_) {
+      break;
+    }
+    const int descriptor =
+        ::shm_open(imageName(name_, latest).c_str(), O_RDONLY, 0);
+    if (descriptor < 0) {
+      continue;
+    }
+    auto snapshot = std::make_unique<RegionSnapshot>();
+    const bool mapped = snapshot->map(descriptor, verify_);
+    ::close(descriptor);
+    if (mapped) {
+      snapshot_ = std::move(snapshot);
+      generation_ = latest;
+      break;
+    }
+  }
+  return generation_ != 0;
+}
+
+void SharedRegionReader::findRelatedMessage(
+    const PolygonPtr& box, std::vector<uint32_t>* attributes,
+    std::vector<int32_t>* values, std::vector<int32_t>* ious,
+    std::unordered_map<uint32_t, uint32_t>* flow) const {
+  snapshot_->findRelatedMessage(box, attributes, values, ious, flow);
+}
+
+bool SharedRegionReader::isUseful(const Vec2d& point) const {
+  return snapshot_->isUseful(point);
+}
+
+bool SharedRegionReader::isUseful(const PolygonPtr& others) const {
+  return snapshot_->isUseful(others);
+}
+
+}  // namespace geometry
+}  // namespace innovusion
@@ -0,0 +1,224 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-30
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/src/signed_distance_field.cc
+ */
+#include "signed_distance_field.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace innovusion {
+namespace geometry {
+
+namespace {
+// finite stand-in for infinity, keeps the parabola intersections NaN free
+constexpr double kFar = 1e20;
+
+/***
+ * @description: 1D squared distance transform of sampled function f (lower
+ * envelope of parabolas), f and d are strided views of the grid
+ */
+void distanceTransform(const double* f, size_t size, size_t stride, double* d,
+                       std::vector<size_t>* v, std::vector<double>* z) {
+  auto intersection = [&](size_t q, size_t p) {
+    return ((f[q * stride] + static_cast<double>(q * q)) -
+            (f[p * stride] + static_cast<double>(p * p))) /
+           (2.0 * static_cast<double>(q) - 2.0 * static_cast<double>(p));
+  };
+  size_t k = 0;
+  (*v)[0] = 0;
+  (*z)[0] = -kFar;
+  (*z)[1] = kFar;
+  for (size_t q = 1; q < size; ++q) {
+    // |s| < kFar / 2, the sentinel z[0] is never passed
+    double s = intersection(q, (*v)[k]);
+    while (k > 0 && s <= (*z)[k]) {
+      --k;
+      s = intersection(q, (*v)[k]);
+    }
+    ++k;
+    (*v)[k] = q;
+    (*z)[k] = s;
+    (*z)[k + 1] = kFar;
+  }
+  k = 0;
+  for (size_t q = 0; q < size; ++q) {
+    while ((*z)[k + 1] < static_cast<double>(q)) {
+      ++k;
+    }
+    const size_t p = (*v)[k];
+    const double offset = static_cast<double>(q) - static_cast<double>(p);
+    d[q * stride] = offset * offset + f[p * stride];
+  }
+}
+
+/***
+ * @description: Squared distance, in grid steps, from every node to the
+ * nearest node where feature is set
+ */
+void squaredDistances(const std::vector<uint8_t>& inside, uint8_t feature,
+                      size_t columns, size_t rows,
+                      std::vector<double>* distances) {
+  std::vector<double> f(inside.size());
+  for (size_t i = 0; i < inside.size(); ++i) {
+    f[i] = inside[i] == feature ? 0.0 : kFar;
+  }
+  distances->resize(inside.size());
+  const size_t longest = std::max(columns, rows);
+  std::vector<size_t> v(longest);
+  std::vector<double> z(longest + 1);
+  // along y inside every row, then along z inside every column
+  for (size_t row = 0; row < rows; ++row) {
+    distanceTransform(f.data() + row * columns, columns, 1,
+                      distances->data() + row * columns, &v, &z);
+  }
+  f.swap(*distances);
+  for (size_t column = 0; column < columns; ++column) {
+    distanceTransform(f.data() + column, rows, columns,
+                      distances->data() + column, &v, &z);
+  }
+}
+}  // namespace
+
+SignedDistanceField::SignedDistanceField()
+    : resolution_(0.0), columns_(0), rows_(0) {}
+
+void SignedDistanceField::clear() {
+  values_.clear();
+  columns_ = 0;
+  rows_ = 0;
+}
+
+bool SignedDistanceField::build(std::span<const Polygon2d> polygons,
+                                double resolution, double padding,
+                                size_t max_nodes) {
+  clear();
+  if (polygons.empty() || !(resolution > 0) || !std::isfinite(resolution)) {
+    return false;
+  }
+  GBox envelope;
+  bg::assign_inverse(envelope);
+  for (const auto& polygon : polygons) {
+    bg::expand(envelope, polygon.envelope());
+  }
+  padding = std::max(padding, resolution);
+  const Vec2d low = envelope.min_corner() - padding;
+  const Vec2d high = envelope.max_corner() + padding;
+  const double columns = std::ceil((high.y - low.y) / resolution) + 1;
+  const double rows = std::ceil((high.z - low.z) / resolution) + 1;
+  if (!(columns * rows <= static_cast<double>(max_nodes))) {
+    return false;
+  }
+  origin_ = low;
+  resolution_ = resolution;
+  columns_ = static_cast<size_t>(columns);
+  rows_ = static_cast<size_t>(rows);
+
+  std::vector<uint8_t> inside;
+  rasterize(polygons, &inside);
+  std::vector<double> to_inside;
+  std::vector<double> to_outside;
+  squaredDistances(inside, 1, columns_, rows_, &to_inside);
+  squaredDistances(inside, 0, columns_, rows_, &to_outside);
+  // the boundary lies about half a step before the nearest opposite node
+  values_.resize(inside.size());
+  for (size_t i = 0; i < inside.size(); ++i) {
+    const double steps = inside[i] ? -(std::sqrt(to_outside[i]) - 0.5)
+                                   : std::sqrt(to_inside[i]) - 0.5;
+    values_[i] = static_cast<float>(steps * resolution_);
+  }
+  return true;
+}
+
+void SignedDistanceField::rasterize(std::span<const Polygon2d> polygons,
+                                    std::vector<uint8_t>* inside) const {
+  inside->assign(columns_ * rows_, 0);
+  // (row, y) of every ring edge crossing a node row, half open in z
+  std::vector<std::pair<size_t, double>> crossings{};
+  auto addRing = [&](const GRing& ring) {
+    for (size_t i = 0; i + 1 < ring.size(); ++i) {
+      const Vec2d& a = ring[i];
+      const Vec2d& b = ring[i + 1];
+      if (a.z == b.z) {
+        continue;
+      }
+      const double low = std::min(a.z, b.z);
+      const double high = std::max(a.z, b.z);
+      const double first = std::ceil((low - origin_.z) / resolution_);
+      for (size_t row = static_cast<size_t>(std::max(first, 0.0));
+           row < rows_; ++row) {
+        const double z = origin_.z + static_cast<double>(row) * resolution_;
+        if (z >= high) {
+          break;
+        }
+        if (z >= low) {
+          crossings.emplace_back(row, a.y + (z - a.z) * (b.y - a.y) /
+                                              (b.z - a.z));
+        }
+      }
+    }
+  };
+  for (const auto& polygon : polygons) {
+    addRing(polygon.outer());
+    for (const auto& inner : polygon.inners()) {
+      addRing(inner);
+    }
+  }
+  std::sort(crossings.begin(), crossings.end());
+  // even odd fill, polygons do not overlap and holes are rings as well
+  for (size_t k = 0; k + 1 < crossings.size(); k += 2) {
+    const auto& [row, enter] = crossings[k];
+    const double leave = crossings[k + 1].second;
+    const double first = std::ceil((enter - origin_.y) / resolution_);
+    for (size_t column = static_cast<size_t>(std::max(first, 0.0));
+         column < columns_; ++column) {
+      const double y = origin_.y + static_cast<double>(column) * resolution_;
+      if (y >= leave) {
+        break;
+      }
+      (*inside)[row * columns_ + column] = 1;
+    }
+  }
+}
+
+bool SignedDistanceField::contains(const Vec2d& point) const {
+  if (values_.empty()) {
+    return false;
+  }
+  const double grid_y = (point.y - origin_.y) / resolution_;
+  const double grid_z = (point.z - origin_.z) / resolution_;
+  return grid_y >= 0 && grid_y <= static_cast<double>(columns_ - 1) &&
+         grid_z >= 0 && grid_z <= static_cast<double>(rows_ - 1);
+}
+
+double SignedDistanceField::sample(const Vec2d& point) const {
+  if (values_.empty()) {
+    return 0.0;
+  }
+  const double max_y = static_cast<double>(columns_ - 1);
+  const double max_z = static_cast<double>(rows_ - 1);
+  const double grid_y = (point.y - origin_.y) / resolution_;
+  const double grid_z = (point.z - origin_.z) / resolution_;
+  const double clamped_y = std::clamp(grid_y, 0.0, max_y);
+  const double clamped_z = std::clamp(grid_z, 0.0, max_z);
+  const size_t column =
+      std::min(static_cast<size_t>(clamped_y), columns_ - 2);
+  const size_t row = std::min(static_cast<size_t>(clamped_z), rows_ - 2);
+  const double ty = clamped_y - static_cast<double>(column);
+  const double tz = clamped_z - static_cast<double>(row);
+  const double low = nodeValue(column, row) * (1 - ty) +
+                     nodeValue(column + 1, row) * ty;
+  const double high = nodeValue(column, row + 1) * (1 - ty) +
+                      nodeValue(column + 1, row + 1) * ty;
+  const double value = low * (1 - tz) + high * tz;
+  // outside the grid, triangle inequality from the nearest grid point
+  const double outside =
+      std::hypot(grid_y - clamped_y, grid_z - clamped_z) * resolution_;
+  return value + outside;
+}
+
+}  // namespace geometry
+}  // namespace innovusion
@@ -0,0 +1,75 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-20
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/src/slot_map.cc
+ */
+#include "slot_map.h"
+
+#include <atomic>
+
+namespace innovusion {
+namespace geometry {
+
+uint64_t ContentVersion::next() {
+  static std::atomic<uint64_t> counter{0};
+  return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+SlotHandle SlotMap::insert() {
+  uint32_t slot;
+  if (free_slots_.empty()) {
+    slot = static_cast<uint32_t>(slot_dense_.size());
+    slot_dense_.emplace_back(0);
+    slot_generation_.emplace_back(0);
+  } else {
+    slot = free_slots_.back();
+    free_slots_.pop_back();
+  }
+  slot_dense_[slot] = static_cast<uint32_t>(dense_slot_.size());
+  dense_slot_.emplace_back(slot);
+  return {slot, slot_generation_[slot]};
+}
+
+bool SlotMap::erase(const SlotHandle& handle, size_t* hole) {
+  if (!contains(handle)) {
+    return false;
+  }
+  const uint32_t removed = slot_dense_[handle.slot];
+  const uint32_t moved_slot = dense_slot_.back();
+  dense_slot_[removed] = moved_slot;
+  slot_dense_[moved_slot] = removed;
+  dense_slot_.pop_back();
+
+  ++slot_generation_[handle.slot];
+  free_slots_.emplace_back(handle.slot);
+  *hole = removed;
+  return true;
+}
+
+bool SlotMap::contains(const SlotHandle& handle) const {
+  return handle.slot < slot_generation_.size() &&
+         slot_generation_[handle.slot] == handle.generation &&
+         slot_dense_[handle.slot] < dense_slot_.size() &&
+         dense_slot_[slot_dense_[handle.slot]] == handle.slot;
+}
+
+size_t SlotMap::dense(const SlotHandle& handle) const {
+  return slot_dense_[handle.slot];
+}
+
+SlotHandle SlotMap::handle(size_t dense) const {
+  const uint32_t slot = dense_slot_[dense];
+  return {slot, slot_generation_[slot]};
+}
+
+void SlotMap::clear() {
+  for (const auto& slot : dense_slot_) {
+    ++slot_generation_[slot];
+    free_slots_.emplace_back(slot);
+  }
+  dense_slot_.clear();
+}
+
+}  // namespace geometry
+}  // namespace innovusion
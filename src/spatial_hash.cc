@@ -0,0 +1,201 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-28
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/src/spatial_hash.cc
+ */
+#include "spatial_hash.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace innovusion {
+namespace geometry {
+
+namespace {
+// cell coordinates stay exact and far from int64 limits
+constexpr double kMaxCellCoordinate = 4503599627370496.0;  // 2^52
+
+inline bool intersects(const GBox& first, const GBox& second) {
+  return first.min_corner().y <= second.max_corner().y &&
+         second.min_corner().y <= first.max_corner().y &&
+         first.min_corner().z <= second.max_corner().z &&
+         second.min_corner().z <= first.max_corner().z;
+}
+
+inline GBox inflate(const GBox& box, double margin) {
+  return GBox(Vec2d(box.min_corner().y - margin, box.min_corner().z - margin),
+              Vec2d(box.max_corner().y + margin, box.max_corner().z + margin));
+}
+
+template <typename T>
+void sortUnique(std::vector<T>* values) {
+  std::sort(values->begin(), values->end());
+  values->erase(std::unique(values->begin(), values->end()), values->end());
+}
+}  // namespace
+
+SpatialHash::SpatialHash(double cell_size)
+    : cell_size_(cell_size), bucket_count_(1) {
+  setCellSize(cell_size);
+  offsets_.assign(bucket_count_ + 1, 0);
+}
+
+double SpatialHash::suggestCellSize(std::span<const GBox> envelopes) {
+  if (envelopes.empty()) {
+    return 0.0;
+  }
+  double sum = 0.0;
+  for (const auto& envelope : envelopes) {
+    sum += std::max(envelope.max_corner().y - envelope.min_corner().y,
+                    envelope.max_corner().z - envelope.min_corner().z);
+  }
+  return sum / static_cast<double>(envelopes.size());
+}
+
+void SpatialHash::setCellSize(double cell_size) {
+  // non positive sizes would make every envelope oversized
+  cell_size_ = cell_size > kGeometryEpsilon && std::isfinite(cell_size)
+                   ? cell_size
+                   : 1.0;
+  if (!envelopes_.empty()) {
+    index();
+  }
+}
+
+void SpatialHash::rebuild(std::span<const GBox> envelopes) {
+  envelopes_.assign(envelopes.begin(), envelopes.end());
+  index();
+}
+
+void SpatialHash::rebuild(const std::vector<PolygonPtr>& polygons) {
+  envelopes_.resize(polygons.size());
+  for (size_t i = 0; i < polygons.size(); ++i) {
+    envelopes_[i] = polygons[i]->envelope();
+  }
+  index();
+}
+
+double SpatialHash::envelopeDistance(const GBox& first, const GBox& second) {
+  const double gap_y =
+      std::max({0.0, first.min_corner().y - second.max_corner().y,
+                second.min_corner().y - first.max_corner().y});
+  const double gap_z =
+      std::max({0.0, first.min_corner().z - second.max_corner().z,
+                second.min_corner().z - first.max_corner().z});
+  return std::hypot(gap_y, gap_z);
+}
+
+bool gridCellRange(const GBox& box, const Vec2d& origin, double cell_size,
+                   CellRange* range) {
+  const double min_y = std::floor((box.min_corner().y - origin.y) / cell_size);
+  const double min_z = std::floor((box.min_corner().z - origin.z) / cell_size);
+  const double max_y = std::floor((box.max_corner().y - origin.y) / cell_size);
+  const double max_z = std::floor((box.max_corner().z - origin.z) / cell_size);
+  // also rejects NaN
+  if (!(min_y >= -kMaxCellCoordinate && max_y <= kMaxCellCoordinate &&
+        min_z >= -kMaxCellCoordinate && max_z <= kMaxCellCoordinate &&
+        min_y <= max_y && min_z <= max_z)) {
+    return false;
+  }
+  *range = {static_cast<int64_t>(min_y), static_cast<int64_t>(min_z),
+            static_cast<int64_t>(max_y), static_cast<int64_t>(max_z)};
+  return true;
+}
+
+bool SpatialHash::cellRange(const GBox& box, CellRange* range) const {
+  return gridCellRange(box, Vec2d(0.0, 0.0), cell_size_, range) &&
+         static_cast<double>(range->max_y - range->min_y + 1) *
+                 static_cast<double>(range->max_z - range->min_z + 1) <=
+             static_cast<double>(bucket_count_);
+}
+
+void SpatialHash::index() {
+  const size_t size = envelopes_.size();
+  bucket_count_ = 16;
+  while (bucket_count_ < 2 * size) {
+    bucket_count_ <<= 1;
+  }
+  oversized_.clear();
+  ranges_.resize(size);
+  for (size_t i = 0; i < size; ++i) {
+    if (!cellRange(envelopes_[i], &ranges_[i])) {
+      // empty range, not bucketed
+      ranges_[i] = {0, 0, -1, -1};
+      oversized_.emplace_back(static_cast<uint32_t>(i));
+    }
+  }
+  countingSort(
+      ranges_, bucket_count_,
+      [this](int64_t y, int64_t z) { return bucketOf(y, z); }, &offsets_,
+      &entries_, &cursor_);
+}
+
+template <typename Visitor>
+void SpatialHash::visitCandidates(const GBox& region, Visitor&& visit) const {
+  CellRange range;
+  if (!cellRange(region, &range)) {
+    // region spans more cells than there are buckets, scan everything
+    for (size_t i = 0; i < envelopes_.size(); ++i) {
+      visit(static_cast<uint32_t>(i));
+    }
+    return;
+  }
+  for (int64_t y = range.min_y; y <= range.max_y; ++y) {
+    for (int64_t z = range.min_z; z <= range.max_z; ++z) {
+      const size_t bucket = bucketOf(y, z);
+      for (uint32_t k = offsets_[bucket]; k < offsets_[bucket + 1]; ++k) {
+        visit(entries_[k]);
+      }
+    }
+  }
+  for (const auto& item : oversized_) {
+    visit(item);
+  }
+}
+
+void SpatialHash::near(const Vec2d& point, double radius,
+                       std::vector<uint32_t>* items) const {
+  near(GBox(point, point), radius, items);
+}
+
+void SpatialHash::near(const GBox& box, double radius,
+                       std::vector<uint32_t>* items) const {
+  items->clear();
+  visitCandidates(inflate(box, radius), [&](uint32_t item) {
+    if (envelopeDistance(box, envelopes_[item]) <= radius) {
+      items->emplace_back(item);
+    }
+  });
+  sortUnique(items);
+}
+
+void SpatialHash::overlapping(const GBox& region,
+                              std::vector<uint32_t>* items) const {
+  items->clear();
+  visitCandidates(region, [&](uint32_t item) {
+    if (intersects(region, envelopes_[item])) {
+      items->emplace_back(item);
+    }
+  });
+  sortUnique(items);
+}
+
+void SpatialHash::candidatePairs(
+    double distance, std::vector<std::pair<uint32_t, uint32_t>>* pairs) const {
+  pairs->clear();
+  for (size_t i = 0; i < envelopes_.size(); ++i) {
+    const GBox& envelope = envelopes_[i];
+    const uint32_t first = static_cast<uint32_t>(i);
+    visitCandidates(inflate(envelope, distance), [&](uint32_t item) {
+      if (item > first &&
+          envelopeDistance(envelope, envelopes_[item]) <= distance) {
+        pairs->emplace_back(first, item);
+      }
+    });
+  }
+  sortUnique(pairs);
+}
+
+}  // namespace geometry
+}  // namespace innovusion
@@ -0,0 +1,131 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-28
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/src/temporal_iou_cache.cc
+ */
+#include "temporal_iou_cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace innovusion {
+namespace geometry {
+
+namespace {
+typedef bg::model::linestring<Vec2d> GLinestring;
+
+// distance between the boundaries, not the areas
+double ringBoundaryDistance(const GRing& ring, const GPolygon& polygon) {
+  const GLinestring line(ring.begin(), ring.end());
+  double distance = bg::distance(
+      line, GLinestring(polygon.outer().begin(), polygon.outer().end()));
+  for (const auto& inner : polygon.inners()) {
+    distance = std::min(
+        distance, bg::distance(line, GLinestring(inner.begin(), inner.end())));
+  }
+  return distance;
+}
+}  // namespace
+
+CoherentIouResult TemporalIouCache::query(uint32_t track, uint32_t region_id,
+                                          uint64_t region_version,
+                                          const PolygonPtr& box,
+                                          const Polygon2d& region) {
+  CoherentIouResult result;
+  Entry& entry = entries_[key(track, region_id)];
+  if (entry.region_version == region_version &&
+      entry.placement != Placement::Crossing &&
+      box->inners().empty()) {
+    const double moved = displacement(box->outer(), entry.ring);
+    if (moved >= 0 && moved < entry.margin) {
+      ++hits_;
+      result.cached = true;
+      if (entry.placement == Placement::Inside && entry.region_area > 0) {
+        // intersection is the box itself, union is the region
+        const double box_area = box->area();
+        result.iou = box_area / entry.region_area;
+        result.iou_target =
+            static_cast<int>(std::round(box_area / entry.region_area * 100));
+      }
+      return result;
+    }
+  }
+  ++misses_;
+  refresh(region_version, box, region, &result, &entry);
+  return result;
+}
+
+void TemporalIouCache::refresh(uint64_t region_version, const PolygonPtr& box,
+                               const Polygon2d& region,
+                               CoherentIouResult* result, Entry* entry) {
+  result->iou = region.iou(box);
+  result->iou_target = region.iouSelf(box);
+
+  entry->region_version = region_version;
+  entry->region_area = region.area();
+  entry->placement = Placement::Crossing;
+  entry->margin = 0.0;
+  entry->ring.clear();
+  if (!box->inners().empty()) {
+    return;
+  }
+  const GPolygon& box_polygon = box->getPolygon();
+  const GPolygon& region_polygon = region.getPolygon();
+  if (result->iou <= 0) {
+    entry->placement = Placement::Outside;
+    entry->margin = bg::distance(box_polygon, region_polygon);
+  } else if (bg::covered_by(box_polygon, region_polygon)) {
+    entry->placement = Placement::Inside;
+    entry->margin = ringBoundaryDistance(box_polygon.outer(), region_polygon);
+  }
+  if (entry->placement != Placement::Crossing && entry->margin > 0) {
+    entry->ring.assign(box_polygon.outer().begin(), box_polygon.outer().end());
+  } else {
+    entry->placement = Placement::Crossing;
+  }
+}
+
+double TemporalIouCache::displacement(const GRing& current,
+                                      const std::vector<Vec2d>& cached) {
+  if (current.size() != cached.size()) {
+    return -1.0;
+  }
+  // a boundary point is the same interpolation of its edge vertices in both
+  // rings, so it moves at most as far as the farthest vertex
+  double moved = 0.0;
+  for (size_t i = 0; i < current.size(); ++i) {
+    moved = std::max(moved, (current[i] - cached[i]).norm());
+  }
+  return std::isfinite(moved) ? moved : -1.0;
+}
+
+void TemporalIouCache::eraseTrack(uint32_t track) {
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    it = (it->first >> 32) == track ? entries_.erase(it) : std::next(it);
+  }
+}
+
+void TemporalIouCache::eraseRegion(uint32_t region_id) {
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    it = static_cast<uint32_t>(it->first) == region_id ? entries_.erase(it)
+                                                       : std::next(it);
+  }
+}
+
+void TemporalIouCache::clear() { entries_.clear(); }
+
+double TemporalIouCache::hitRate() const {
+  const uint64_t total = hits_ + misses_;
+  return total == 0 ? 0.0
+                    : static_cast<double>(hits_) / static_cast<double>(total);
+}
+
+void TemporalIouCache::resetMetrics() {
+  hits_ = 0;
+  misses_ = 0;
+}
+
+}  // namespace geometry
+}  // namespace innovusion
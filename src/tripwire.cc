@@ -0,0 +1,168 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-29
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/src/tripwire.cc
+ */
+#include "tripwire.h"
+
+#include <algorithm>
+
+namespace innovusion {
+namespace geometry {
+
+namespace {
+inline Vec2d midpoint(const Gsegment& segment) {
+  return (segment.first + segment.second) / 2;
+}
+
+inline GBox segmentEnvelope(const Vec2d& first, const Vec2d& second) {
+  return GBox(Vec2d(std::min(first.y, second.y), std::min(first.z, second.z)),
+              Vec2d(std::max(first.y, second.y), std::max(first.z, second.z)));
+}
+}  // namespace
+
+TripwireSet::TripwireSet() : dirty_(false), frame_(0) {}
+
+bool TripwireSet::addLine(uint32_t line, const Vec2d& start,
+                          const Vec2d& end) {
+  if ((end - start).norm() < kGeometryEpsilon) {
+    return false;
+  }
+  const auto it = std::find_if(lines_.begin(), lines_.end(),
+                               [&](const Line& l) { return l.id == line; });
+  if (it == lines_.end()) {
+    lines_.push_back({line, start, end, 0, 0});
+  } else {
+    *it = {line, start, end, 0, 0};
+    forget(line);
+  }
+  dirty_ = true;
+  return true;
+}
+
+bool TripwireSet::removeLine(uint32_t line) {
+  const auto it = std::find_if(lines_.begin(), lines_.end(),
+                               [&](const Line& l) { return l.id == line; });
+  if (it == lines_.end()) {
+    return false;
+  }
+  lines_.erase(it);
+  forget(line);
+  dirty_ = true;
+  return true;
+}
+
+void TripwireSet::forget(uint32_t line) {
+  for (auto& [track, state] : tracks_) {
+    std::erase_if(state.touching,
+                  [&](const Touch& touch) { return touch.line == line; });
+  }
+}
+
+void TripwireSet::reindex() {
+  envelopes_.clear();
+  for (const auto& line : lines_) {
+    envelopes_.emplace_back(segmentEnvelope(line.start, line.end));
+  }
+  index_.setCellSize(SpatialHash::suggestCellSize(envelopes_));
+  index_.rebuild(envelopes_);
+  dirty_ = false;
+}
+
+int TripwireSet::side(const Line& line, const Vec2d& point) {
+  const double value = (line.end - line.start) ^ (point - line.start);
+  return (value > 0) - (value < 0);
+}
+
+bool TripwireSet::reaches(const Line& line, const Vec2d& from,
+                          const Vec2d& to) {
+  // line end points on both sides of the motion (or on it)
+  const Vec2d motion = to - from;
+  const double start_side = motion ^ (line.start - from);
+  const double end_side = motion ^ (line.end - from);
+  return !((start_side > 0 && end_side > 0) ||
+           (start_side < 0 && end_side < 0));
+}
+
+void TripwireSet::update(std::span<const TripwireTrack> tracks,
+                         std::vector<TripwireCrossing>* crossings) {
+  crossings->clear();
+  if (dirty_) {
+    reindex();
+  }
+  ++frame_;
+  for (const auto& [track, segment] : tracks) {
+    const Vec2d current = midpoint(segment);
+    auto [it, inserted] = tracks_.try_emplace(track);
+    TrackState& state = it->second;
+    // a track missing from the previous frame starts a new motion
+    const bool moving = !inserted && state.seen_frame + 1 == frame_;
+    const Vec2d previous = state.previous;
+    state.previous = current;
+    state.seen_frame = frame_;
+    if (!moving) {
+      state.touching.clear();
+      continue;
+    }
+    if (lines_.empty()) {
+      continue;
+    }
+    index_.overlapping(segmentEnvelope(previous, current), &candidates_);
+    for (const auto& candidate : candidates_) {
+      Line& line = lines_[candidate];
+      const auto touch = std::find_if(
+          state.touching.begin(), state.touching.end(),
+          [&](const Touch& t) { return t.line == line.id; });
+      int from_side = side(line, previous);
+      if (from_side == 0) {
+        from_side = touch != state.touching.end() ? touch->side : 0;
+      }
+      const int to_side = side(line, current);
+      if (to_side == 0) {
+        // on the line, remember where the track came from
+        if (from_side != 0 && touch == state.touching.end() &&
+            reaches(line, previous, current)) {
+          state.touching.push_back({line.id, from_side});
+        }
+        continue;
+      }
+      if (touch != state.touching.end()) {
+        state.touching.erase(touch);
+      }
+      if (from_side == -to_side && reaches(line, previous, current)) {
+        const TripwireDirection direction = from_side > 0
+                                                ? TripwireDirection::Forward
+                                                : TripwireDirection::Backward;
+        ++(direction == TripwireDirection::Forward ? line.forward
+                                                   : line.backward);
+        crossings->push_back({track, line.id, direction});
+      }
+    }
+  }
+  for (auto it = tracks_.begin(); it != tracks_.end();) {
+    it = it->second.seen_frame == frame_ ? std::next(it) : tracks_.erase(it);
+  }
+}
+
+bool TripwireSet::counts(uint32_t line, uint64_t* forward,
+                         uint64_t* backward) const {
+  const auto it = std::find_if(lines_.begin(), lines_.end(),
+                               [&](const Line& l) { return l.id == line; });
+  if (it == lines_.end()) {
+    return false;
+  }
+  *forward = it->forward;
+  *backward = it->backward;
+  return true;
+}
+
+void TripwireSet::resetCounts() {
+  for (auto& line : lines_) {
+    line.forward = 0;
+    line.backward = 0;
+  }
+}
+
+}  // namespace geometry
+}  // namespace innovusion
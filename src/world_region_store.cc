@@ -0,0 +1,128 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-02
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/src/world_region_store.cc
+ */
+#include "world_region_store.h"
+
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace innovusion {
+namespace geometry {
+
+SensorRegionView::SensorRegionView() : store_(nullptr), identity_(true) {}
+
+SensorRegionView::SensorRegionView(const WorldRegionStore* store,
+                                   const RigidTransform2d& transform)
+    : store_(store),
+      transform_(transform),
+      identity_(transform.isIdentity()) {}
+
+PolygonPtr SensorRegionView::toWorld(const PolygonPtr& polygon) const {
+  if (identity_) {
+    return polygon;
+  }
+  GPolygon moved = polygon->getPolygon();
+  for (auto& point : moved.outer()) {
+    point = transform_.inverse(point);
+  }
+  for (auto& inner : moved.inners()) {
+    for (auto& point : inner) {
+      point = transform_.inverse(point);
+    }
+  }
+  auto result = std::make_shared<Polygon2d>(polygon->type(), std::move(moved));
+  // a mirroring transform flips the rings orientation
+  result->correct();
+  return result;
+}
+
+void SensorRegionView::findRelatedMessage(
+    const PolygonPtr& box, std::vector<uint32_t>* attributes,
+    std::vector<int32_t>* values, std::vector<int32_t>* ious,
+    std::unordered_map<uint32_t, uint32_t>* flow) const {
+  const PolygonPtr world = toWorld(box);
+  std::shared_lock<std::shared_mutex> lock(store_->mutex_);
+  store_->regions_.findRelatedMessage(world, attributes, values, ious, flow);
+}
+
+bool SensorRegionView::isUseful(const PolygonPtr& others) const {
+  const PolygonPtr world = toWorld(others);
+  std::shared_lock<std::shared_mutex> lock(store_->mutex_);
+  return store_->roi_.isUseful(world);
+}
+
+bool SensorRegionView::isUseful(const Vec2d& point) const {
+  const Vec2d world = toWorld(point);
+  std::shared_lock<std::shared_mutex> lock(store_->mutex_);
+  return store_->roi_.isUseful(world);
+}
+
+WorldRegionStore::WorldRegionStore(bool roi_interested, int roi_rate)
+    : roi_(roi_interested, roi_rate) {}
+
+bool WorldRegionStore::add(size_t index, const std::vector<Vec2d>& outer,
+                           const std::vector<std::vector<Vec2d>>& inners,
+                           const std::vector<uint32_t>& attributes,
+                           const std::vector<int32_t>& values) {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  return regions_.add(index, outer, inners, attributes, values);
+}
+
+bool WorldRegionStore::remove(size_t index) {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  return regions_.remove(index);
+}
+
+bool WorldRegionStore::addRoi(size_t index, const std::vector<Vec2d>& outer,
+                              const std::vector<std::vector<Vec2d>>& inners) {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  return roi_.add(index, outer, inners);
+}
+
+bool WorldRegionStore::removeRoi(size_t index) {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  return roi_.remove(index);
+}
+
+void WorldRegionStore::addSensor(uint32_t sensor,
+                                 const RigidTransform2d& transform) {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  sensors_.insert_or_assign(sensor, transform);
+}
+
+bool WorldRegionStore::removeSensor(uint32_t sensor) {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  return sensors_.erase(sensor) > 0;
+}
+
+bool WorldRegionStore::view(uint32_t sensor, SensorRegionView* view) const {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  const auto it = sensors_.find(sensor);
+  if (it == sensors_.end()) {
+    return false;
+  }
+  *view = SensorRegionView(this, it->second);
+  return true;
+}
+
+size_t WorldRegionStore::size() const {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  return regions_.size();
+}
+
+size_t WorldRegionStore::roiSize() const {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  return roi_.size();
+}
+
+size_t WorldRegionStore::sensorCount() const {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  return sensors_.size();
+}
+
+}  // namespace geometry
+}  // namespace innovusion
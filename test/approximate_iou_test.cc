@@ -0,0 +1,70 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-22
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/test/approximate_iou_test.cc
+ */
+#include "approximate_iou.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "region2d.h"
+
+using innovusion::geometry::ApproximateIou;
+using innovusion::geometry::ApproximateIouResult;
+using innovusion::geometry::Box2d;
+using innovusion::geometry::Polygon2d;
+using innovusion::geometry::PolygonPtr;
+using innovusion::geometry::PolygonType;
+using innovusion::geometry::Vec2d;
+
+// should be exact for identical and disjoint boxes
+TEST(ApproximateIouTest, trivial) {
+  ApproximateIou engine(0.01);
+  Box2d box(Vec2d(0.0, 0.0), 4.0, 2.0, 3000);
+  Box2d far(Vec2d(50.0, 0.0), 4.0, 2.0, 3000);
+  ApproximateIouResult same = engine.estimate(box, box);
+  EXPECT_NEAR(same.iou, 1.0, 1e-6);
+  EXPECT_LE(same.error, 0.01);
+  ApproximateIouResult none = engine.estimate(box, far, 0.5);
+  EXPECT_EQ(none.iou, 0.0);
+  EXPECT_EQ(none.error, 0.0);
+  EXPECT_FALSE(none.ambiguous);
+}
+
+// should stay within the reported bound of the exact overlay
+TEST(ApproximateIouTest, bounded_error) {
+  std::mt19937 generator(7);
+  std::uniform_real_distribution<double> offset(-3.0, 3.0);
+  std::uniform_real_distribution<double> size(1.0, 6.0);
+  std::uniform_int_distribution<uint32_t> spindle(0, 35999);
+  ApproximateIou engine(0.02);
+  for (int i = 0; i < 200; ++i) {
+    PolygonPtr first = std::make_shared<Box2d>(Vec2d(0.0, 0.0), size(generator),
+                                               size(generator),
+                                               spindle(generator));
+    PolygonPtr second = std::make_shared<Box2d>(
+        Vec2d(offset(generator), offset(generator)), size(generator),
+        size(generator), spindle(generator));
+    const double exact = first->iou(second);
+    ApproximateIouResult result = engine.estimate(*first, *second, 0.5);
+    EXPECT_LE(result.error, 0.02 + 1e-9);
+    EXPECT_NEAR(result.iou, exact, result.error + 1e-9);
+    EXPECT_EQ(engine.iouAtLeast(first, second, 0.5), exact >= 0.5);
+  }
+}
+
+// should handle regions with holes against a box
+TEST(ApproximateIouTest, region_with_hole) {
+  std::vector<Vec2d> outer = {{-10, -10}, {-10, 10}, {10, 10}, {10, -10}};
+  std::vector<Vec2d> hole = {{-2, -2}, {-2, 2}, {2, 2}, {2, -2}};
+  PolygonPtr box = std::make_shared<Box2d>(Vec2d(0.0, 0.0), 8.0, 8.0, 4500);
+  PolygonPtr region = std::make_shared<Polygon2d>(
+      PolygonType::Region, outer, std::vector<std::vector<Vec2d>>{hole});
+  ApproximateIou engine(0.01);
+  ApproximateIouResult result = engine.estimate(*box, *region);
+  EXPECT_NEAR(result.iou, box->iou(region), result.error + 1e-9);
+  EXPECT_LE(result.error, 0.01 + 1e-9);
+}
@@ -0,0 +1,127 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-27
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/test/cluster_geometry_test.cc
+ */
+#include "cluster_geometry.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "region2d.h"
+
+using innovusion::geometry::Box2d;
+using innovusion::geometry::BoxParameters;
+using innovusion::geometry::convexHull;
+using innovusion::geometry::fitBox;
+using innovusion::geometry::minimumAreaBox;
+using innovusion::geometry::Vec2d;
+
+// should hull a square with interior and collinear points
+TEST(ClusterGeometryTest, hull_square) {
+  std::vector<Vec2d> points = {{0, 0}, {1, 1}, {2, 2}, {0, 2}, {2, 0},
+                               {1, 0}, {0, 1}, {1, 1}, {2, 1}};
+  std::vector<Vec2d> hull(points.size() + 1);
+  ASSERT_EQ(convexHull(points, hull), 4);
+  hull.resize(4);
+  hull.emplace_back(hull.front());
+  // clockwise ring has a positive area in boost geometry
+  innovusion::geometry::GRing ring(hull.begin(), hull.end());
+  EXPECT_NEAR(boost::geometry::area(ring), 4.0, 1e-9);
+
+  std::vector<Vec2d> small(points.size());
+  EXPECT_EQ(convexHull(points, small), 0);
+}
+
+// should handle degenerated clusters
+TEST(ClusterGeometryTest, degenerated) {
+  std::vector<Vec2d> buffer(8);
+  BoxParameters box;
+  std::vector<Vec2d> single = {{3, 4}, {3, 4}, {3, 4}};
+  ASSERT_TRUE(fitBox(single, buffer, &box));
+  EXPECT_TRUE(box.center == Vec2d(3, 4));
+  EXPECT_EQ(box.length, 0.0);
+
+  std::vector<Vec2d> line = {{0, 0}, {1, 0}, {2, 0}, {3, 0}};
+  ASSERT_TRUE(fitBox(line, buffer, &box));
+  EXPECT_NEAR(box.length, 3.0, 1e-9);
+  EXPECT_NEAR(box.width, 0.0, 1e-9);
+  EXPECT_EQ(box.spindle, 9000);
+  EXPECT_TRUE(box.center == Vec2d(1.5, 0));
+
+  std::vector<Vec2d> empty;
+  EXPECT_FALSE(fitBox(empty, buffer, &box));
+}
+
+// should recover a sampled rotated box in Box2d convention
+TEST(ClusterGeometryTest, recover_box) {
+  std::mt19937 generator(3);
+  std::uniform_real_distribution<double> unit(-0.5, 0.5);
+  for (uint32_t spindle : {0u, 1234u, 3000u, 9000u, 17000u}) {
+    Box2d reference(Vec2d(5.0, -3.0), 4.0, 2.0, spindle);
+    const auto& ring = reference.outer();
+    std::vector<Vec2d> points(ring.begin(), ring.end() - 1);
+    for (int i = 0; i < 200; ++i) {
+      // interior samples
+      const double a = unit(generator);
+      const double b = unit(generator);
+      points.emplace_back(ring[2] + (ring[1] - ring[2]) * (a + 0.5) +
+                          (ring[3] - ring[2]) * (b + 0.5));
+    }
+    std::vector<Vec2d> buffer(points.size() + 1);
+    BoxParameters box;
+    ASSERT_TRUE(fitBox(points, buffer, &box));
+    EXPECT_NEAR(box.length, 4.0, 1e-6);
+    EXPECT_NEAR(box.width, 2.0, 1e-6);
+    EXPECT_EQ(box.spindle, spindle % 18000);
+    EXPECT_NEAR(box.center.y, 5.0, 1e-6);
+    EXPECT_NEAR(box.center.z, -3.0, 1e-6);
+  }
+}
+
+// should match a brute force search on random clusters of 10 to 10k points
+TEST(ClusterGeometryTest, random_clusters) {
+  std::mt19937 generator(11);
+  std::normal_distribution<double> spread(0.0, 1.0);
+  for (size_t size : {10u, 100u, 1000u, 10000u}) {
+    std::vector<Vec2d> points;
+    for (size_t i = 0; i < size; ++i) {
+      points.emplace_back(3.0 * spread(generator), spread(generator));
+    }
+    const std::vector<Vec2d> cloud = points;
+    std::vector<Vec2d> buffer(points.size() + 1);
+    const size_t count = convexHull(points, buffer);
+    ASSERT_GE(count, 3);
+    std::span<const Vec2d> hull(buffer.data(), count);
+    BoxParameters box;
+    ASSERT_TRUE(minimumAreaBox(hull, &box));
+
+    // brute force over every hull edge direction
+    double best = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < count; ++i) {
+      Vec2d u = hull[(i + 1) % count] - hull[i];
+      u.normalize();
+      const Vec2d n(u.z, -u.y);
+      double min_u = 1e9, max_u = -1e9, min_n = 1e9, max_n = -1e9;
+      for (const auto& point : hull) {
+        min_u = std::min(min_u, point * u);
+        max_u = std::max(max_u, point * u);
+        min_n = std::min(min_n, point * n);
+        max_n = std::max(max_n, point * n);
+      }
+      best = std::min(best, (max_u - min_u) * (max_n - min_n));
+    }
+    EXPECT_NEAR(box.length * box.width, best, 1e-6 * best);
+    EXPECT_GE(box.length, box.width);
+
+    // the box covers the cluster up to the 0.01 degree quantization
+    Box2d fitted(box.center, box.length, box.width, box.spindle);
+    const double tolerance = box.length * M_PI / 18000;
+    for (const auto& point : cloud) {
+      EXPECT_LE(boost::geometry::distance(point, fitted.getPolygon()),
+                tolerance);
+    }
+  }
+}
@@ -0,0 +1,94 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-25
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/test/frame_arena_test.cc
+ */
+#include "frame_arena.h"
+
+#include <gtest/gtest.h>
+
+#include "region2d.h"
+#include "region_store.h"
+
+using innovusion::geometry::Box2d;
+using innovusion::geometry::FrameArena;
+using innovusion::geometry::FrameBox;
+using innovusion::geometry::Polygon2d;
+using innovusion::geometry::PolygonPtr;
+using innovusion::geometry::PolygonType;
+using innovusion::geometry::RegionStore;
+using innovusion::geometry::Vec2d;
+
+class FrameArenaTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    outer = {{-100, -100}, {-100, 100}, {100, 100}, {100, -100}};
+    valley = {{-50, -50}, {-50, 50}, {0, 0}, {50, 50}, {50, -50}};
+  }
+  std::vector<Vec2d> outer;
+  std::vector<Vec2d> valley;
+};
+
+// should match Box2d geometry with a frame box
+TEST_F(FrameArenaTest, box_geometry) {
+  FrameArena arena;
+  FrameBox box = arena.makeBox({10, 10}, 20, 10, 0);
+  Box2d reference({10, 10}, 20, 10, 0);
+  EXPECT_NEAR(box.area(), reference.area(), 1e-6);
+  EXPECT_TRUE(box.f_segment().first == reference.f_segment().first);
+  EXPECT_TRUE(box.f_segment().second == reference.f_segment().second);
+  EXPECT_TRUE(box.within({10, 10}));
+  EXPECT_FALSE(box.within({15, 10}));
+  EXPECT_FALSE(box.within({30, 10}));
+  EXPECT_TRUE(boost::geometry::equals(box.envelope(), reference.envelope()));
+}
+
+// should clip against a region with a non convex hole as the overlay
+TEST_F(FrameArenaTest, overlap_matches_overlay) {
+  FrameArena arena;
+  Polygon2d region(PolygonType::Region, outer, {valley});
+  PolygonPtr ptr_region = std::make_shared<Polygon2d>(region);
+  for (uint32_t spindle : {0u, 3000u, 4500u, 9000u, 17999u}) {
+    for (const auto& center :
+         {Vec2d(-110, 0), Vec2d(-50, 0), Vec2d(0, 0), Vec2d(50, 50)}) {
+      FrameBox box = arena.makeBox(center, 60, 30, spindle);
+      Box2d reference(center, 60, 30, spindle);
+      EXPECT_NEAR(box.calculateIntersectionArea(region, &arena),
+                  reference.calculateIntersectionArea(ptr_region), 1e-3);
+      // exact halves may round either way
+      EXPECT_NEAR(box.iouSelf(region, &arena), reference.iouSelf(ptr_region),
+                  1);
+      EXPECT_NEAR(box.iouTarget(region, &arena),
+                  reference.iouTarget(ptr_region), 1);
+    }
+  }
+}
+
+// should fit a whole frame into the initial block and reuse it
+TEST_F(FrameArenaTest, no_upstream_allocation) {
+  FrameArena arena(256 * 1024, std::pmr::null_memory_resource());
+  RegionStore store;
+  EXPECT_TRUE(store.add(1, outer, {valley}, {1, 2}, {10, 20}));
+  std::vector<uint32_t> attributes;
+  std::vector<int32_t> values;
+  std::vector<int32_t> ious;
+  for (int frame = 0; frame < 3; ++frame) {
+    for (int i = 0; i < 200; ++i) {
+      FrameBox box = arena.makeBox({-95.0 + i, 0.0}, 20, 10, 100 * i);
+      store.findRelatedMessage(box, &arena, &attributes, &values, &ious,
+                               nullptr);
+    }
+    arena.reset();
+  }
+  FrameBox box = arena.makeBox({-60, 0}, 20, 10, 0);
+  PolygonPtr reference = std::make_shared<Box2d>(Vec2d(-60, 0), 20, 10, 0);
+  store.findRelatedMessage(box, &arena, &attributes, &values, &ious, nullptr);
+  std::vector<uint32_t> expected_attributes;
+  std::vector<int32_t> expected_values;
+  std::vector<int32_t> expected_ious;
+  store.findRelatedMessage(reference, &expected_attributes, &expected_values,
+                           &expected_ious, nullptr);
+  EXPECT_EQ(attributes, expected_attributes);
+  EXPECT_EQ(ious, expected_ious);
+}
@@ -14,6 +14,8 @@ TODO:
 
 #include <gtest/gtest.h>
 
+#include <limits>
+
 using innovusion::geometry::MultiplePolygon2d;
 using innovusion::geometry::Polygon2d;
 using innovusion::geometry::PolygonType;
@@ -191,4 +193,240 @@ TEST_F(MPolygonTest, isUseless_point) {
   Vec2d point = {-15.0, -7.0};
   bool result = roi.isUseful(point);
   EXPECT_TRUE(result);
-}
\ No newline at end of file
+}
+// should keep dense storage consistent when replacing and removing polygons
+TEST_F(MPolygonTest, dense_storage) {
+  MultiplePolygon2d multiplePolygon;
+  EXPECT_TRUE(multiplePolygon.add(7, drawRect({0.0, 0.0}, 10.0, 10.0), {}));
+  EXPECT_TRUE(multiplePolygon.add(3, drawRect({20.0, 0.0}, 10.0, 10.0), {}));
+  EXPECT_TRUE(multiplePolygon.add(5, drawRect({40.0, 0.0}, 10.0, 10.0), {}));
+  EXPECT_EQ(multiplePolygon.size(), 3);
+  // replace in place is allowed to overlap its previous shape
+  EXPECT_TRUE(multiplePolygon.add(3, drawRect({20.0, 0.0}, 12.0, 10.0), {}));
+  EXPECT_FALSE(multiplePolygon.add(9, drawRect({30.0, 0.0}, 10.0, 10.0), {}));
+
+  EXPECT_TRUE(multiplePolygon.remove(7));
+  EXPECT_EQ(multiplePolygon.size(), 2);
+  EXPECT_FALSE(multiplePolygon.within({0.0, 0.0}));
+  EXPECT_TRUE(multiplePolygon.within({40.0, 0.0}));
+  EXPECT_TRUE(multiplePolygon.within({25.5, 0.0}));
+
+  innovusion::geometry::SlotHandle handle;
+  EXPECT_TRUE(multiplePolygon.find(5, &handle));
+  EXPECT_FALSE(multiplePolygon.find(7, &handle));
+  for (size_t i = 0; i < multiplePolygon.size(); ++i) {
+    const auto outer = multiplePolygon.outerAt(i);
+    EXPECT_EQ(outer.size(), 5);
+    EXPECT_NEAR(multiplePolygon.areaAt(i), multiplePolygon.polygonAt(i).area(),
+                1e-9);
+    EXPECT_TRUE(
+        boost::geometry::covered_by(outer[0], multiplePolygon.envelopeAt(i)));
+  }
+}
+
+// should answer within / covered from the vertex pool like boost does
+TEST_F(MPolygonTest, within_vertex_pool) {
+  MultiplePolygon2d multiplePolygon;
+  EXPECT_TRUE(multiplePolygon.add(0, drawCircle({0.0, 0.0}, 20.0, 100),
+                                  {drawCircle({5.0, 5.0}, 5.0, 50)}));
+  EXPECT_TRUE(multiplePolygon.add(1, drawRect({40.0, 0.0}, 10.0, 10.0), {}));
+  EXPECT_TRUE(multiplePolygon.add(
+      2, {{30.0, 20.0}, {40.0, 40.0}, {35.0, 25.0}, {50.0, 20.0}}, {}));
+  for (double y = -25.0; y <= 55.0; y += 0.5) {
+    for (double z = -25.0; z <= 45.0; z += 0.5) {
+      const Vec2d point(y, z);
+      bool within = false;
+      bool covered = false;
+      for (size_t i = 0; i < multiplePolygon.size(); ++i) {
+        within |= multiplePolygon.polygonAt(i).within(point);
+        covered |= multiplePolygon.polygonAt(i).covered(point);
+      }
+      EXPECT_EQ(multiplePolygon.within(point), within) << y << " " << z;
+      EXPECT_EQ(multiplePolygon.covered(point), covered) << y << " " << z;
+    }
+  }
+}
+
+// should answer isUseful against the dissolved union of adjacent ROI patches
+TEST_F(MPolygonTest, isUseful_compiled) {
+  Roi2d roi = Roi2d(true, 50, true);
+  Roi2d plain = Roi2d(true, 50);
+  // 4 x 4 patches of 10 x 10 covering [-20, 20] x [-20, 20]
+  size_t index = 0;
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      Vec2d center(-15.0 + 10.0 * i, -15.0 + 10.0 * j);
+      EXPECT_TRUE(roi.add(index, drawRect(center, 10.0, 10.0), {}));
+      EXPECT_TRUE(plain.add(index, drawRect(center, 10.0, 10.0), {}));
+      ++index;
+    }
+  }
+  EXPECT_EQ(roi.compiledUnion().size(), 1);
+  EXPECT_NEAR(boost::geometry::area(roi.compiledUnion()), 1600.0, 1e-6);
+
+  auto inside = std::make_shared<Polygon2d>(
+      PolygonType::Polygon, drawRect({3.0, 3.0}, 6.0, 6.0),
+      std::vector<std::vector<Vec2d>>{});
+  auto border = std::make_shared<Polygon2d>(
+      PolygonType::Polygon, drawRect({20.0, 0.0}, 6.0, 6.0),
+      std::vector<std::vector<Vec2d>>{});
+  auto outside = std::make_shared<Polygon2d>(
+      PolygonType::Polygon, drawRect({50.0, 0.0}, 6.0, 6.0),
+      std::vector<std::vector<Vec2d>>{});
+  EXPECT_NEAR(roi.coverage(inside), 100.0, 1e-6);
+  EXPECT_NEAR(roi.coverage(border), 50.0, 1e-6);
+  EXPECT_NEAR(roi.coverage(outside), 0.0, 1e-6);
+  EXPECT_EQ(roi.isUseful(inside), plain.isUseful(inside));
+  EXPECT_FALSE(roi.isUseful(border));
+  EXPECT_FALSE(roi.isUseful(outside));
+
+  // union is rebuilt after remove
+  EXPECT_TRUE(roi.remove(5));
+  EXPECT_NEAR(boost::geometry::area(roi.compiledUnion()), 1500.0, 1e-6);
+}
+
+// should copy and move ROI polygons, settings and compiled union
+TEST_F(MPolygonTest, copy_and_move) {
+  Roi2d roi = Roi2d(false, 30, true);
+  EXPECT_TRUE(roi.add(0, drawRect({0.0, 0.0}, 10.0, 10.0), {}));
+  EXPECT_TRUE(roi.add(1, drawRect({10.0, 0.0}, 10.0, 10.0), {}));
+  EXPECT_NEAR(boost::geometry::area(roi.compiledUnion()), 200.0, 1e-6);
+
+  Roi2d copied(roi);
+  EXPECT_TRUE(copied.remove(1));
+  EXPECT_EQ(roi.size(), 2);
+  EXPECT_EQ(copied.size(), 1);
+  EXPECT_FALSE(copied.interested());
+  EXPECT_EQ(copied.rate(), 30);
+  EXPECT_TRUE(copied.compiled());
+  EXPECT_NEAR(boost::geometry::area(copied.compiledUnion()), 100.0, 1e-6);
+  EXPECT_TRUE(copied.isUseful(Vec2d(10.0, 0.0)));
+  EXPECT_FALSE(roi.isUseful(Vec2d(10.0, 0.0)));
+
+  Roi2d moved(std::move(roi));
+  EXPECT_EQ(moved.size(), 2);
+  EXPECT_NEAR(boost::geometry::area(moved.compiledUnion()), 200.0, 1e-6);
+  copied = moved;
+  EXPECT_EQ(copied.size(), 2);
+  EXPECT_TRUE(copied.add(2, drawRect({20.0, 0.0}, 10.0, 10.0), {}));
+  EXPECT_NEAR(boost::geometry::area(copied.compiledUnion()), 300.0, 1e-6);
+  EXPECT_NEAR(boost::geometry::area(moved.compiledUnion()), 200.0, 1e-6);
+}
+
+// should decide iouTargetAtLeast exactly like comparing iouTarget
+TEST_F(MPolygonTest, iouTargetAtLeast) {
+  MultiplePolygon2d multiplePolygon;
+  for (size_t i = 0; i < 4; ++i) {
+    EXPECT_TRUE(multiplePolygon.add(
+        i, drawRect({10.0 * static_cast<double>(i), 0.0}, 10.0, 10.0), {}));
+  }
+  // overlaps 4 patches: 1/6 + 1/3 + 1/3 + 1/6
+  auto target = std::make_shared<Polygon2d>(
+      PolygonType::Polygon, drawRect({15.0, 0.0}, 30.0, 10.0),
+      std::vector<std::vector<Vec2d>>{});
+  const int exact = multiplePolygon.iouTarget(target);
+  EXPECT_EQ(exact, 100);
+  for (int percent : {-1, 0, 1, 17, 50, 99, 100, 101, 150}) {
+    EXPECT_EQ(multiplePolygon.iouTargetAtLeast(target, percent),
+              exact >= percent);
+  }
+  auto far = std::make_shared<Polygon2d>(
+      PolygonType::Polygon, drawRect({100.0, 0.0}, 5.0, 5.0),
+      std::vector<std::vector<Vec2d>>{});
+  EXPECT_FALSE(multiplePolygon.iouTargetAtLeast(far, 1));
+}
+
+// should return the k nearest polygons of a linear bg::distance scan
+TEST_F(MPolygonTest, nearest) {
+  MultiplePolygon2d multiplePolygon;
+  for (size_t i = 0; i < 10; ++i) {
+    for (size_t j = 0; j < 10; ++j) {
+      const Vec2d center(20.0 * static_cast<double>(i),
+                         20.0 * static_cast<double>(j) + (i % 3));
+      EXPECT_TRUE(multiplePolygon.add(
+          i * 10 + j,
+          (i + j) % 2 ? drawCircle(center, 4.0, 12) : drawRect(center, 6, 3),
+          {}));
+    }
+  }
+  std::vector<innovusion::geometry::NearestPolygon> found;
+  for (const Vec2d& point : {Vec2d(33.0, 47.0), Vec2d(-50.0, 90.0),
+                             Vec2d(100.0, 101.0), Vec2d(500.0, 500.0)}) {
+    std::vector<std::pair<double, size_t>> expected;
+    for (size_t i = 0; i < multiplePolygon.size(); ++i) {
+      expected.emplace_back(
+          boost::geometry::distance(
+              point, multiplePolygon.polygonAt(i).getPolygon()),
+          multiplePolygon.indexAt(i));
+    }
+    std::sort(expected.begin(), expected.end());
+    multiplePolygon.nearest(point, 5, 1e9, &found);
+    ASSERT_EQ(found.size(), 5);
+    for (size_t k = 0; k < found.size(); ++k) {
+      EXPECT_NEAR(found[k].distance, expected[k].first, 1e-9);
+      EXPECT_EQ(multiplePolygon.indexAt(found[k].dense), found[k].index);
+    }
+    // cutoff
+    multiplePolygon.nearest(point, 5, expected[1].first, &found);
+    EXPECT_LE(found.size(), 2);
+    for (const auto& item : found) {
+      EXPECT_LE(item.distance, expected[1].first);
+    }
+  }
+
+  innovusion::geometry::NearestPolygon nearest;
+  ASSERT_TRUE(multiplePolygon.nearest(Vec2d(40.0, 42.0), 1.0, &nearest));
+  EXPECT_EQ(nearest.index, 22);
+  EXPECT_EQ(nearest.distance, 0.0);
+  EXPECT_FALSE(multiplePolygon.nearest(Vec2d(40.0, 50.0), 1.0, &nearest));
+
+  auto box = std::make_shared<Polygon2d>(PolygonType::Box, Vec2d(50, 60), 4,
+                                         2, 9000);
+  ASSERT_TRUE(multiplePolygon.nearest(box, 100.0, &nearest));
+  // 12 sided circle of radius 4 around (40, 62)
+  EXPECT_EQ(nearest.index, 23);
+  const double exact = boost::geometry::distance(
+      box->getPolygon(), multiplePolygon.polygonAt(nearest.dense).getPolygon());
+  EXPECT_NEAR(nearest.distance, exact, 1e-12);
+  EXPECT_GT(nearest.distance, 4.0);
+  multiplePolygon.nearest(box, 0, 100.0, &found);
+  EXPECT_TRUE(found.empty());
+
+  // the envelope index follows add / remove
+  EXPECT_TRUE(multiplePolygon.remove(22));
+  ASSERT_TRUE(multiplePolygon.nearest(Vec2d(40.0, 42.0), 100.0, &nearest));
+  EXPECT_NE(nearest.index, 22);
+  EXPECT_GT(nearest.distance, 0.0);
+}
+
+// should refine signed distances from the distance field
+TEST_F(MPolygonTest, signedDistance) {
+  MultiplePolygon2d multiplePolygon;
+  EXPECT_EQ(multiplePolygon.signedDistance({0, 0}),
+            std::numeric_limits<double>::max());
+  EXPECT_TRUE(multiplePolygon.add(0, drawCircle({0, 0}, 5, 32), {}));
+  EXPECT_TRUE(multiplePolygon.add(1, drawRect({20, 0}, 10, 4), {}));
+  multiplePolygon.enableDistanceField(0.2, 0.5);
+  for (double y = -10; y <= 30; y += 0.37) {
+    for (double z = -10; z <= 10; z += 0.41) {
+      const Vec2d point(y, z);
+      const double exact = multiplePolygon.exactSignedDistance(point);
+      const double sampled = multiplePolygon.signedDistance(point);
+      if (std::abs(exact) < 0.2) {
+        // refined near the boundary
+        EXPECT_DOUBLE_EQ(sampled, exact);
+      } else {
+        EXPECT_NEAR(sampled, exact, 0.3);
+        EXPECT_EQ(sampled > 0, exact > 0);
+      }
+    }
+  }
+  // the field follows add / remove
+  EXPECT_LT(multiplePolygon.signedDistance({40, 0}), 16);
+  EXPECT_TRUE(multiplePolygon.add(2, drawRect({40, 0}, 4, 4), {}));
+  EXPECT_NEAR(multiplePolygon.signedDistance({40, 0}), -2.0, 0.3);
+  EXPECT_TRUE(multiplePolygon.remove(2));
+  EXPECT_NEAR(multiplePolygon.signedDistance({40, 0}), 15.0, 0.3);
+  multiplePolygon.enableDistanceField(0, 0);
+  EXPECT_DOUBLE_EQ(multiplePolygon.signedDistance({40, 0}), 15.0);
+}
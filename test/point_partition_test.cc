@@ -0,0 +1,100 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-01
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/test/point_partition_test.cc
+ */
+#include "point_partition.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <random>
+
+#include "region2d.h"
+#include "test_shapes.h"
+
+using innovusion::geometry::MultiplePolygon2d;
+using innovusion::geometry::PointPartition;
+using innovusion::geometry::Polygon2d;
+using innovusion::geometry::PolygonPtr;
+using innovusion::geometry::PolygonType;
+using innovusion::geometry::RegionStore;
+using innovusion::geometry::test::rect;
+using innovusion::geometry::Vec2d;
+
+namespace {
+std::vector<Vec2d> cloud(size_t size) {
+  std::mt19937 generator(3);
+  std::uniform_real_distribution<double> coordinate(-50, 50);
+  std::vector<Vec2d> points(size);
+  for (auto& point : points) {
+    point = Vec2d(coordinate(generator), coordinate(generator));
+  }
+  return points;
+}
+}  // namespace
+
+// should match per point within in the CSR output, serial and parallel
+TEST(PointPartitionTest, against_within) {
+  MultiplePolygon2d polygons;
+  ASSERT_TRUE(polygons.add(7, rect(-20, 5, 20, 40), {rect(-5, 10, 5, 20)}));
+  ASSERT_TRUE(polygons.add(3, rect(-30, -40, -10, -10), {}));
+  ASSERT_TRUE(polygons.add(9, {{10, -5}, {25, -30}, {30, -5}}, {}));
+  const std::vector<Vec2d> points = cloud(50000);
+
+  PointPartition serial(false);
+  serial.bind(polygons);
+  ASSERT_EQ(serial.regionCount(), 3u);
+  serial.partition(points);
+  for (size_t region = 0; region < polygons.size(); ++region) {
+    std::vector<uint32_t> expected{};
+    for (size_t i = 0; i < points.size(); ++i) {
+      if (polygons.polygonAt(region).within(points[i])) {
+        expected.emplace_back(static_cast<uint32_t>(i));
+      }
+    }
+    const auto found = serial.pointsOf(region);
+    EXPECT_FALSE(expected.empty());
+    EXPECT_EQ(std::vector<uint32_t>(found.begin(), found.end()), expected);
+  }
+
+  PointPartition parallel;
+  parallel.bind(polygons);
+  parallel.partition(points);
+  EXPECT_EQ(parallel.offsets(), serial.offsets());
+  EXPECT_EQ(parallel.indices(), serial.indices());
+
+  std::vector<uint32_t> counts{};
+  parallel.count(points, &counts);
+  ASSERT_EQ(counts.size(), 3u);
+  for (size_t region = 0; region < counts.size(); ++region) {
+    EXPECT_EQ(counts[region], serial.pointsOf(region).size());
+  }
+
+  parallel.partition(std::span<const Vec2d>());
+  EXPECT_TRUE(parallel.indices().empty());
+  EXPECT_EQ(parallel.offsets().size(), 4u);
+}
+
+// should partition region stores and overlapping regions
+TEST(PointPartitionTest, regions) {
+  RegionStore store;
+  ASSERT_TRUE(store.add(1, rect(0, 0, 10, 10), {}, {1}, {10}));
+  ASSERT_TRUE(store.add(2, rect(10, 0, 20, 10), {}, {2}, {20}));
+  PointPartition partition;
+  partition.bind(store);
+  const std::vector<Vec2d> points{{5, 5}, {15, 5}, {10, 5}, {-1, 5}, {6, 6}};
+  partition.partition(points);
+  EXPECT_EQ(partition.indices(), (std::vector<uint32_t>{0, 4, 1}));
+  EXPECT_EQ(partition.offsets(), (std::vector<uint32_t>{0, 2, 3}));
+
+  std::vector<PolygonPtr> overlapping{
+      std::make_shared<Polygon2d>(PolygonType::Polygon, rect(0, 0, 10, 10),
+                                  std::vector<std::vector<Vec2d>>{}),
+      std::make_shared<Polygon2d>(PolygonType::Polygon, rect(4, 4, 8, 8),
+                                  std::vector<std::vector<Vec2d>>{})};
+  partition.bind(overlapping);
+  partition.partition(points);
+  EXPECT_EQ(partition.indices(), (std::vector<uint32_t>{0, 4, 0, 4}));
+}
@@ -0,0 +1,131 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-03
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/test/point_view_test.cc
+ */
+#include "point_view.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <random>
+
+#include "point_partition.h"
+#include "prism_set.h"
+#include "scan_classifier.h"
+#include "test_shapes.h"
+
+using innovusion::geometry::MultiplePolygon2d;
+using innovusion::geometry::PointFieldType;
+using innovusion::geometry::PointPartition;
+using innovusion::geometry::PointView;
+using innovusion::geometry::PrismSet;
+using innovusion::geometry::ScanClassifier;
+using innovusion::geometry::test::rect;
+using innovusion::geometry::Vec2d;
+
+namespace {
+#pragma pack(push, 1)
+// driver layout, packed so ring misaligns the timestamp of the next point
+struct LidarPoint {
+  float x;
+  float y;
+  float z;
+  float intensity;
+  uint16_t ring;
+  double timestamp;
+};
+#pragma pack(pop)
+
+struct DoublePoint {
+  double x;
+  double y;
+  double z;
+};
+
+std::vector<LidarPoint> cloud(size_t size) {
+  std::mt19937 generator(9);
+  std::uniform_real_distribution<float> coordinate(-30, 30);
+  std::vector<LidarPoint> points(size);
+  for (size_t i = 0; i < size; ++i) {
+    points[i] = {coordinate(generator), coordinate(generator),
+                 coordinate(generator), 1.0f, uint16_t(i % 64), 0.1 * i};
+  }
+  return points;
+}
+
+PointView viewOf(const std::vector<LidarPoint>& points) {
+  return PointView(points.data(), points.size(), sizeof(LidarPoint),
+                   offsetof(LidarPoint, y), offsetof(LidarPoint, z),
+                   PointFieldType::Float32, offsetof(LidarPoint, x));
+}
+
+std::vector<Vec2d> copyOf(const std::vector<LidarPoint>& points) {
+  std::vector<Vec2d> copy{};
+  for (const auto& point : points) {
+    copy.emplace_back(point.y, point.z);
+  }
+  return copy;
+}
+}  // namespace
+
+// should access fields of float and double layouts
+TEST(PointViewTest, fields) {
+  const std::vector<LidarPoint> points = cloud(10);
+  const PointView view = viewOf(points);
+  ASSERT_EQ(view.size(), 10u);
+  EXPECT_TRUE(view.hasX());
+  for (size_t i = 0; i < points.size(); ++i) {
+    EXPECT_TRUE(view[i] == Vec2d(points[i].y, points[i].z));
+    EXPECT_FLOAT_EQ(view.x(i), points[i].x);
+  }
+
+  const std::vector<DoublePoint> doubles{{1, 2, 3}, {4, 5, 6}};
+  const PointView view64(doubles.data(), doubles.size(), sizeof(DoublePoint),
+                         offsetof(DoublePoint, y), offsetof(DoublePoint, z),
+                         PointFieldType::Float64);
+  EXPECT_FALSE(view64.hasX());
+  EXPECT_TRUE(view64[1] == Vec2d(5, 6));
+  EXPECT_TRUE(PointView().empty());
+}
+
+// should answer every batch point query the same through a view
+TEST(PointViewTest, batch_queries) {
+  const std::vector<LidarPoint> points = cloud(20000);
+  const PointView view = viewOf(points);
+  const std::vector<Vec2d> copy = copyOf(points);
+
+  MultiplePolygon2d polygons;
+  ASSERT_TRUE(polygons.add(0, rect(-20, 5, 20, 25), {rect(-5, 10, 5, 20)}));
+  ASSERT_TRUE(polygons.add(1, rect(-25, -25, -10, -10), {}));
+
+  ScanClassifier classifier(&polygons);
+  std::vector<uint8_t> expected{}, result{};
+  classifier.within(copy, &expected);
+  classifier.reset();
+  classifier.within(view, &result);
+  EXPECT_EQ(result, expected);
+
+  PointPartition partition;
+  partition.bind(polygons);
+  partition.partition(copy);
+  const std::vector<uint32_t> indices = partition.indices();
+  partition.partition(view);
+  EXPECT_EQ(partition.indices(), indices);
+  std::vector<uint32_t> counts{};
+  partition.count(view, &counts);
+  EXPECT_EQ(counts[0] + counts[1], indices.size());
+
+  PrismSet prisms;
+  ASSERT_TRUE(prisms.add(0, rect(-20, 5, 20, 25), {}, {-5.0, 5.0}));
+  ASSERT_TRUE(prisms.within(view, &result));
+  size_t inside = 0;
+  for (size_t i = 0; i < points.size(); ++i) {
+    ASSERT_EQ(result[i] != 0, prisms.within(points[i].x, copy[i])) << i;
+    inside += result[i];
+  }
+  EXPECT_GT(inside, 0u);
+  const PointView flat(copy.data(), copy.size(), sizeof(Vec2d), 0, 0);
+  EXPECT_FALSE(prisms.within(flat, &result));
+}
@@ -0,0 +1,151 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-30
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/test/polar_roi_test.cc
+ */
+#include "polar_roi.h"
+
+#include <gtest/gtest.h>
+
+#include <Eigen/Geometry>
+#include <random>
+
+#include "test_shapes.h"
+
+using innovusion::geometry::PolarRoiTable;
+using innovusion::geometry::RigidTransform2d;
+using innovusion::geometry::Roi2d;
+using innovusion::geometry::test::rect;
+using innovusion::geometry::Vec2d;
+
+namespace {
+// ROI vertices moved the way RegionMonitor::rotat_trans does
+std::vector<Vec2d> transformed(const RigidTransform2d& transform,
+                               const std::vector<Vec2d>& points) {
+  std::vector<Vec2d> result;
+  for (const auto& point : points) {
+    result.emplace_back(transform.apply(point));
+  }
+  return result;
+}
+}  // namespace
+
+// should follow the RegionMonitor matrix convention
+TEST(PolarRoiTest, rigid_transform) {
+  RigidTransform2d identity;
+  EXPECT_TRUE(identity.isIdentity());
+
+  // rotation of 30 degree around x, translation (0, 2, -1)
+  Eigen::Matrix4f matrix = Eigen::Matrix4f::Identity();
+  matrix.block<3, 3>(0, 0) =
+      Eigen::AngleAxisf(M_PI / 6, Eigen::Vector3f::UnitX()).toRotationMatrix();
+  matrix(1, 3) = 2;
+  matrix(2, 3) = -1;
+  RigidTransform2d transform;
+  ASSERT_TRUE(RigidTransform2d::fromMatrix(matrix, 1e-3, &transform));
+  EXPECT_FALSE(transform.isIdentity());
+  const Vec2d point(3, 4);
+  const Vec2d moved = transform.apply(point);
+  EXPECT_NEAR((moved - Vec2d(0, 0)).norm(), (point - Vec2d(2, -1)).norm(),
+              1e-5);
+  EXPECT_TRUE(transform.inverse(moved) == point);
+
+  matrix(0, 0) = 2;
+  EXPECT_FALSE(RigidTransform2d::fromMatrix(matrix, 1e-3, &transform));
+}
+
+// should invert mountings with yaw and pitch, whose (y, z) block is not
+// orthonormal
+TEST(PolarRoiTest, transform_inverse) {
+  Eigen::Matrix4f matrix_wuyue;
+  matrix_wuyue << 0.999938916, 0.00997443964, -0.00476180276, 0.0336134475,
+      0.00972163248, -0.998679324, -0.0504489598, 14.5929322, -0.00525871406,
+      0.0503995856, -0.998715289, 61.2275867, 0.0, 0.0, 0.0, 1.0;
+  Eigen::Matrix4f yaw = Eigen::Matrix4f::Identity();
+  yaw.block<3, 3>(0, 0) =
+      Eigen::AngleAxisf(0.5, Eigen::Vector3f::UnitZ()).toRotationMatrix();
+  Eigen::Matrix4f pitch = Eigen::Matrix4f::Identity();
+  pitch.block<3, 3>(0, 0) =
+      (Eigen::AngleAxisf(0.4, Eigen::Vector3f::UnitY()) *
+       Eigen::AngleAxisf(M_PI / 6, Eigen::Vector3f::UnitX()))
+          .toRotationMatrix();
+  pitch(1, 3) = -3;
+  for (const auto& matrix : {matrix_wuyue, yaw, pitch}) {
+    RigidTransform2d transform;
+    ASSERT_TRUE(RigidTransform2d::fromMatrix(matrix, 1e-3, &transform));
+    for (const auto& point : {Vec2d(0, 0), Vec2d(3, 4), Vec2d(-25, 60)}) {
+      const Vec2d back = transform.inverse(transform.apply(point));
+      EXPECT_NEAR(back.y, point.y, 1e-4);
+      EXPECT_NEAR(back.z, point.z, 1e-4);
+      const Vec2d direction =
+          transform.inverseRotate(transform.rotate(point));
+      EXPECT_NEAR(direction.y, point.y, 1e-4);
+      EXPECT_NEAR(direction.z, point.z, 1e-4);
+    }
+  }
+  // the pure yaw scales y by cos, the transpose would not undo it
+  RigidTransform2d transform;
+  ASSERT_TRUE(RigidTransform2d::fromMatrix(yaw, 1e-3, &transform));
+  EXPECT_NEAR(transform.apply(Vec2d(2, 1)).y, 2 * std::cos(0.5), 1e-5);
+
+  // a yaw of 90 degree flattens y, no inverse
+  yaw.block<3, 3>(0, 0) =
+      Eigen::AngleAxisf(M_PI / 2, Eigen::Vector3f::UnitZ()).toRotationMatrix();
+  EXPECT_FALSE(RigidTransform2d::fromMatrix(yaw, 1e-3, &transform));
+}
+
+// should move a translated square in the transform direction
+TEST(PolarRoiTest, transform_direction) {
+  Roi2d roi;
+  ASSERT_TRUE(roi.add(0, rect(0, 0, 2, 2), {}));
+  const RigidTransform2d transform({1, 0}, {0, 1}, {5, 0});
+  PolarRoiTable table;
+  ASSERT_TRUE(table.build(roi, transform, Vec2d(0, 0), 3600));
+  // the ROI lies at [-5, -3] x [0, 2] in sensor frame
+  EXPECT_TRUE(table.isUseful(Vec2d(-4, 1)));
+  EXPECT_FALSE(table.isUseful(Vec2d(6, 1)));
+}
+
+// should agree with a Roi2d of the sensor frame ROI vertices
+TEST(PolarRoiTest, against_roi) {
+  for (bool interested : {true, false}) {
+    const RigidTransform2d transform({0.8, 0.6}, {-0.6, 0.8}, {-3, -12});
+    Roi2d roi(interested);
+    Roi2d sensor_roi(interested);
+    ASSERT_TRUE(roi.add(0, rect(-20, 5, 20, 40), {rect(-5, 10, 5, 20)}));
+    ASSERT_TRUE(roi.add(1, rect(-30, -40, -10, -10), {}));
+    ASSERT_TRUE(sensor_roi.add(0, transformed(transform, rect(-20, 5, 20, 40)),
+                               {transformed(transform, rect(-5, 10, 5, 20))}));
+    ASSERT_TRUE(sensor_roi.add(
+        1, transformed(transform, rect(-30, -40, -10, -10)), {}));
+    // sensor sits inside polygon 0
+    const Vec2d origin = transform.apply(Vec2d(1, 30));
+    PolarRoiTable table;
+    EXPECT_FALSE(table.isUseful(0.0, 1.0));
+    EXPECT_FALSE(table.build(roi, transform, origin, 0));
+    ASSERT_TRUE(table.build(roi, transform, origin, 7200));
+    ASSERT_EQ(table.bins(), 7200);
+
+    std::mt19937 generator(31);
+    std::uniform_real_distribution<double> position(-60, 60);
+    size_t inside = 0;
+    for (int i = 0; i < 20000; ++i) {
+      const Vec2d point(position(generator), position(generator));
+      const double range = (point - origin).norm();
+      // away from the boundary by more than the bin width
+      if (std::abs(sensor_roi.exactSignedDistance(point)) <=
+          range * 2 * M_PI / table.bins() + 1e-3) {
+        continue;
+      }
+      const bool expected = sensor_roi.isUseful(point);
+      EXPECT_EQ(table.isUseful(point), expected);
+      EXPECT_EQ(table.isUseful(PolarRoiTable::azimuthOf(point - origin) +
+                                   2 * M_PI,
+                               range),
+                expected);
+      inside += sensor_roi.within(point);
+    }
+    EXPECT_GT(inside, 1000);
+  }
+}
@@ -9,13 +9,38 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <new>
+
+#include "multiple_polygon2d.h"
 #include "region2d.h"
+#include "region_store.h"
+
+namespace {
+std::atomic<size_t> allocation_count{0};
+}  // namespace
+
+// count every heap allocation of this test binary
+void* operator new(size_t size) {
+  ++allocation_count;
+  if (void* memory = std::malloc(size)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
 
 using innovusion::geometry::Box2d;
+using innovusion::geometry::MultiplePolygon2d;
 using innovusion::geometry::Polygon2d;
 using innovusion::geometry::PolygonPtr;
 using innovusion::geometry::PolygonType;
 using innovusion::geometry::Region2d;
+using innovusion::geometry::RegionStore;
 using innovusion::geometry::Vec2d;
 
 #define GEOM_EQ(val_1, val_2)        \
@@ -261,3 +286,223 @@ TEST_F(PolygonTest, debugString) {
   std::string output_string = output_stream.str();
   EXPECT_EQ(output_string, expect_string);
 }
+
+// should agree with the exact iou / iouTarget in threshold predicates
+TEST_F(PolygonTest, threshold_predicates) {
+  std::vector<Vec2d> outerPoints1 = {{0, 0}, {10, 0}, {10, 5}, {0, 5}};
+  std::vector<Vec2d> outerPoints2 = {{6, 0}, {12, 0}, {12, 3}, {6, 3}};
+  std::vector<Vec2d> outerPoints3 = {{20, 0}, {30, 0}, {30, 5}, {20, 5}};
+  PolygonPtr polygon1 = std::make_shared<Polygon2d>(
+      PolygonType::Polygon, outerPoints1, std::vector<std::vector<Vec2d>>());
+  PolygonPtr polygon2 = std::make_shared<Polygon2d>(
+      PolygonType::Polygon, outerPoints2, std::vector<std::vector<Vec2d>>());
+  PolygonPtr polygon3 = std::make_shared<Polygon2d>(
+      PolygonType::Polygon, outerPoints3, std::vector<std::vector<Vec2d>>());
+  // iou is 0.21428571
+  EXPECT_TRUE(polygon1->iouAtLeast(polygon2, 0.2));
+  EXPECT_FALSE(polygon1->iouAtLeast(polygon2, 0.3));
+  EXPECT_FALSE(polygon1->iouAtLeast(polygon3, 0.01));
+  EXPECT_TRUE(polygon1->iouAtLeast(polygon3, 0.0));
+  // iouTarget is 67 and 24
+  EXPECT_TRUE(polygon1->iouTargetAtLeast(polygon2, 67));
+  EXPECT_FALSE(polygon1->iouTargetAtLeast(polygon2, 68));
+  EXPECT_TRUE(polygon2->iouTargetAtLeast(polygon1, 24));
+  EXPECT_FALSE(polygon2->iouTargetAtLeast(polygon1, 25));
+  EXPECT_FALSE(polygon1->iouTargetAtLeast(polygon3, 1));
+}
+
+// should move rvalue rings into the polygon, not copy them
+TEST_F(PolygonTest, move_construction) {
+  // closed and correctly oriented, correct() has nothing to append
+  std::vector<Vec2d> outer = {
+      {-100, -100}, {-100, 100}, {100, 100}, {100, -100}, {-100, -100}};
+  std::vector<std::vector<Vec2d>> inners = {
+      {{-10, -10}, {10, -10}, {10, 10}, {-10, 10}, {-10, -10}}};
+  const std::vector<Vec2d> outer_copy = outer;
+  const std::vector<std::vector<Vec2d>> inners_copy = inners;
+  const Vec2d* outer_data = outer.data();
+  const Vec2d* inner_data = inners[0].data();
+
+  size_t before = allocation_count;
+  Polygon2d moved(PolygonType::Region, std::move(outer), std::move(inners));
+  // only the inner ring table is allocated
+  EXPECT_EQ(allocation_count - before, 1);
+  EXPECT_EQ(moved.outer().data(), outer_data);
+  EXPECT_EQ(moved.inners()[0].data(), inner_data);
+  GEOM_EQ(moved.area(), 39600);
+
+  before = allocation_count;
+  Polygon2d borrowed(PolygonType::Region, std::span<const Vec2d>(outer_copy),
+                     std::span<const std::vector<Vec2d>>(inners_copy));
+  // outer ring, inner ring table, inner ring
+  EXPECT_EQ(allocation_count - before, 3);
+  GEOM_EQ(borrowed.area(), 39600);
+
+  before = allocation_count;
+  Polygon2d taken(std::move(moved));
+  EXPECT_EQ(allocation_count - before, 0);
+  EXPECT_EQ(taken.outer().data(), outer_data);
+
+  before = allocation_count;
+  const auto& polygon = taken.getPolygon();
+  EXPECT_EQ(allocation_count - before, 0);
+  EXPECT_EQ(polygon.outer().data(), outer_data);
+}
+
+// should move rvalue rings into regions and containers, the copying
+// container overloads allocating the outer ring, the inner ring table and
+// every inner ring on top
+TEST_F(PolygonTest, move_into_containers) {
+  const std::vector<Vec2d> outer = {
+      {-100, -100}, {-100, 100}, {100, 100}, {100, -100}, {-100, -100}};
+  const std::vector<std::vector<Vec2d>> inners = {
+      {{-10, -10}, {10, -10}, {10, 10}, {-10, 10}, {-10, -10}},
+      {{50, 50}, {60, 50}, {60, 60}, {50, 60}, {50, 50}}};
+  const std::vector<uint32_t> attributes = {1, 2};
+  const std::vector<int32_t> values = {10, 20};
+  const size_t ring_copies = 2 + inners.size();
+
+  {
+    size_t before = allocation_count;
+    Region2d empty(1, std::vector<Vec2d>{}, std::vector<std::vector<Vec2d>>{},
+                   attributes, values);
+    const size_t attribute_cost = allocation_count - before;
+    std::vector<Vec2d> moved_outer = outer;
+    std::vector<std::vector<Vec2d>> moved_inners = inners;
+    const Vec2d* outer_data = moved_outer.data();
+    const Vec2d* inner_data = moved_inners[1].data();
+    before = allocation_count;
+    Region2d moved(1, std::move(moved_outer), std::move(moved_inners),
+                   attributes, values);
+    // only the inner ring table on top of the attributes
+    EXPECT_EQ(allocation_count - before, attribute_cost + 1);
+    Region2d copied(1, outer, inners, attributes, values);
+    EXPECT_EQ(moved.outer().data(), outer_data);
+    EXPECT_EQ(moved.inners()[1].data(), inner_data);
+    GEOM_EQ(moved.area(), copied.area());
+  }
+  {
+    MultiplePolygon2d moved_polygons, copied_polygons;
+    std::vector<Vec2d> moved_outer = outer;
+    std::vector<std::vector<Vec2d>> moved_inners = inners;
+    const Vec2d* outer_data = moved_outer.data();
+    size_t before = allocation_count;
+    ASSERT_TRUE(
+        moved_polygons.add(1, std::move(moved_outer), std::move(moved_inners)));
+    const size_t moving = allocation_count - before;
+    before = allocation_count;
+    ASSERT_TRUE(copied_polygons.add(1, outer, inners));
+    EXPECT_EQ(allocation_count - before, moving + ring_copies);
+    EXPECT_EQ(moved_polygons.polygonAt(0).outer().data(), outer_data);
+  }
+  {
+    RegionStore moved_regions, copied_regions;
+    std::vector<Vec2d> moved_outer = outer;
+    std::vector<std::vector<Vec2d>> moved_inners = inners;
+    const Vec2d* outer_data = moved_outer.data();
+    size_t before = allocation_count;
+    ASSERT_TRUE(moved_regions.add(1, std::move(moved_outer),
+                                  std::move(moved_inners), attributes, values));
+    const size_t moving = allocation_count - before;
+    before = allocation_count;
+    ASSERT_TRUE(copied_regions.add(1, outer, inners, attributes, values));
+    EXPECT_EQ(allocation_count - before, moving + ring_copies);
+    EXPECT_EQ(moved_regions.polygonAt(0).outer().data(), outer_data);
+  }
+}
+
+// should build batch box rings as Box2d does, needing no correction
+TEST_F(PolygonTest, batch_box_corners) {
+  std::vector<Vec2d> centers = {{0, 0}, {10, -5}, {-3, 7}, {1, 1}};
+  std::vector<double> lengths = {4.0, 10.0, 2.5, 1.0};
+  std::vector<double> widths = {2.0, 3.0, 2.5, 0.5};
+  std::vector<uint32_t> spindles = {0, 4500, 35999, 40000};
+  std::vector<Vec2d> rings(centers.size() * innovusion::geometry::kBoxRingSize);
+  ASSERT_TRUE(innovusion::geometry::batchBoxCorners(centers, lengths, widths,
+                                                    spindles, rings));
+  for (size_t i = 0; i < centers.size(); ++i) {
+    Box2d box(centers[i], lengths[i], widths[i], spindles[i]);
+    EXPECT_TRUE(box.isValid());
+    innovusion::geometry::GPolygon corrected = box.getPolygon();
+    boost::geometry::correct(corrected);
+    ASSERT_EQ(corrected.outer().size(), box.outer().size());
+    for (size_t k = 0; k < innovusion::geometry::kBoxRingSize; ++k) {
+      EXPECT_EQ(rings[i * 5 + k].y, box.outer()[k].y);
+      EXPECT_EQ(rings[i * 5 + k].z, box.outer()[k].z);
+      GPOINT_EQ(corrected.outer()[k], box.outer()[k]);
+    }
+  }
+  std::vector<Vec2d> small(3);
+  EXPECT_FALSE(innovusion::geometry::batchBoxCorners(centers, lengths, widths,
+                                                     spindles, small));
+
+  // a negative size is corrected like any ring, a non finite center is
+  // never valid
+  Box2d negative({0, 0}, -4.0, 2.0, 0);
+  EXPECT_TRUE(negative.isValid());
+  EXPECT_NEAR(negative.area(), 8.0, 1e-9);
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  Box2d unknown({nan, 0}, 4.0, 2.0, 0);
+  EXPECT_FALSE(unknown.isValid());
+  // float corners overflow or collapse to one point
+  Box2d huge({0, 0}, 1e39, 2.0, 0);
+  EXPECT_FALSE(huge.isValid());
+  Box2d tiny({0, 0}, 1e-50, 1e-50, 4500);
+  EXPECT_FALSE(tiny.isValid());
+  Box2d far_away({1e12, 0}, 1e-6, 1e-6, 0);
+  EXPECT_FALSE(far_away.isValid());
+}
+
+// should agree with boost on the convex fast path and cache validity
+TEST_F(PolygonTest, cached_validity) {
+  using innovusion::geometry::GRing;
+  using innovusion::geometry::isValidConvexRing;
+  // clockwise square and triangle
+  GRing square{{0, 0}, {0, 10}, {10, 10}, {10, 0}, {0, 0}};
+  GRing triangle{{0, 0}, {5, 10}, {10, 0}, {0, 0}};
+  EXPECT_TRUE(isValidConvexRing(square));
+  EXPECT_TRUE(isValidConvexRing(triangle));
+  EXPECT_TRUE(boost::geometry::is_valid(square));
+  // counter clockwise, open, collinear and duplicated points
+  GRing reversed(square.rbegin(), square.rend());
+  GRing open{{0, 0}, {0, 10}, {10, 10}, {10, 0}};
+  GRing collinear{{0, 0}, {0, 5}, {0, 10}, {10, 10}, {10, 0}, {0, 0}};
+  GRing duplicated{{0, 0}, {0, 10}, {0, 10}, {10, 10}, {10, 0}, {0, 0}};
+  EXPECT_FALSE(isValidConvexRing(reversed));
+  EXPECT_FALSE(isValidConvexRing(open));
+  EXPECT_FALSE(isValidConvexRing(collinear));
+  EXPECT_FALSE(isValidConvexRing(duplicated));
+  // pentagram, every turn is clockwise but the ring winds twice
+  GRing star;
+  for (int i = 0; i <= 5; ++i) {
+    const double angle = -M_PI * 4 * i / 5;
+    star.emplace_back(std::cos(angle), std::sin(angle));
+  }
+  star.back() = star.front();
+  EXPECT_FALSE(isValidConvexRing(star));
+  EXPECT_FALSE(boost::geometry::is_valid(star));
+
+  // non convex but valid goes through boost
+  Polygon2d concave(PolygonType::Region, valley, {});
+  EXPECT_FALSE(isValidConvexRing(concave.outer()));
+  EXPECT_TRUE(concave.isValid());
+  EXPECT_TRUE(concave.isValid());
+
+  // cache follows mutations
+  Polygon2d polygon(PolygonType::Region, rectangle, {});
+  EXPECT_TRUE(polygon.isValid());
+  polygon.setOuter({{0, 0}, {10, 10}, {10, 0}, {0, 10}, {0, 0}});  // bow tie
+  EXPECT_FALSE(polygon.isValid());
+  Polygon2d copied(polygon);
+  EXPECT_FALSE(copied.isValid());
+  polygon.setOuter(std::vector<Vec2d>{{0, 0}, {0, 10}, {10, 10}, {0, 0}});
+  EXPECT_TRUE(polygon.isValid());
+  // clockwise hole
+  polygon.setInners({{{1, 5}, {2, 5}, {1, 4}, {1, 5}}});
+  EXPECT_FALSE(polygon.isValid());
+
+  Box2d box({0, 0}, 10, 5, 1234);
+  EXPECT_TRUE(box.isValid());
+  Box2d flat({0, 0}, 10, 0, 0);
+  EXPECT_FALSE(flat.isValid());
+}
@@ -0,0 +1,97 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-02
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/test/prism_set_test.cc
+ */
+#include "prism_set.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <random>
+
+#include "region2d.h"
+#include "test_shapes.h"
+
+using innovusion::geometry::Box2d;
+using innovusion::geometry::HeightRange;
+using innovusion::geometry::PolygonPtr;
+using innovusion::geometry::PrismSet;
+using innovusion::geometry::test::rect;
+using innovusion::geometry::Vec2d;
+
+// should match per point tests over stacked prisms in the fused xyz pass
+TEST(PrismSetTest, points) {
+  PrismSet prisms;
+  EXPECT_FALSE(prisms.within(0.0, Vec2d(0, 0)));
+  EXPECT_FALSE(prisms.add(1, rect(0, 0, 10, 10), {}, {2.0, 1.0}));
+  // same footprint, two floors
+  ASSERT_TRUE(prisms.add(1, rect(0, 0, 10, 10), {}, {0.0, 3.0}));
+  ASSERT_TRUE(prisms.add(2, rect(0, 0, 10, 10), {}, {5.0, 8.0}));
+  ASSERT_TRUE(prisms.add(3, rect(20, 0, 30, 10), {rect(22, 2, 28, 8)},
+                         {-1.0, 1.0}));
+  EXPECT_DOUBLE_EQ(prisms.height().low, -1.0);
+  EXPECT_DOUBLE_EQ(prisms.height().high, 8.0);
+
+  EXPECT_TRUE(prisms.within(1.0, Vec2d(5, 5)));
+  EXPECT_FALSE(prisms.within(4.0, Vec2d(5, 5)));
+  EXPECT_TRUE(prisms.within(8.0, Vec2d(5, 5)));
+  EXPECT_FALSE(prisms.within(9.0, Vec2d(5, 5)));
+  EXPECT_FALSE(prisms.within(0.0, Vec2d(25, 5)));
+  EXPECT_TRUE(prisms.within(0.0, Vec2d(21, 5)));
+
+  std::mt19937 generator(5);
+  std::uniform_real_distribution<float> plane(-5, 35);
+  std::uniform_real_distribution<float> height(-3, 10);
+  std::vector<float> xyz{};
+  for (int i = 0; i < 20000; ++i) {
+    xyz.insert(xyz.end(), {height(generator), plane(generator),
+                           plane(generator)});
+  }
+  std::vector<uint8_t> result{};
+  prisms.within(xyz, &result);
+  ASSERT_EQ(result.size(), 20000u);
+  size_t inside = 0;
+  for (size_t i = 0; i < result.size(); ++i) {
+    const Vec2d point(xyz[3 * i + 1], xyz[3 * i + 2]);
+    bool expected = false;
+    for (size_t dense = 0; dense < prisms.size(); ++dense) {
+      expected |= prisms.heightAt(dense).contains(xyz[3 * i]) &&
+                  prisms.polygonAt(dense).within(point);
+    }
+    ASSERT_EQ(result[i] != 0, expected) << i;
+    inside += result[i];
+  }
+  EXPECT_GT(inside, 500u);
+
+  ASSERT_TRUE(prisms.remove(1));
+  EXPECT_FALSE(prisms.remove(1));
+  EXPECT_FALSE(prisms.within(1.0, Vec2d(5, 5)));
+  EXPECT_TRUE(prisms.within(6.0, Vec2d(5, 5)));
+  EXPECT_DOUBLE_EQ(prisms.height().low, -1.0);
+}
+
+// should answer box queries with height ranges
+TEST(PrismSetTest, boxes) {
+  PrismSet prisms;
+  ASSERT_TRUE(prisms.add(1, rect(0, 0, 10, 10), {}, {0.0, 3.0}));
+  ASSERT_TRUE(prisms.add(2, rect(0, 0, 10, 10), {}, {5.0, 8.0}));
+  ASSERT_TRUE(prisms.add(3, rect(20, 0, 30, 10), {}, {0.0, 1.0}));
+
+  const PolygonPtr box = std::make_shared<Box2d>(Vec2d(10, 5), 4, 4, 0);
+  std::vector<size_t> indices{};
+  prisms.overlaped(box, {2.0, 6.0}, &indices);
+  EXPECT_EQ(indices, (std::vector<size_t>{1, 2}));
+  prisms.overlaped(box, {3.5, 4.5}, &indices);
+  EXPECT_TRUE(indices.empty());
+
+  const std::vector<PolygonPtr> boxes{
+      box, box, std::make_shared<Box2d>(Vec2d(25, 5), 2, 2, 0),
+      std::make_shared<Box2d>(Vec2d(15, 5), 2, 2, 0)};
+  const std::vector<HeightRange> heights{
+      {-2.0, -1.0}, {7.0, 9.0}, {0.5, 0.6}, {0.0, 8.0}};
+  std::vector<uint8_t> result{};
+  prisms.overlaped(boxes, heights, &result);
+  EXPECT_EQ(result, (std::vector<uint8_t>{0, 1, 1, 0}));
+}
@@ -0,0 +1,101 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-05
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/test/region_config_test.cc
+ */
+#include "region_config.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using innovusion::geometry::RegionConfig;
+using innovusion::geometry::Vec2d;
+
+namespace {
+const char* kConfig = R"(
+rt_matrix:
+  precision: 0.01
+  data: [1, 0, 0, 0,
+         0, 1, 0, 2,
+         0, 0, 1, -3,
+         0, 0, 0, 1]
+roi:
+  interested: false
+  rate: 30
+  compiled: true
+  polygons:
+    - index: 4
+      outer: [[-20, 5], [-20, 40], [20, 40], [20, 5]]
+      inners: [[[-5, 10], [-5, 20], [5, 20], [5, 10]]]
+regions:
+  - index: 1
+    outer: [[0, 0], [0, 10], [10, 10], [10, 0]]
+    attributes: [1, 2]
+    values: [10, -20]
+  - index: 2
+    outer: [[10, 0], [10, 10], [20, 10]]
+)";
+}  // namespace
+
+// should parse every field of the layout
+TEST(RegionConfigTest, parse) {
+  RegionConfig config{};
+  std::string error{};
+  ASSERT_TRUE(RegionConfig::fromYaml(kConfig, &config, &error)) << error;
+  ASSERT_TRUE(config.has_rt_matrix);
+  EXPECT_FLOAT_EQ(config.rt_precision, 0.01f);
+  EXPECT_FLOAT_EQ(config.rt_matrix(1, 3), 2.0f);
+  EXPECT_FLOAT_EQ(config.rt_matrix(2, 3), -3.0f);
+  EXPECT_FALSE(config.roi_interested);
+  EXPECT_EQ(config.roi_rate, 30);
+  EXPECT_TRUE(config.roi_compiled);
+  ASSERT_EQ(config.roi.size(), 1u);
+  EXPECT_EQ(config.roi.at(4).outer.size(), 4u);
+  ASSERT_EQ(config.roi.at(4).inners.size(), 1u);
+  EXPECT_EQ(config.roi.at(4).inners[0][2], Vec2d(5, 20));
+  ASSERT_EQ(config.regions.size(), 2u);
+  EXPECT_EQ(config.regions.at(1).attributes,
+            (std::vector<uint32_t>{1, 2}));
+  EXPECT_EQ(config.regions.at(1).values, (std::vector<int32_t>{10, -20}));
+  EXPECT_TRUE(config.regions.at(2).attributes.empty());
+  EXPECT_EQ(config.regions.at(2).outer[2], Vec2d(20, 10));
+
+  RegionConfig same{};
+  ASSERT_TRUE(RegionConfig::fromYaml(kConfig, &same));
+  EXPECT_TRUE(same == config);
+  same.regions.at(2).outer[2] = Vec2d(20, 11);
+  EXPECT_FALSE(same == config);
+
+  RegionConfig empty{};
+  ASSERT_TRUE(RegionConfig::fromYaml("", &empty));
+  EXPECT_TRUE(empty == RegionConfig());
+}
+
+// should reject layout errors and leave the output untouched
+TEST(RegionConfigTest, errors) {
+  const std::vector<std::string> broken{
+      "regions: [{index: 1, outer: [[0, 0, 1]]}]",
+      "regions: [{index: 1, outer: [[0, 0]], attributes: [1]}]",
+      "regions: [{index: 1, outer: [[0, 0]]}, {index: 1, outer: [[1, 1]]}]",
+      "regions: [{outer: [[0, 0]]}]",
+      "rt_matrix: {data: [1, 0, 0]}",
+      "roi: {rate: fast}",
+      "[1, 2",
+      "- 1",
+  };
+  for (const auto& text : broken) {
+    RegionConfig config{};
+    config.roi_rate = 7;
+    std::string error{};
+    EXPECT_FALSE(RegionConfig::fromYaml(text, &config, &error)) << text;
+    EXPECT_FALSE(error.empty()) << text;
+    EXPECT_EQ(config.roi_rate, 7);
+  }
+  RegionConfig config{};
+  std::string error{};
+  EXPECT_FALSE(RegionConfig::fromFile("/nonexistent/regions.yaml", &config,
+                                      &error));
+  EXPECT_FALSE(error.empty());
+}
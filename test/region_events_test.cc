@@ -0,0 +1,143 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-29
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/test/region_events_test.cc
+ */
+#include "region_events.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+#include <set>
+
+#include "region2d.h"
+
+using innovusion::geometry::Polygon2d;
+using innovusion::geometry::PolygonPtr;
+using innovusion::geometry::PolygonType;
+using innovusion::geometry::RegionEvent;
+using innovusion::geometry::RegionEventEngine;
+using innovusion::geometry::RegionEventType;
+using innovusion::geometry::TrackPosition;
+using innovusion::geometry::Vec2d;
+
+namespace {
+PolygonPtr square(double y, double z, double half) {
+  return std::make_shared<Polygon2d>(
+      PolygonType::Region,
+      std::vector<Vec2d>{{y - half, z - half},
+                         {y - half, z + half},
+                         {y + half, z + half},
+                         {y + half, z - half}},
+      std::vector<std::vector<Vec2d>>{});
+}
+}  // namespace
+
+// should report a single track walking through two overlapping regions
+TEST(RegionEventsTest, walk_through) {
+  RegionEventEngine engine(3);
+  ASSERT_TRUE(engine.addRegion(1, square(0, 0, 5)));
+  ASSERT_TRUE(engine.addRegion(2, square(8, 0, 5)));
+  EXPECT_FALSE(engine.addRegion(3, std::make_shared<Polygon2d>(
+                                       PolygonType::Region,
+                                       std::vector<Vec2d>{{0, 0}, {1, 1}},
+                                       std::vector<std::vector<Vec2d>>{})));
+
+  std::vector<RegionEvent> events;
+  std::vector<TrackPosition> tracks = {{42, {-10, 0}}};
+  engine.update(tracks, &events);
+  EXPECT_TRUE(events.empty());
+
+  std::vector<std::vector<RegionEvent>> history;
+  for (int step = 1; step <= 30; ++step) {
+    tracks[0].position = Vec2d(-10 + step, 0.5);
+    engine.update(tracks, &events);
+    history.emplace_back(events);
+  }
+  // enter 1 at y = -4, enter 2 at y = 4, exit 1 at y = 5, exit 2 at y = 13
+  auto is = [](const RegionEvent& event, RegionEventType type,
+               uint32_t region, uint32_t frames) {
+    return event.type == type && event.track == 42 && event.region == region &&
+           event.frames == frames;
+  };
+  ASSERT_EQ(history[5].size(), 1);
+  EXPECT_TRUE(is(history[5][0], RegionEventType::Enter, 1, 0));
+  ASSERT_EQ(history[8].size(), 1);
+  EXPECT_TRUE(is(history[8][0], RegionEventType::Dwell, 1, 3));
+  ASSERT_EQ(history[13].size(), 1);
+  EXPECT_TRUE(is(history[13][0], RegionEventType::Enter, 2, 0));
+  ASSERT_EQ(history[14].size(), 1);
+  EXPECT_TRUE(is(history[14][0], RegionEventType::Exit, 1, 9));
+  ASSERT_EQ(history[16].size(), 1);
+  EXPECT_TRUE(is(history[16][0], RegionEventType::Dwell, 2, 3));
+  ASSERT_EQ(history[22].size(), 1);
+  EXPECT_TRUE(is(history[22][0], RegionEventType::Exit, 2, 9));
+
+  // removing a region exits its tracks, a missing track exits everything
+  tracks[0].position = Vec2d(0, 0);
+  engine.update(tracks, &events);
+  ASSERT_TRUE(engine.removeRegion(1));
+  engine.update(tracks, &events);
+  ASSERT_EQ(events.size(), 1);
+  EXPECT_EQ(events[0].type, RegionEventType::Exit);
+  EXPECT_EQ(events[0].region, 1);
+  tracks[0].position = Vec2d(8, 0);
+  engine.update(tracks, &events);
+  tracks.clear();
+  engine.update(tracks, &events);
+  ASSERT_EQ(events.size(), 1);
+  EXPECT_EQ(events[0].type, RegionEventType::Exit);
+  EXPECT_EQ(events[0].region, 2);
+  EXPECT_EQ(engine.trackCount(), 0);
+}
+
+// should match brute force memberships and skip far tracks
+TEST(RegionEventsTest, random_walk) {
+  std::map<uint32_t, PolygonPtr> regions;
+  RegionEventEngine engine;
+  std::mt19937 generator(5);
+  std::uniform_real_distribution<double> position(-100, 100);
+  std::normal_distribution<double> step(0.0, 0.2);
+  for (uint32_t i = 0; i < 20; ++i) {
+    regions[i] = square(position(generator), position(generator), 6);
+    ASSERT_TRUE(engine.addRegion(i, regions[i]));
+  }
+  std::vector<TrackPosition> tracks;
+  for (uint32_t i = 0; i < 300; ++i) {
+    tracks.push_back({i, {position(generator), position(generator)}});
+  }
+  std::map<uint32_t, std::set<uint32_t>> expected;
+  std::vector<RegionEvent> events;
+  std::vector<uint32_t> actual;
+  size_t evaluated = 0;
+  for (int frame = 0; frame < 100; ++frame) {
+    for (auto& track : tracks) {
+      track.position += Vec2d(step(generator), step(generator));
+    }
+    engine.update(tracks, &events);
+    evaluated += engine.evaluated();
+    for (const auto& event : events) {
+      if (event.type == RegionEventType::Enter) {
+        EXPECT_TRUE(expected[event.track].insert(event.region).second);
+      } else if (event.type == RegionEventType::Exit) {
+        EXPECT_EQ(expected[event.track].erase(event.region), 1);
+      }
+    }
+    for (const auto& [track, point] : tracks) {
+      std::vector<uint32_t> truth;
+      for (const auto& [id, region] : regions) {
+        if (region->within(point)) {
+          truth.emplace_back(id);
+        }
+      }
+      engine.regionsOf(track, &actual);
+      EXPECT_EQ(actual, truth);
+      EXPECT_EQ(std::vector<uint32_t>(expected[track].begin(),
+                                      expected[track].end()),
+                truth);
+    }
+  }
+  EXPECT_LT(evaluated, tracks.size() * 100 / 2);
+}
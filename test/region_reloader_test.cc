@@ -0,0 +1,172 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-05
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/test/region_reloader_test.cc
+ */
+#include "region_reloader.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <thread>
+
+#include "region2d.h"
+#include "test_shapes.h"
+
+using innovusion::geometry::Box2d;
+using innovusion::geometry::PolygonPtr;
+using innovusion::geometry::RegionConfig;
+using innovusion::geometry::RegionConfigPolygon;
+using innovusion::geometry::RegionReloader;
+using innovusion::geometry::RegionState;
+using innovusion::geometry::test::rect;
+using innovusion::geometry::Vec2d;
+
+namespace {
+RegionConfig baseConfig() {
+  RegionConfig config{};
+  config.regions[1] = {rect(0, 0, 10, 10), {}, {1}, {10}};
+  config.regions[2] = {rect(10, 0, 20, 10), {}, {2}, {20}};
+  config.roi[0] = {rect(-20, -20, 20, 20), {rect(-5, -5, 5, 5)}, {}, {}};
+  return config;
+}
+
+std::vector<uint32_t> attributesAround(const RegionReloader& reloader,
+                                       const Vec2d& center) {
+  const PolygonPtr box = std::make_shared<Box2d>(center, 2, 2, 0);
+  std::vector<uint32_t> attributes{};
+  std::vector<int32_t> values, ious;
+  reloader.findRelatedMessage(box, &attributes, &values, &ious, nullptr);
+  return attributes;
+}
+
+// replaced by rename, readers never see a partial file
+void writeFile(const std::string& path, const std::string& text) {
+  const std::string temporary = path + ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::trunc);
+    file << text;
+  }
+  std::rename(temporary.c_str(), path.c_str());
+}
+}  // namespace
+
+// should rebuild only the changed containers
+TEST(RegionReloaderTest, apply) {
+  RegionReloader reloader("unused.yaml");
+  EXPECT_EQ(reloader.state()->generation(), 0u);
+  EXPECT_TRUE(attributesAround(reloader, {5, 5}).empty());
+
+  RegionConfig config = baseConfig();
+  ASSERT_TRUE(reloader.apply(config));
+  const auto first = reloader.state();
+  EXPECT_EQ(first->generation(), 1u);
+  EXPECT_EQ(first->regions()->size(), 2u);
+  EXPECT_EQ(attributesAround(reloader, {5, 5}),
+            (std::vector<uint32_t>{1}));
+  EXPECT_TRUE(reloader.isUseful(Vec2d(10, 10)));
+  EXPECT_FALSE(reloader.isUseful(Vec2d(0, 0)));
+
+  ASSERT_TRUE(reloader.apply(config));
+  EXPECT_EQ(reloader.state(), first);
+
+  config.regions[2].values = {25};
+  config.regions.erase(1);
+  config.regions[3] = {rect(0, 0, 10, 10), {}, {3}, {30}};
+  ASSERT_TRUE(reloader.apply(config));
+  const auto second = reloader.state();
+  EXPECT_EQ(second->generation(), 2u);
+  EXPECT_EQ(second->roi(), first->roi());
+  EXPECT_NE(second->regions(), first->regions());
+  EXPECT_EQ(attributesAround(reloader, {5, 5}),
+            (std::vector<uint32_t>{3}));
+  size_t dense = 0;
+  ASSERT_TRUE(second->regions()->find(2, &dense));
+  EXPECT_EQ(second->regions()->valuesAt(dense)[0], 25);
+  // the replaced state still answers
+  EXPECT_EQ(first->regions()->size(), 2u);
+
+  config.roi_interested = false;
+  ASSERT_TRUE(reloader.apply(config));
+  EXPECT_EQ(reloader.state()->regions(), second->regions());
+  EXPECT_FALSE(reloader.isUseful(Vec2d(10, 10)));
+
+  // the union is dissolved before the state is published
+  config.roi_compiled = true;
+  ASSERT_TRUE(reloader.apply(config));
+  EXPECT_EQ(reloader.state()->roi()->compiledUnion().size(), 1u);
+
+  // bow tie, the whole reload is rejected
+  config.regions[4] = {{{0, 0}, {10, 10}, {10, 0}, {0, 10}}, {}, {4}, {40}};
+  config.regions.erase(2);
+  EXPECT_FALSE(reloader.apply(config));
+  EXPECT_FALSE(reloader.error().empty());
+  EXPECT_EQ(reloader.state()->generation(), 4u);
+  EXPECT_EQ(reloader.state()->regions()->size(), 2u);
+}
+
+// should move every polygon by the RT matrix
+TEST(RegionReloaderTest, rt_matrix) {
+  RegionReloader reloader("unused.yaml");
+  RegionConfig config = baseConfig();
+  ASSERT_TRUE(reloader.apply(config));
+  config.has_rt_matrix = true;
+  config.rt_matrix(1, 3) = 100;
+  ASSERT_TRUE(reloader.apply(config));
+  // region frame = sensor frame - translation
+  EXPECT_TRUE(attributesAround(reloader, {5, 5}).empty());
+  EXPECT_EQ(attributesAround(reloader, {-95, 5}),
+            (std::vector<uint32_t>{1}));
+  EXPECT_TRUE(reloader.isUseful(Vec2d(-90, 10)));
+
+  config.rt_matrix(0, 0) = 2;
+  EXPECT_FALSE(reloader.apply(config));
+  EXPECT_EQ(reloader.state()->generation(), 2u);
+}
+
+// should reload from the watcher under concurrent queries
+TEST(RegionReloaderTest, watch) {
+  const std::string path = testing::TempDir() + "region_reloader_test.yaml";
+  writeFile(path,
+            "regions: [{index: 1, outer: [[0, 0], [0, 10], [10, 10], "
+            "[10, 0]], attributes: [1], values: [10]}]\n");
+  RegionReloader reloader(path);
+  ASSERT_TRUE(reloader.reload());
+
+  std::atomic<bool> done{false};
+  std::atomic<size_t> inconsistent{0};
+  std::thread reader([&] {
+    while (!done) {
+      const auto found = attributesAround(reloader, {5, 5});
+      if (found != std::vector<uint32_t>{1} &&
+          found != std::vector<uint32_t>{7}) {
+        ++inconsistent;
+      }
+    }
+  });
+  reloader.watch(std::chrono::milliseconds(5));
+  writeFile(path, "regions: [{index: 1, outer: [[0, 0], [0, 10], [10, 10], "
+                  "[10, 0]], attributes: [7], values: [70]}]\n");
+  for (int i = 0; i < 400 && reloader.state()->generation() < 2; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  EXPECT_EQ(reloader.state()->generation(), 2u);
+  EXPECT_EQ(attributesAround(reloader, {5, 5}),
+            (std::vector<uint32_t>{7}));
+
+  writeFile(path, "regions: [{index: 1, outer: [[0, 0]]");
+  for (int i = 0; i < 400 && reloader.error().empty(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  EXPECT_FALSE(reloader.error().empty());
+  EXPECT_EQ(reloader.state()->generation(), 2u);
+  reloader.stop();
+  done = true;
+  reader.join();
+  EXPECT_EQ(inconsistent, 0u);
+  std::remove(path.c_str());
+}
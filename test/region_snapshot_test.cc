@@ -0,0 +1,169 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-03
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/test/region_snapshot_test.cc
+ */
+#include "region_snapshot.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <memory>
+#include <random>
+
+#include "region2d.h"
+#include "test_shapes.h"
+
+using innovusion::geometry::Box2d;
+using innovusion::geometry::Polygon2d;
+using innovusion::geometry::PolygonPtr;
+using innovusion::geometry::PolygonType;
+using innovusion::geometry::RegionSnapshot;
+using innovusion::geometry::RegionStore;
+using innovusion::geometry::Roi2d;
+using innovusion::geometry::test::rect;
+using innovusion::geometry::Vec2d;
+
+namespace {
+void fill(RegionStore* regions, Roi2d* roi) {
+  for (int i = 0; i < 6; ++i) {
+    const double y = -30.0 + 10.0 * i;
+    ASSERT_TRUE(regions->add(100 + i, rect(y, -5, y + 10, 5), {},
+                             {1, uint32_t(2 + i)}, {10 * i, -i}));
+  }
+  ASSERT_TRUE(regions->add(7, {{-10, 10}, {0, 30}, {10, 10}}, {}, {3}, {7}));
+  ASSERT_TRUE(roi->add(0, rect(-20, 5, 20, 40), {rect(-5, 10, 5, 20)}));
+  ASSERT_TRUE(roi->add(1, rect(-30, -40, -10, -10), {}));
+}
+
+// expects every query to answer as the live containers, boxes and points
+void expectSame(const RegionSnapshot& snapshot, const RegionStore& regions,
+                const Roi2d& roi) {
+  ASSERT_EQ(snapshot.regionCount(), regions.size());
+  ASSERT_EQ(snapshot.roiCount(), roi.size());
+  EXPECT_EQ(snapshot.roiInterested(), roi.interested());
+  EXPECT_EQ(snapshot.roiRate(), roi.rate());
+  for (size_t i = 0; i < regions.size(); ++i) {
+    EXPECT_EQ(snapshot.indexAt(i), regions.indexAt(i));
+    EXPECT_TRUE(std::equal(snapshot.valuesAt(i).begin(),
+                           snapshot.valuesAt(i).end(),
+                           regions.valuesAt(i).begin(),
+                           regions.valuesAt(i).end()));
+    EXPECT_DOUBLE_EQ(snapshot.polygonAt(i).area(),
+                     regions.polygonAt(i).area());
+  }
+  std::mt19937 generator(13);
+  std::uniform_real_distribution<double> coordinate(-45, 45);
+  std::uniform_int_distribution<uint32_t> spindle(0, 35999);
+  for (int i = 0; i < 500; ++i) {
+    const Vec2d center(coordinate(generator), coordinate(generator));
+    const PolygonPtr box =
+        std::make_shared<Box2d>(center, 8, 4, spindle(generator));
+    std::vector<uint32_t> attributes, expected_attributes;
+    std::vector<int32_t> values, expected_values, ious, expected_ious;
+    std::unordered_map<uint32_t, uint32_t> flow, expected_flow;
+    snapshot.findRelatedMessage(box, &attributes, &values, &ious, &flow);
+    regions.findRelatedMessage(box, &expected_attributes, &expected_values,
+                               &expected_ious, &expected_flow);
+    ASSERT_EQ(attributes, expected_attributes);
+    ASSERT_EQ(values, expected_values);
+    ASSERT_EQ(ious, expected_ious);
+    ASSERT_EQ(flow, expected_flow);
+    ASSERT_EQ(snapshot.isUseful(box), roi.isUseful(box)) << i;
+    ASSERT_EQ(snapshot.isUseful(center), roi.isUseful(center)) << i;
+  }
+  // concave query polygons take the copying path
+  for (int i = 0; i < 50; ++i) {
+    const double y = coordinate(generator);
+    const double z = coordinate(generator);
+    const PolygonPtr shape = std::make_shared<Polygon2d>(
+        PolygonType::Polygon,
+        std::vector<Vec2d>{{y, z}, {y, z + 8}, {y + 3, z + 8}, {y + 3, z + 3},
+                           {y + 8, z + 3}, {y + 8, z}},
+        std::vector<std::vector<Vec2d>>{});
+    std::vector<uint32_t> attributes, expected_attributes;
+    std::vector<int32_t> values, expected_values, ious, expected_ious;
+    snapshot.findRelatedMessage(shape, &attributes, &values, &ious, nullptr);
+    regions.findRelatedMessage(shape, &expected_attributes, &expected_values,
+                               &expected_ious, nullptr);
+    ASSERT_EQ(ious, expected_ious);
+    ASSERT_EQ(snapshot.isUseful(shape), roi.isUseful(shape)) << i;
+  }
+  // vertices and edges are not within
+  for (const auto& point : {Vec2d(-20, 5), Vec2d(0, 10), Vec2d(-5, 15),
+                            Vec2d(-20, -20), Vec2d(0, 30)}) {
+    EXPECT_EQ(snapshot.isUseful(point), roi.isUseful(point));
+  }
+}
+}  // namespace
+
+// should query in memory images of both ROI kinds
+TEST(RegionSnapshotTest, attach) {
+  for (bool interested : {true, false}) {
+    RegionStore regions;
+    Roi2d roi(interested, 30);
+    fill(&regions, &roi);
+    std::vector<uint8_t> bytes{};
+    RegionSnapshot::serialize(regions, roi, &bytes);
+    RegionSnapshot snapshot;
+    EXPECT_TRUE(snapshot.empty());
+    ASSERT_TRUE(snapshot.attach(bytes));
+    expectSame(snapshot, regions, roi);
+  }
+  RegionStore regions;
+  Roi2d roi;
+  std::vector<uint8_t> bytes{};
+  RegionSnapshot::serialize(regions, roi, &bytes);
+  RegionSnapshot snapshot;
+  ASSERT_TRUE(snapshot.attach(bytes));
+  expectSame(snapshot, regions, roi);
+}
+
+// should round trip through an mmap'd file
+TEST(RegionSnapshotTest, file) {
+  RegionStore regions;
+  Roi2d roi(true, 50, true);
+  fill(&regions, &roi);
+  const std::string path = testing::TempDir() + "region_snapshot_test.bin";
+  ASSERT_TRUE(RegionSnapshot::save(regions, roi, path));
+  RegionSnapshot snapshot;
+  ASSERT_TRUE(snapshot.open(path));
+  expectSame(snapshot, regions, roi);
+  // replacing the file leaves the open mapping intact
+  RegionStore empty_regions;
+  Roi2d empty_roi;
+  ASSERT_TRUE(RegionSnapshot::save(empty_regions, empty_roi, path));
+  expectSame(snapshot, regions, roi);
+  RegionSnapshot reloaded;
+  ASSERT_TRUE(reloaded.open(path));
+  EXPECT_EQ(reloaded.regionCount(), 0);
+  snapshot.close();
+  EXPECT_TRUE(snapshot.empty());
+  EXPECT_FALSE(snapshot.open(path + ".missing"));
+  std::remove(path.c_str());
+}
+
+// should reject damaged images
+TEST(RegionSnapshotTest, corrupted) {
+  RegionStore regions;
+  Roi2d roi;
+  fill(&regions, &roi);
+  std::vector<uint8_t> bytes{};
+  RegionSnapshot::serialize(regions, roi, &bytes);
+  RegionSnapshot snapshot;
+
+  std::vector<uint8_t> damaged(bytes);
+  damaged[damaged.size() / 2] ^= 0x40;
+  EXPECT_FALSE(snapshot.attach(damaged));
+  EXPECT_TRUE(snapshot.empty());
+
+  damaged = bytes;
+  damaged[4] += 1;  // version
+  EXPECT_FALSE(snapshot.attach(damaged));
+
+  EXPECT_FALSE(snapshot.attach({bytes.data(), bytes.size() - 8}));
+  EXPECT_FALSE(snapshot.attach({bytes.data() + 4, bytes.size() - 4}));
+  EXPECT_FALSE(snapshot.isUseful(Vec2d(0, 30)));
+  EXPECT_TRUE(snapshot.attach(bytes));
+}
@@ -0,0 +1,99 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-21
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/test/region_store_test.cc
+ */
+#include "region_store.h"
+
+#include <gtest/gtest.h>
+
+#include "region2d.h"
+
+using innovusion::geometry::Box2d;
+using innovusion::geometry::PolygonPtr;
+using innovusion::geometry::RegionStore;
+using innovusion::geometry::Vec2d;
+
+class RegionStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // three adjacent 10x10 squares along y
+    EXPECT_TRUE(store.add(1, drawRect({0.0, 0.0}, 10.0, 10.0), {}, {1, 2},
+                          {10, 20}));
+    EXPECT_TRUE(store.add(2, drawRect({10.0, 0.0}, 10.0, 10.0), {}, {2, 3},
+                          {21, 31}));
+    EXPECT_TRUE(
+        store.add(3, drawRect({20.0, 0.0}, 10.0, 10.0), {}, {4}, {40}));
+  }
+
+ public:
+  std::vector<Vec2d> drawRect(Vec2d center, double width, double height) {
+    std::vector<Vec2d> rect;
+    rect.emplace_back(Vec2d(center.y - width / 2, center.z - height / 2));
+    rect.emplace_back(Vec2d(center.y - width / 2, center.z + height / 2));
+    rect.emplace_back(Vec2d(center.y + width / 2, center.z + height / 2));
+    rect.emplace_back(Vec2d(center.y + width / 2, center.z - height / 2));
+    return rect;
+  }
+  RegionStore store;
+};
+
+// should refuse inconsistent attributes
+TEST_F(RegionStoreTest, add_invalid) {
+  EXPECT_FALSE(store.add(4, drawRect({50.0, 0.0}, 10.0, 10.0), {}, {1, 1},
+                         {1, 2}));
+  EXPECT_FALSE(
+      store.add(4, drawRect({50.0, 0.0}, 10.0, 10.0), {}, {1, 2}, {1}));
+  EXPECT_EQ(store.size(), 3);
+}
+
+// should keep packed attributes and inverted index after replace and remove
+TEST_F(RegionStoreTest, inverted_index) {
+  std::vector<size_t> denses;
+  store.regionsWithAttribute(2, &denses);
+  EXPECT_EQ(denses.size(), 2);
+
+  EXPECT_TRUE(store.add(2, drawRect({10.0, 0.0}, 10.0, 10.0), {}, {3}, {32}));
+  store.regionsWithAttribute(2, &denses);
+  ASSERT_EQ(denses.size(), 1);
+  EXPECT_EQ(store.indexAt(denses[0]), 1);
+
+  EXPECT_TRUE(store.remove(1));
+  EXPECT_FALSE(store.remove(1));
+  store.regionsWithAttribute(2, &denses);
+  EXPECT_TRUE(denses.empty());
+
+  size_t dense = 0;
+  ASSERT_TRUE(store.find(2, &dense));
+  ASSERT_EQ(store.attributesAt(dense).size(), 1);
+  EXPECT_EQ(store.attributesAt(dense)[0], 3);
+  EXPECT_EQ(store.valuesAt(dense)[0], 32);
+  ASSERT_TRUE(store.find(3, &dense));
+  EXPECT_EQ(store.valuesAt(dense)[0], 40);
+}
+
+// should find unfiltered and filtered related messages
+TEST_F(RegionStoreTest, find_related_message) {
+  PolygonPtr box = std::make_shared<Box2d>(Vec2d(5.0, 0.0), 10.0, 10.0, 0);
+  std::vector<uint32_t> attributes;
+  std::vector<int32_t> values;
+  std::vector<int32_t> ious;
+  std::unordered_map<uint32_t, uint32_t> flow;
+  store.findRelatedMessage(box, &attributes, &values, &ious, &flow);
+  EXPECT_EQ(attributes.size(), 4);
+  EXPECT_EQ(values.size(), 4);
+  EXPECT_EQ(ious.size(), 4);
+  EXPECT_EQ(ious[0], 33);
+  EXPECT_EQ(flow.size(), 2);
+  EXPECT_EQ(flow[1], 1);
+
+  store.findRelatedMessage(box, {3}, &attributes, &values, &ious, nullptr);
+  ASSERT_EQ(attributes.size(), 1);
+  EXPECT_EQ(attributes[0], 3);
+  EXPECT_EQ(values[0], 31);
+  EXPECT_EQ(ious[0], 33);
+
+  store.findRelatedMessage(box, {4}, &attributes, &values, &ious, nullptr);
+  EXPECT_TRUE(attributes.empty());
+}
@@ -0,0 +1,106 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-01
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/test/scan_classifier_test.cc
+ */
+#include "scan_classifier.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include "test_shapes.h"
+
+using innovusion::geometry::MultiplePolygon2d;
+using innovusion::geometry::Roi2d;
+using innovusion::geometry::ScanClassifier;
+using innovusion::geometry::test::rect;
+using innovusion::geometry::Vec2d;
+
+namespace {
+// scan lines of a spinning sensor at the origin, one point per 0.1 degree
+std::vector<Vec2d> scan(size_t lines) {
+  std::vector<Vec2d> points{};
+  for (size_t line = 0; line < lines; ++line) {
+    const double range = 2.0 + line * 1.5;
+    for (int step = 0; step < 3600; ++step) {
+      const double azimuth = step * M_PI / 1800;
+      points.emplace_back(range * std::sin(azimuth), range * std::cos(azimuth));
+    }
+  }
+  return points;
+}
+}  // namespace
+
+// should match MultiplePolygon2d::within on scan ordered and shuffled points
+TEST(ScanClassifierTest, against_within) {
+  MultiplePolygon2d polygons;
+  ASSERT_TRUE(polygons.add(0, rect(-20, 5, 20, 40), {rect(-5, 10, 5, 20)}));
+  ASSERT_TRUE(polygons.add(1, rect(-30, -40, -10, -10), {}));
+  ASSERT_TRUE(polygons.add(2, {{10, -5}, {25, -30}, {30, -5}}, {}));
+
+  std::vector<Vec2d> points = scan(40);
+  // points exactly on a boundary are not within
+  points.emplace_back(-20, 10);
+  points.emplace_back(0, 10);
+  points.emplace_back(-25, -40);
+
+  ScanClassifier classifier(&polygons);
+  std::vector<uint8_t> result{};
+  classifier.within(points, &result);
+  ASSERT_EQ(result.size(), points.size());
+  size_t inside = 0;
+  for (size_t i = 0; i < points.size(); ++i) {
+    ASSERT_EQ(result[i] != 0, polygons.within(points[i])) << i;
+    inside += result[i];
+  }
+  EXPECT_GT(inside, 10000u);
+  const double scan_rate = classifier.hitRate();
+  EXPECT_GT(scan_rate, 0.95);
+
+  std::shuffle(points.begin(), points.end(), std::mt19937(7));
+  classifier.reset();
+  classifier.resetMetrics();
+  classifier.within(points, &result);
+  for (size_t i = 0; i < points.size(); ++i) {
+    ASSERT_EQ(result[i] != 0, polygons.within(points[i])) << i;
+  }
+  EXPECT_LT(classifier.hitRate(), scan_rate);
+
+  // the index follows the set
+  ASSERT_TRUE(polygons.remove(0));
+  EXPECT_FALSE(classifier.within(Vec2d(0, 30)));
+  EXPECT_EQ(classifier.lastPolygon(), ScanClassifier::kNone);
+  EXPECT_TRUE(classifier.within(Vec2d(-20, -20)));
+  EXPECT_EQ(polygons.indexAt(classifier.lastPolygon()), 1u);
+
+  // an invalid return in the stream is never within and breaks the chain
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_FALSE(classifier.within(Vec2d(nan, nan)));
+  EXPECT_FALSE(classifier.within(Vec2d(-20, nan)));
+  EXPECT_EQ(classifier.lastPolygon(), ScanClassifier::kNone);
+  EXPECT_FALSE(classifier.within(Vec2d(50, 50)));
+  EXPECT_TRUE(classifier.within(Vec2d(-20, -20)));
+  EXPECT_FALSE(classifier.within(
+      Vec2d(std::numeric_limits<double>::infinity(), -20)));
+  EXPECT_FALSE(classifier.within(Vec2d(50, 50)));
+}
+
+// should answer isUseful for both ROI kinds
+TEST(ScanClassifierTest, roi) {
+  const std::vector<Vec2d> points = scan(20);
+  for (bool interested : {true, false}) {
+    Roi2d roi(interested);
+    ASSERT_TRUE(roi.add(0, rect(-10, -10, 10, 10), {rect(-3, -3, 3, 3)}));
+    ScanClassifier classifier(&roi);
+    std::vector<uint8_t> result{};
+    classifier.isUseful(points, &result);
+    for (size_t i = 0; i < points.size(); ++i) {
+      ASSERT_EQ(result[i] != 0, roi.isUseful(points[i])) << i;
+    }
+  }
+}
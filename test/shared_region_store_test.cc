@@ -0,0 +1,160 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-04
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/test/shared_region_store_test.cc
+ */
+#include "shared_region_store.h"
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+
+#include "region2d.h"
+#include "test_shapes.h"
+
+using innovusion::geometry::Box2d;
+using innovusion::geometry::PolygonPtr;
+using innovusion::geometry::RegionStore;
+using innovusion::geometry::Roi2d;
+using innovusion::geometry::SharedRegionReader;
+using innovusion::geometry::SharedRegionWriter;
+using innovusion::geometry::test::rect;
+using innovusion::geometry::Vec2d;
+
+namespace {
+std::string uniqueName(const std::string& test) {
+  return "/geometry_" + test + "_" + std::to_string(::getpid());
+}
+
+bool exists(const std::string& name) {
+  const int descriptor = ::shm_open(name.c_str(), O_RDONLY, 0);
+  if (descriptor < 0) {
+    return false;
+  }
+  ::close(descriptor);
+  return true;
+}
+}  // namespace
+
+// should publish generations while a reader holds the previous one
+TEST(SharedRegionStoreTest, publish) {
+  const std::string name = uniqueName("publish");
+  RegionStore regions;
+  ASSERT_TRUE(regions.add(1, rect(0, 0, 10, 10), {}, {1}, {10}));
+  ASSERT_TRUE(regions.add(2, rect(10, 0, 20, 10), {}, {2}, {20}));
+  Roi2d roi;
+  ASSERT_TRUE(roi.add(0, rect(-20, -20, 20, 20), {rect(-5, -5, 5, 5)}));
+
+  SharedRegionReader reader(name);
+  EXPECT_FALSE(reader.refresh());
+  EXPECT_FALSE(reader.isUseful(Vec2d(10, 10)));
+
+  SharedRegionWriter writer(name);
+  ASSERT_TRUE(writer.create());
+  EXPECT_EQ(writer.generation(), 0u);
+  EXPECT_FALSE(reader.refresh());
+  ASSERT_TRUE(writer.publish(regions, roi));
+  EXPECT_EQ(writer.generation(), 1u);
+
+  ASSERT_TRUE(reader.refresh());
+  EXPECT_EQ(reader.generation(), 1u);
+  EXPECT_EQ(reader.snapshot().regionCount(), 2u);
+  const PolygonPtr box = std::make_shared<Box2d>(Vec2d(9, 5), 4, 4, 0);
+  std::vector<uint32_t> attributes, expected_attributes;
+  std::vector<int32_t> values, expected_values, ious, expected_ious;
+  std::unordered_map<uint32_t, uint32_t> flow, expected_flow;
+  reader.findRelatedMessage(box, &attributes, &values, &ious, &flow);
+  regions.findRelatedMessage(box, &expected_attributes, &expected_values,
+                             &expected_ious, &expected_flow);
+  EXPECT_EQ(attributes, expected_attributes);
+  EXPECT_EQ(values, expected_values);
+  EXPECT_EQ(ious, expected_ious);
+  EXPECT_EQ(flow, expected_flow);
+  EXPECT_TRUE(reader.isUseful(Vec2d(10, 10)));
+  EXPECT_FALSE(reader.isUseful(Vec2d(0, 0)));
+  EXPECT_EQ(reader.isUseful(box), roi.isUseful(box));
+
+  ASSERT_TRUE(regions.add(3, rect(20, 0, 30, 10), {}, {3}, {30}));
+  ASSERT_TRUE(writer.publish(regions, roi));
+  EXPECT_FALSE(exists(name + ".1"));
+  // generation 1 stays mapped until refresh
+  EXPECT_EQ(reader.snapshot().regionCount(), 2u);
+  EXPECT_TRUE(reader.isUseful(Vec2d(10, 10)));
+  ASSERT_TRUE(reader.refresh());
+  EXPECT_EQ(reader.generation(), 2u);
+  EXPECT_EQ(reader.snapshot().regionCount(), 3u);
+  ASSERT_TRUE(reader.refresh());
+  EXPECT_EQ(reader.generation(), 2u);
+
+  writer.unlink();
+  EXPECT_FALSE(exists(name));
+  EXPECT_FALSE(exists(name + ".2"));
+  EXPECT_EQ(reader.snapshot().regionCount(), 3u);
+  SharedRegionReader late(name);
+  EXPECT_FALSE(late.refresh());
+}
+
+// should let a restarted writer continue the control object generation
+TEST(SharedRegionStoreTest, restart) {
+  const std::string name = uniqueName("restart");
+  RegionStore regions;
+  ASSERT_TRUE(regions.add(1, rect(0, 0, 10, 10), {}, {1}, {10}));
+  Roi2d roi;
+  {
+    SharedRegionWriter writer(name);
+    ASSERT_TRUE(writer.create());
+    ASSERT_TRUE(writer.publish(regions, roi));
+    ASSERT_TRUE(writer.publish(regions, roi));
+  }
+  SharedRegionReader reader(name, false);
+  ASSERT_TRUE(reader.refresh());
+  EXPECT_EQ(reader.generation(), 2u);
+
+  SharedRegionWriter writer(name);
+  ASSERT_TRUE(writer.create());
+  EXPECT_EQ(writer.generation(), 2u);
+  ASSERT_TRUE(writer.publish(regions, roi));
+  ASSERT_TRUE(reader.refresh());
+  EXPECT_EQ(reader.generation(), 3u);
+  writer.unlink();
+}
+
+// should follow a writer that unlinked the store and created it again
+TEST(SharedRegionStoreTest, recreate) {
+  const std::string name = uniqueName("recreate");
+  RegionStore regions;
+  ASSERT_TRUE(regions.add(1, rect(0, 0, 10, 10), {}, {1}, {10}));
+  Roi2d roi;
+  SharedRegionReader reader(name);
+  {
+    SharedRegionWriter writer(name);
+    ASSERT_TRUE(writer.create());
+    ASSERT_TRUE(writer.publish(regions, roi));
+    ASSERT_TRUE(writer.publish(regions, roi));
+    ASSERT_TRUE(reader.refresh());
+    EXPECT_EQ(reader.generation(), 2u);
+    writer.unlink();
+  }
+  // nothing to follow yet, the old snapshot stays mapped
+  ASSERT_TRUE(reader.refresh());
+  EXPECT_EQ(reader.generation(), 2u);
+  EXPECT_EQ(reader.snapshot().regionCount(), 1u);
+
+  ASSERT_TRUE(regions.add(2, rect(10, 0, 20, 10), {}, {2}, {20}));
+  SharedRegionWriter writer(name);
+  ASSERT_TRUE(writer.create());
+  EXPECT_EQ(writer.generation(), 0u);
+  ASSERT_TRUE(writer.publish(regions, roi));
+  ASSERT_TRUE(reader.refresh());
+  EXPECT_EQ(reader.generation(), 1u);
+  EXPECT_EQ(reader.snapshot().regionCount(), 2u);
+  ASSERT_TRUE(writer.publish(regions, roi));
+  ASSERT_TRUE(reader.refresh());
+  EXPECT_EQ(reader.generation(), 2u);
+  writer.unlink();
+}
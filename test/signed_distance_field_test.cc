@@ -0,0 +1,72 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-30
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/test/signed_distance_field_test.cc
+ */
+#include "signed_distance_field.h"
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <random>
+
+using innovusion::geometry::boundaryDistance;
+using innovusion::geometry::Polygon2d;
+using innovusion::geometry::PolygonType;
+using innovusion::geometry::SignedDistanceField;
+using innovusion::geometry::Vec2d;
+
+namespace {
+double exact(const std::vector<Polygon2d>& polygons, const Vec2d& point) {
+  double distance = std::numeric_limits<double>::max();
+  for (const auto& polygon : polygons) {
+    const double boundary = boundaryDistance(point, polygon.getPolygon());
+    if (polygon.covered(point)) {
+      return -boundary;
+    }
+    distance = std::min(distance, boundary);
+  }
+  return distance;
+}
+}  // namespace
+
+// should match exact distances of a square with a hole and a triangle
+TEST(SignedDistanceFieldTest, against_exact) {
+  std::vector<Polygon2d> polygons;
+  polygons.emplace_back(
+      PolygonType::Region,
+      std::vector<Vec2d>{{0, 0}, {0, 10}, {10, 10}, {10, 0}},
+      std::vector<std::vector<Vec2d>>{{{4, 4}, {6, 4}, {6, 6}, {4, 6}}});
+  polygons.emplace_back(PolygonType::Region,
+                        std::vector<Vec2d>{{15, 0}, {20, 8}, {25, 0}},
+                        std::vector<std::vector<Vec2d>>{});
+
+  SignedDistanceField field;
+  EXPECT_TRUE(field.empty());
+  EXPECT_FALSE(field.build(polygons, 0.1, 1.0, 100));
+  EXPECT_TRUE(field.empty());
+  ASSERT_TRUE(field.build(polygons, 0.1, 1.0));
+  // envelope (0, 0) (25, 10) padded by 1
+  EXPECT_NEAR(field.columns(), 271, 1);
+  EXPECT_NEAR(field.rows(), 121, 1);
+  EXPECT_TRUE(field.contains({-1, -1}));
+  EXPECT_FALSE(field.contains({-1.2, 5}));
+
+  std::mt19937 generator(23);
+  std::uniform_real_distribution<double> y(-5, 30);
+  std::uniform_real_distribution<double> z(-5, 15);
+  for (int i = 0; i < 2000; ++i) {
+    const Vec2d point(y(generator), z(generator));
+    const double expected = exact(polygons, point);
+    if (field.contains(point)) {
+      // half a step of boundary placement plus the bilinear error
+      EXPECT_NEAR(field.sample(point), expected, 0.15);
+    } else {
+      EXPECT_GE(field.sample(point), expected - 0.15);
+    }
+  }
+  EXPECT_NEAR(field.sample({5, 5}), 1.0, 0.15);
+  EXPECT_NEAR(field.sample({2, 5}), -2.0, 0.15);
+  EXPECT_GE(field.sample({100, 5}), 75.0);
+}
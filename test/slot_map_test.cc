@@ -0,0 +1,56 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-20
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/test/slot_map_test.cc
+ */
+#include "slot_map.h"
+
+#include <gtest/gtest.h>
+
+using innovusion::geometry::SlotHandle;
+using innovusion::geometry::SlotMap;
+
+// should hand out dense handles in insertion order
+TEST(SlotMapTest, Insert) {
+  SlotMap slots;
+  EXPECT_TRUE(slots.empty());
+  SlotHandle first = slots.insert();
+  SlotHandle second = slots.insert();
+  EXPECT_EQ(slots.size(), 2);
+  EXPECT_EQ(slots.dense(first), 0);
+  EXPECT_EQ(slots.dense(second), 1);
+  EXPECT_TRUE(slots.handle(1) == second);
+}
+
+// should move the last element into the hole on erase and stale the handle
+TEST(SlotMapTest, EraseSwapAndPop) {
+  SlotMap slots;
+  SlotHandle first = slots.insert();
+  SlotHandle second = slots.insert();
+  SlotHandle third = slots.insert();
+  size_t hole = 0;
+  EXPECT_TRUE(slots.erase(first, &hole));
+  EXPECT_EQ(hole, 0);
+  EXPECT_FALSE(slots.contains(first));
+  EXPECT_EQ(slots.dense(third), 0);
+  EXPECT_EQ(slots.dense(second), 1);
+  EXPECT_FALSE(slots.erase(first, &hole));
+}
+
+// should not revive stale handles when a slot is reused
+TEST(SlotMapTest, Generation) {
+  SlotMap slots;
+  SlotHandle first = slots.insert();
+  size_t hole = 0;
+  EXPECT_TRUE(slots.erase(first, &hole));
+  SlotHandle reused = slots.insert();
+  EXPECT_EQ(reused.slot, first.slot);
+  EXPECT_NE(reused.generation, first.generation);
+  EXPECT_FALSE(slots.contains(first));
+  EXPECT_TRUE(slots.contains(reused));
+
+  slots.clear();
+  EXPECT_TRUE(slots.empty());
+  EXPECT_FALSE(slots.contains(reused));
+}
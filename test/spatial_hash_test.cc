@@ -0,0 +1,132 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-28
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/test/spatial_hash_test.cc
+ */
+#include "spatial_hash.h"
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <random>
+
+#include "region2d.h"
+
+using innovusion::geometry::Box2d;
+using innovusion::geometry::GBox;
+using innovusion::geometry::PolygonPtr;
+using innovusion::geometry::SpatialHash;
+using innovusion::geometry::Vec2d;
+
+namespace {
+std::vector<GBox> randomEnvelopes(size_t count, uint32_t seed) {
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<double> position(-100.0, 100.0);
+  std::uniform_real_distribution<double> size(0.5, 6.0);
+  std::vector<GBox> envelopes;
+  for (size_t i = 0; i < count; ++i) {
+    const Vec2d corner(position(generator), position(generator));
+    envelopes.emplace_back(corner,
+                           corner + Vec2d(size(generator), size(generator)));
+  }
+  return envelopes;
+}
+}  // namespace
+
+// should answer the three queries as brute force
+TEST(SpatialHashTest, brute_force) {
+  auto envelopes = randomEnvelopes(500, 7);
+  // one huge and one non finite envelope go to the oversized list
+  envelopes.emplace_back(Vec2d(-1000, -1000), Vec2d(1000, 1000));
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  envelopes.emplace_back(Vec2d(nan, 0), Vec2d(nan, 1));
+
+  SpatialHash hash(SpatialHash::suggestCellSize(envelopes));
+  hash.rebuild(envelopes);
+  ASSERT_EQ(hash.size(), envelopes.size());
+
+  std::mt19937 generator(11);
+  std::uniform_real_distribution<double> position(-110.0, 110.0);
+  std::vector<uint32_t> items;
+  for (int round = 0; round < 50; ++round) {
+    const Vec2d point(position(generator), position(generator));
+    const double radius = round % 5;
+    hash.near(point, radius, &items);
+    std::vector<uint32_t> expected;
+    for (uint32_t i = 0; i < envelopes.size(); ++i) {
+      if (SpatialHash::envelopeDistance(GBox(point, point), envelopes[i]) <=
+          radius) {
+        expected.emplace_back(i);
+      }
+    }
+    EXPECT_EQ(items, expected);
+
+    const GBox region(point, point + Vec2d(round, 2 * round));
+    hash.near(region, radius, &items);
+    expected.clear();
+    for (uint32_t i = 0; i < envelopes.size(); ++i) {
+      if (SpatialHash::envelopeDistance(region, envelopes[i]) <= radius) {
+        expected.emplace_back(i);
+      }
+    }
+    EXPECT_EQ(items, expected);
+
+    hash.overlapping(region, &items);
+    expected.clear();
+    // boost reports NaN envelopes as intersecting, the hash never does
+    for (uint32_t i = 0; i + 1 < envelopes.size(); ++i) {
+      if (boost::geometry::intersects(region, envelopes[i])) {
+        expected.emplace_back(i);
+      }
+    }
+    EXPECT_EQ(items, expected);
+  }
+
+  for (double distance : {0.0, 1.5, 8.0}) {
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    hash.candidatePairs(distance, &pairs);
+    std::vector<std::pair<uint32_t, uint32_t>> expected;
+    for (uint32_t i = 0; i < envelopes.size(); ++i) {
+      for (uint32_t j = i + 1; j < envelopes.size(); ++j) {
+        if (SpatialHash::envelopeDistance(envelopes[i], envelopes[j]) <=
+            distance) {
+          expected.emplace_back(i, j);
+        }
+      }
+    }
+    EXPECT_EQ(pairs, expected);
+  }
+}
+
+// should rebuild from boxes and reuse storage across frames
+TEST(SpatialHashTest, rebuild_boxes) {
+  SpatialHash hash(4.0);
+  std::vector<uint32_t> items;
+  hash.near({0, 0}, 10, &items);
+  EXPECT_TRUE(items.empty());
+
+  std::vector<PolygonPtr> boxes;
+  boxes.emplace_back(std::make_shared<Box2d>(Vec2d(0, 0), 4, 2, 0));
+  boxes.emplace_back(std::make_shared<Box2d>(Vec2d(4, 0), 4, 2, 9000));
+  boxes.emplace_back(std::make_shared<Box2d>(Vec2d(50, 50), 4, 2, 4500));
+  hash.rebuild(boxes);
+  hash.near({50, 50}, 0.1, &items);
+  EXPECT_EQ(items, std::vector<uint32_t>({2}));
+  hash.overlapping(GBox(Vec2d(-1, -1), Vec2d(1, 1)), &items);
+  EXPECT_EQ(items, std::vector<uint32_t>({0}));
+  std::vector<std::pair<uint32_t, uint32_t>> pairs;
+  hash.candidatePairs(1.5, &pairs);
+  ASSERT_EQ(pairs.size(), 1);
+  EXPECT_EQ(pairs[0], std::make_pair(0u, 1u));
+
+  // next frame
+  boxes.pop_back();
+  boxes.pop_back();
+  hash.rebuild(boxes);
+  hash.near({50, 50}, 0.1, &items);
+  EXPECT_TRUE(items.empty());
+  hash.setCellSize(0.25);
+  hash.overlapping(GBox(Vec2d(-1, -1), Vec2d(1, 1)), &items);
+  EXPECT_EQ(items, std::vector<uint32_t>({0}));
+}
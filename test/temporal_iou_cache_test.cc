@@ -0,0 +1,121 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-28
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/test/temporal_iou_cache_test.cc
+ */
+#include "temporal_iou_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "region2d.h"
+#include "region_store.h"
+
+using innovusion::geometry::Box2d;
+using innovusion::geometry::CoherentIouResult;
+using innovusion::geometry::Polygon2d;
+using innovusion::geometry::PolygonPtr;
+using innovusion::geometry::PolygonType;
+using innovusion::geometry::RegionStore;
+using innovusion::geometry::TemporalIouCache;
+using innovusion::geometry::Vec2d;
+
+namespace {
+PolygonPtr makeRegion() {
+  // square with a hole
+  return std::make_shared<Polygon2d>(
+      PolygonType::Region,
+      std::vector<Vec2d>{{-50, -50}, {-50, 50}, {50, 50}, {50, -50}},
+      std::vector<std::vector<Vec2d>>{{{-5, -5}, {5, -5}, {5, 5}, {-5, 5}}});
+}
+}  // namespace
+
+// should match exact results for a slowly moving box and count hits
+TEST(TemporalIouCacheTest, moving_box) {
+  const PolygonPtr region = makeRegion();
+  TemporalIouCache cache;
+  // inside, then crossing, outside hole, back inside
+  for (int frame = 0; frame < 400; ++frame) {
+    const Vec2d center(-30 + frame * 0.05, 20 - frame * 0.06);
+    const PolygonPtr box =
+        std::make_shared<Box2d>(center, 4.0, 2.0 + frame * 0.001, 3000);
+    const CoherentIouResult result = cache.query(7, 1, 0, box, *region);
+    EXPECT_NEAR(result.iou, box->iou(region), 1e-9) << frame;
+    EXPECT_EQ(result.iou_target, box->iouTarget(region)) << frame;
+  }
+  EXPECT_EQ(cache.hits() + cache.misses(), 400);
+  EXPECT_GT(cache.hitRate(), 0.5);
+  EXPECT_EQ(cache.size(), 1);
+}
+
+// should cache far away and inside poses but not crossing ones
+TEST(TemporalIouCacheTest, placements) {
+  const PolygonPtr region = makeRegion();
+  TemporalIouCache cache;
+  const PolygonPtr outside = std::make_shared<Box2d>(Vec2d(100, 0), 4, 2, 0);
+  const PolygonPtr outside_moved =
+      std::make_shared<Box2d>(Vec2d(101, 1), 4, 2, 0);
+  EXPECT_FALSE(cache.query(1, 1, 0, outside, *region).cached);
+  EXPECT_TRUE(cache.query(1, 1, 0, outside_moved, *region).cached);
+
+  // inside, moving further than the distance to the hole is a miss
+  const PolygonPtr inside = std::make_shared<Box2d>(Vec2d(20, 20), 4, 2, 0);
+  const PolygonPtr near_hole = std::make_shared<Box2d>(Vec2d(6, 6), 4, 2, 0);
+  EXPECT_FALSE(cache.query(2, 1, 0, inside, *region).cached);
+  const CoherentIouResult grown =
+      cache.query(2, 1, 0, std::make_shared<Box2d>(Vec2d(20, 20), 5, 3, 0),
+                  *region);
+  EXPECT_TRUE(grown.cached);
+  EXPECT_NEAR(grown.iou, 15.0 / 9900, 1e-12);
+  EXPECT_FALSE(cache.query(2, 1, 0, near_hole, *region).cached);
+
+  const PolygonPtr crossing = std::make_shared<Box2d>(Vec2d(50, 0), 4, 2, 0);
+  EXPECT_FALSE(cache.query(3, 1, 0, crossing, *region).cached);
+  EXPECT_FALSE(cache.query(3, 1, 0, crossing, *region).cached);
+
+  // a region replaced under the same id comes with a new container version,
+  // even at the address of the previous one
+  const PolygonPtr replaced = makeRegion();
+  EXPECT_FALSE(cache.query(1, 1, 1, outside, *replaced).cached);
+  EXPECT_TRUE(cache.query(1, 1, 1, outside_moved, *replaced).cached);
+
+  EXPECT_FALSE(cache.query(1, 2, 0, outside, *region).cached);
+  EXPECT_EQ(cache.size(), 4);
+  cache.eraseTrack(1);
+  EXPECT_EQ(cache.size(), 2);
+  cache.eraseRegion(1);
+  EXPECT_EQ(cache.size(), 0);
+  cache.resetMetrics();
+  EXPECT_EQ(cache.hitRate(), 0.0);
+}
+
+// should miss when a rebuilt store holds other geometry under the same id
+TEST(TemporalIouCacheTest, rebuilt_store) {
+  const std::vector<Vec2d> square{{0, 0}, {0, 10}, {10, 10}, {10, 0}};
+  const std::vector<Vec2d> moved{{20, 0}, {20, 10}, {30, 10}, {30, 0}};
+  RegionStore store;
+  ASSERT_TRUE(store.add(1, square, {}, {1}, {10}));
+  const PolygonPtr box = std::make_shared<Box2d>(Vec2d(25, 5), 2, 2, 0);
+  TemporalIouCache cache;
+  EXPECT_FALSE(cache.query(1, 1, store.version(), box, store.polygonAt(0))
+                   .cached);
+  EXPECT_TRUE(cache.query(1, 1, store.version(), box, store.polygonAt(0))
+                  .cached);
+
+  // same mutation count, different content
+  RegionStore rebuilt;
+  ASSERT_TRUE(rebuilt.add(1, moved, {}, {1}, {10}));
+  EXPECT_NE(rebuilt.version(), store.version());
+  const CoherentIouResult result =
+      cache.query(1, 1, rebuilt.version(), box, rebuilt.polygonAt(0));
+  EXPECT_FALSE(result.cached);
+  EXPECT_NEAR(result.iou, 0.04, 1e-9);
+
+  // a copy is a new version too
+  const RegionStore copy(store);
+  EXPECT_NE(copy.version(), store.version());
+  rebuilt = store;
+  EXPECT_NE(rebuilt.version(), store.version());
+}
@@ -0,0 +1,26 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-04
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/test/test_shapes.h
+ */
+#pragma once
+#include <vector>
+
+#include "vec2d.h"
+
+namespace innovusion {
+namespace geometry {
+namespace test {
+
+/***
+ * @description: Open clockwise ring of the axis aligned rectangle
+ * [y0, y1] x [z0, z1]
+ */
+inline std::vector<Vec2d> rect(double y0, double z0, double y1, double z1) {
+  return {{y0, z0}, {y0, z1}, {y1, z1}, {y1, z0}};
+}
+
+}  // namespace test
+}  // namespace geometry
+}  // namespace innovusion
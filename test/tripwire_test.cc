@@ -0,0 +1,123 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-09-29
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/test/tripwire_test.cc
+ */
+#include "tripwire.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "region2d.h"
+
+using innovusion::geometry::Box2d;
+using innovusion::geometry::Gsegment;
+using innovusion::geometry::TripwireCrossing;
+using innovusion::geometry::TripwireDirection;
+using innovusion::geometry::TripwireSet;
+using innovusion::geometry::TripwireTrack;
+using innovusion::geometry::Vec2d;
+
+// should count directions of a box driving back and forth over a line
+TEST(TripwireTest, back_and_forth) {
+  TripwireSet tripwires;
+  // along z, positive side is y < 0
+  ASSERT_TRUE(tripwires.addLine(5, {0, -10}, {0, 10}));
+  EXPECT_FALSE(tripwires.addLine(6, {1, 1}, {1, 1}));
+
+  std::vector<TripwireCrossing> crossings;
+  std::vector<TripwireTrack> tracks(1);
+  const double positions[] = {-3, -1, 0, 0, 1, 3, 0, -2, 20, -20, -1, -5};
+  size_t total = 0;
+  for (double y : positions) {
+    Box2d box(Vec2d(y, 0), 2, 1, 9000);
+    tracks[0] = {9, box.f_segment()};
+    tripwires.update(tracks, &crossings);
+    total += crossings.size();
+  }
+  // front midpoint is y + 1: -1 on the line then 0 forward once, 0 -> -2
+  // backward, -2 -> 20 forward, 20 -> -20 backward, -20 -> -1 -> -5 touches
+  // the line and returns
+  uint64_t forward = 0;
+  uint64_t backward = 0;
+  ASSERT_TRUE(tripwires.counts(5, &forward, &backward));
+  EXPECT_EQ(forward, 2);
+  EXPECT_EQ(backward, 2);
+  EXPECT_EQ(total, 4);
+
+  // a track missing for a frame does not count the jump
+  tracks.clear();
+  tripwires.update(tracks, &crossings);
+  tracks.push_back({9, Gsegment({30, 0}, {30, 1})});
+  tripwires.update(tracks, &crossings);
+  EXPECT_TRUE(crossings.empty());
+
+  // segment end points bound the line
+  tracks[0].segment = Gsegment({-30, 40}, {-30, 41});
+  tripwires.update(tracks, &crossings);
+  EXPECT_TRUE(crossings.empty());
+
+  tripwires.resetCounts();
+  ASSERT_TRUE(tripwires.counts(5, &forward, &backward));
+  EXPECT_EQ(forward + backward, 0);
+  ASSERT_TRUE(tripwires.removeLine(5));
+  EXPECT_FALSE(tripwires.counts(5, &forward, &backward));
+}
+
+// should match brute force segment intersection over many lines and tracks
+TEST(TripwireTest, brute_force) {
+  std::mt19937 generator(17);
+  std::uniform_real_distribution<double> position(-200, 200);
+  std::uniform_real_distribution<double> offset(-8, 8);
+  std::normal_distribution<double> step(0.0, 1.0);
+  TripwireSet tripwires;
+  std::vector<std::pair<Vec2d, Vec2d>> lines;
+  for (uint32_t i = 0; i < 300; ++i) {
+    const Vec2d start(position(generator), position(generator));
+    const Vec2d end = start + Vec2d(offset(generator), offset(generator));
+    lines.emplace_back(start, end);
+    ASSERT_TRUE(tripwires.addLine(i, start, end));
+  }
+  std::vector<TripwireTrack> tracks;
+  for (uint32_t i = 0; i < 3000; ++i) {
+    const Vec2d center(position(generator), position(generator));
+    tracks.push_back({i, Gsegment(center, center + Vec2d(0, 1))});
+  }
+  std::vector<TripwireCrossing> crossings;
+  tripwires.update(tracks, &crossings);
+  EXPECT_TRUE(crossings.empty());
+  std::vector<uint64_t> forward(lines.size(), 0);
+  std::vector<uint64_t> backward(lines.size(), 0);
+  for (int frame = 0; frame < 20; ++frame) {
+    for (auto& track : tracks) {
+      const Vec2d from = (track.segment.first + track.segment.second) / 2;
+      const Vec2d move(step(generator), step(generator));
+      track.segment.first += move;
+      track.segment.second += move;
+      const Vec2d to = from + move;
+      for (size_t i = 0; i < lines.size(); ++i) {
+        const auto& [start, end] = lines[i];
+        const bool from_left = ((end - start) ^ (from - start)) > 0;
+        const bool to_left = ((end - start) ^ (to - start)) > 0;
+        if (from_left != to_left &&
+            boost::geometry::intersects(Gsegment(from, to),
+                                        Gsegment(start, end))) {
+          ++(from_left ? forward[i] : backward[i]);
+        }
+      }
+    }
+    tripwires.update(tracks, &crossings);
+  }
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < lines.size(); ++i) {
+    uint64_t actual_forward = 0;
+    uint64_t actual_backward = 0;
+    ASSERT_TRUE(tripwires.counts(i, &actual_forward, &actual_backward));
+    EXPECT_EQ(actual_forward, forward[i]) << i;
+    EXPECT_EQ(actual_backward, backward[i]) << i;
+    total += actual_forward + actual_backward;
+  }
+  EXPECT_GT(total, 0);
+}
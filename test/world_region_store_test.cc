@@ -0,0 +1,137 @@
+/***
+ * @Copyright [2023] <Innovusion Inc.>
+ * @LastEditTime: 2023-10-02
+ * @LastEditors: Tianyun Xuan
+ * @FilePath: geometry/test/world_region_store_test.cc
+ */
+#include "world_region_store.h"
+
+#include <gtest/gtest.h>
+
+#include <Eigen/Geometry>
+#include <cmath>
+#include <memory>
+#include <random>
+
+#include "region2d.h"
+#include "test_shapes.h"
+
+using innovusion::geometry::Box2d;
+using innovusion::geometry::PolygonPtr;
+using innovusion::geometry::RegionStore;
+using innovusion::geometry::RigidTransform2d;
+using innovusion::geometry::Roi2d;
+using innovusion::geometry::SensorRegionView;
+using innovusion::geometry::test::rect;
+using innovusion::geometry::Vec2d;
+using innovusion::geometry::WorldRegionStore;
+
+namespace {
+std::vector<Vec2d> transformed(const RigidTransform2d& transform,
+                         const std::vector<Vec2d>& ring) {
+  std::vector<Vec2d> result{};
+  for (const auto& point : ring) {
+    result.emplace_back(transform.apply(point));
+  }
+  return result;
+}
+}  // namespace
+
+// should answer every sensor view as a per sensor copy of the transformed
+// regions, as RegionMonitor builds it
+TEST(WorldRegionStoreTest, against_per_sensor_copy) {
+  const std::vector<std::vector<Vec2d>> outers{
+      rect(0, 0, 10, 10), rect(10, 0, 20, 10), rect(-15, -20, -5, 5)};
+  // mountings as RegionMonitor::init_rt_matrix gets them, with yaw and pitch
+  Eigen::Matrix4f matrix_wuyue;
+  matrix_wuyue << 0.999938916, 0.00997443964, -0.00476180276, 0.0336134475,
+      0.00972163248, -0.998679324, -0.0504489598, 14.5929322, -0.00525871406,
+      0.0503995856, -0.998715289, 61.2275867, 0.0, 0.0, 0.0, 1.0;
+  Eigen::Matrix4f matrix_tilted = Eigen::Matrix4f::Identity();
+  matrix_tilted.block<3, 3>(0, 0) =
+      (Eigen::AngleAxisf(0.6, Eigen::Vector3f::UnitZ()) *
+       Eigen::AngleAxisf(-0.3, Eigen::Vector3f::UnitY()) *
+       Eigen::AngleAxisf(2.0, Eigen::Vector3f::UnitX()))
+          .toRotationMatrix();
+  matrix_tilted(1, 3) = 4;
+  matrix_tilted(2, 3) = 1;
+  std::vector<RigidTransform2d> transforms(3);
+  transforms[1] = RigidTransform2d({0.8, 0.6}, {-0.6, 0.8}, {-3, -12});
+  ASSERT_TRUE(RigidTransform2d::fromMatrix(matrix_wuyue, 1e-3, &transforms[0]));
+  ASSERT_TRUE(
+      RigidTransform2d::fromMatrix(matrix_tilted, 1e-3, &transforms[2]));
+
+  WorldRegionStore world;
+  for (size_t i = 0; i < outers.size(); ++i) {
+    ASSERT_TRUE(world.add(i + 1, outers[i], {}, {uint32_t(i + 1)},
+                          {int32_t(10 * i)}));
+  }
+  ASSERT_TRUE(world.addRoi(1, rect(-10, -10, 15, 15), {}));
+  for (size_t sensor = 0; sensor < transforms.size(); ++sensor) {
+    world.addSensor(sensor, transforms[sensor]);
+  }
+  EXPECT_EQ(world.size(), 3u);
+  EXPECT_EQ(world.roiSize(), 1u);
+  EXPECT_EQ(world.sensorCount(), 3u);
+
+  std::mt19937 generator(11);
+  std::uniform_real_distribution<double> coordinate(-25, 25);
+  std::uniform_int_distribution<uint32_t> spindle(0, 35999);
+  for (size_t sensor = 0; sensor < transforms.size(); ++sensor) {
+    const RigidTransform2d& transform = transforms[sensor];
+    RegionStore copy;
+    Roi2d roi;
+    for (size_t i = 0; i < outers.size(); ++i) {
+      ASSERT_TRUE(copy.add(i + 1, transformed(transform, outers[i]), {},
+                           {uint32_t(i + 1)}, {int32_t(10 * i)}));
+    }
+    ASSERT_TRUE(
+        roi.add(1, transformed(transform, rect(-10, -10, 15, 15)), {}));
+
+    SensorRegionView view;
+    EXPECT_FALSE(view.valid());
+    ASSERT_TRUE(world.view(sensor, &view));
+    // the map is affine: areas scale by its determinant, ratios do not
+    const double determinant =
+        transform.rowY().y * transform.rowZ().z -
+        transform.rowY().z * transform.rowZ().y;
+    for (int i = 0; i < 300; ++i) {
+      const Vec2d center = transform.apply(
+          Vec2d(coordinate(generator), coordinate(generator)));
+      const PolygonPtr box =
+          std::make_shared<Box2d>(center, 6, 3, spindle(generator));
+      std::vector<uint32_t> attributes, expected_attributes;
+      std::vector<int32_t> values, expected_values, ious, expected_ious;
+      view.findRelatedMessage(box, &attributes, &values, &ious, nullptr);
+      copy.findRelatedMessage(box, &expected_attributes, &expected_values,
+                              &expected_ious, nullptr);
+      ASSERT_EQ(attributes, expected_attributes);
+      ASSERT_EQ(values, expected_values);
+      ASSERT_EQ(ious.size(), expected_ious.size());
+      for (size_t k = 0; k < ious.size(); ++k) {
+        // the world and sensor frame intersections round differently
+        EXPECT_NEAR(ious[k], expected_ious[k], 1);
+      }
+      EXPECT_EQ(view.isUseful(center), roi.isUseful(center));
+      const double area = view.toWorld(box)->area();
+      EXPECT_NEAR(area, box->area() / std::fabs(determinant), 1e-3);
+    }
+  }
+
+  // updates are seen by every view
+  SensorRegionView view;
+  ASSERT_TRUE(world.view(2, &view));
+  const PolygonPtr box = std::make_shared<Box2d>(
+      transforms[2].apply(Vec2d(5, 5)), 2, 2, 0);
+  std::vector<uint32_t> attributes;
+  std::vector<int32_t> values, ious;
+  view.findRelatedMessage(box, &attributes, &values, &ious, nullptr);
+  EXPECT_EQ(attributes, (std::vector<uint32_t>{1}));
+  ASSERT_TRUE(world.remove(1));
+  view.findRelatedMessage(box, &attributes, &values, &ious, nullptr);
+  EXPECT_TRUE(attributes.empty());
+
+  ASSERT_TRUE(world.removeSensor(2));
+  EXPECT_FALSE(world.removeSensor(2));
+  EXPECT_FALSE(world.view(2, &view));
+}